@@ -175,21 +175,40 @@ static void free_input_threads(void);
 
 static int sub2video_get_blank_frame(InputStream *ist)
 {
-    int ret;
-    AVFrame *frame = ist->sub2video.frame;
-
-    av_frame_unref(frame);
-    ist->sub2video.frame->width  = ist->dec_ctx->width  ? ist->dec_ctx->width  : ist->sub2video.w;
-    ist->sub2video.frame->height = ist->dec_ctx->height ? ist->dec_ctx->height : ist->sub2video.h;
-    ist->sub2video.frame->format = AV_PIX_FMT_RGB32;
-    if ((ret = av_frame_get_buffer(frame, 32)) < 0)
-        return ret;
-    memset(frame->data[0], 0, frame->height * frame->linesize[0]);
+    int ret, y, i;
+    AVFrame *frame;
+    int *dirty = ist->sub2video.dirty;
+    int w = ist->dec_ctx->width  ? ist->dec_ctx->width  : ist->sub2video.w;
+    int h = ist->dec_ctx->height ? ist->dec_ctx->height : ist->sub2video.h;
+
+    /* The filters usually hold the current canvas until they get the next
+       one: draw on the previous canvas and, once they have released it,
+       only erase what was drawn on it instead of clearing a new one. */
+    FFSWAP(AVFrame *, ist->sub2video.frame, ist->sub2video.spare);
+    for (i = 0; i < 4; i++)
+        FFSWAP(int, dirty[i], ist->sub2video.spare_dirty[i]);
+    frame = ist->sub2video.frame;
+
+    if (frame->data[0] && frame->width == w && frame->height == h &&
+        av_frame_is_writable(frame)) {
+        for (y = dirty[1]; y < dirty[3]; y++)
+            memset(frame->data[0] + y * frame->linesize[0] + dirty[0] * 4, 0,
+                   (dirty[2] - dirty[0]) * 4);
+    } else {
+        av_frame_unref(frame);
+        frame->width  = w;
+        frame->height = h;
+        frame->format = AV_PIX_FMT_RGB32;
+        if ((ret = av_frame_get_buffer(frame, 32)) < 0)
+            return ret;
+        memset(frame->data[0], 0, frame->height * frame->linesize[0]);
+    }
+    dirty[0] = dirty[1] = dirty[2] = dirty[3] = 0;
     return 0;
 }
 
 static void sub2video_copy_rect(uint8_t *dst, int dst_linesize, int w, int h,
-                                AVSubtitleRect *r)
+                                AVSubtitleRect *r, int dirty[4])
 {
     uint32_t *pal, *dst2;
     uint8_t *src, *src2;
@@ -205,6 +224,20 @@ static void sub2video_copy_rect(uint8_t *dst, int dst_linesize, int w, int h,
         );
         return;
     }
+    if (r->w <= 0 || r->h <= 0)
+        return;
+
+    if (dirty[2] > dirty[0]) {
+        dirty[0] = FFMIN(dirty[0], r->x);
+        dirty[1] = FFMIN(dirty[1], r->y);
+        dirty[2] = FFMAX(dirty[2], r->x + r->w);
+        dirty[3] = FFMAX(dirty[3], r->y + r->h);
+    } else {
+        dirty[0] = r->x;
+        dirty[1] = r->y;
+        dirty[2] = r->x + r->w;
+        dirty[3] = r->y + r->h;
+    }
 
     dst += r->y * dst_linesize + r->x * 4;
     src = r->data[0];
@@ -263,10 +296,12 @@ void sub2video_update(InputStream *ist, AVSubtitle *sub)
                "Impossible to get a blank canvas.\n");
         return;
     }
+    frame        = ist->sub2video.frame;
     dst          = frame->data    [0];
     dst_linesize = frame->linesize[0];
     for (i = 0; i < num_rects; i++)
-        sub2video_copy_rect(dst, dst_linesize, frame->width, frame->height, sub->rects[i]);
+        sub2video_copy_rect(dst, dst_linesize, frame->width, frame->height, sub->rects[i],
+                            ist->sub2video.dirty);
     sub2video_push_ref(ist, pts);
     ist->sub2video.end_pts = end_pts;
 }
@@ -598,6 +633,7 @@ static void ffmpeg_cleanup(int ret)
         av_dict_free(&ist->decoder_opts);
         avsubtitle_free(&ist->prev_sub.subtitle);
         av_frame_free(&ist->sub2video.frame);
+        av_frame_free(&ist->sub2video.spare);
         av_freep(&ist->filters);
         av_freep(&ist->hwaccel_device);
         av_freep(&ist->dts_buffer);
@@ -348,7 +348,10 @@ typedef struct InputStream {
         int64_t end_pts;
         AVFifoBuffer *sub_queue;    ///< queue of AVSubtitle* before filter init
         AVFrame *frame;
+        AVFrame *spare;             ///< previous canvas, reused once the filters release it
         int w, h;
+        int dirty[4];               ///< x0, y0, x1, y1 of the area drawn on frame
+        int spare_dirty[4];         ///< same for spare
     } sub2video;
 
     int dr1;
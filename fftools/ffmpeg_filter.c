@@ -736,7 +736,8 @@ static int sub2video_prepare(InputStream *ist, InputFilter *ifilter)
     ifilter->format = AV_PIX_FMT_RGB32;
 
     ist->sub2video.frame = av_frame_alloc();
-    if (!ist->sub2video.frame)
+    ist->sub2video.spare = av_frame_alloc();
+    if (!ist->sub2video.frame || !ist->sub2video.spare)
         return AVERROR(ENOMEM);
     ist->sub2video.last_pts = INT64_MIN;
     ist->sub2video.end_pts  = INT64_MIN;
@@ -66,6 +66,9 @@ static av_cold int init_dict(AVFilterContext *ctx, AVDictionary **opts)
     }
     if (aresample->sample_rate_arg > 0)
         av_opt_set_int(aresample->swr, "osr", aresample->sample_rate_arg, 0);
+    /* the generic threads option of the filter is not seen by swr */
+    if (ctx->nb_threads > 0)
+        av_opt_set_int(aresample->swr, "threads", ctx->nb_threads, 0);
 end:
     return ret;
 }
@@ -1632,6 +1632,17 @@ int ff_outlink_get_status(AVFilterLink *link)
     return link->status_in;
 }
 
+void ff_inlink_set_reserve_border(AVFilterLink *link, const int border[4])
+{
+    memcpy(link->reserve_border, border, sizeof(link->reserve_border));
+}
+
+int ff_inlink_get_reserve_border(AVFilterLink *link, int border[4])
+{
+    memcpy(border, link->reserve_border, sizeof(link->reserve_border));
+    return !!(border[0] | border[1] | border[2] | border[3]);
+}
+
 const AVClass *avfilter_get_class(void)
 {
     return &avfilter_class;
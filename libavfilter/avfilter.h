@@ -642,6 +642,13 @@ struct AVFilterLink {
      */
     int status_out;
 
+    /**
+     * Border, in pixels, that the destination filter would like to be
+     * reserved around the frames allocated for this link, so that it can
+     * grow them in place: left, top, right and bottom.
+     */
+    int reserve_border[4];
+
 #endif /* FF_INTERNAL_FIELDS */
 
 };
@@ -896,6 +903,14 @@ typedef struct AVFilterGraph {
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
 
+    /**
+     * If set, a pixel format conversion that only needs the frames to be
+     * reinterpreted, like yuvj420p to yuv420p or the luma plane of yuv420p
+     * to gray, is done by an auto-inserted aliasformat filter instead of a
+     * scale filter. Access ONLY through AVOptions.
+     */
+    int alias_formats;
+
     /**
      * Private fields
      *
@@ -56,6 +56,8 @@ static const AVOption filtergraph_options[] = {
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
+    {"alias_formats"        , "reinterpret layout-compatible pixel formats instead of converting them",
+        OFFSET(alias_formats), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, F|V },
     { NULL },
 };
 
@@ -126,6 +128,7 @@ void avfilter_graph_free(AVFilterGraph **graph)
         avfilter_free((*graph)->filters[0]);
 
     ff_graph_thread_free(*graph);
+    ff_frame_pool_list_uninit(&(*graph)->internal->frame_pools);
 
     av_freep(&(*graph)->sink_links);
 
@@ -313,6 +316,29 @@ static void sanitize_channel_layouts(void *log, AVFilterChannelLayouts *l)
     }
 }
 
+static int formats_declared(AVFilterContext *f)
+{
+    int i;
+
+    for (i = 0; i < f->nb_inputs; i++) {
+        if (!f->inputs[i]->out_formats)
+            return 0;
+        if (f->inputs[i]->type == AVMEDIA_TYPE_AUDIO &&
+            !(f->inputs[i]->out_samplerates &&
+              f->inputs[i]->out_channel_layouts))
+            return 0;
+    }
+    for (i = 0; i < f->nb_outputs; i++) {
+        if (!f->outputs[i]->in_formats)
+            return 0;
+        if (f->outputs[i]->type == AVMEDIA_TYPE_AUDIO &&
+            !(f->outputs[i]->in_samplerates &&
+              f->outputs[i]->in_channel_layouts))
+            return 0;
+    }
+    return 1;
+}
+
 static int filter_query_formats(AVFilterContext *ctx)
 {
     int ret, i;
@@ -335,6 +361,10 @@ static int filter_query_formats(AVFilterContext *ctx)
     for (i = 0; i < ctx->nb_outputs; i++)
         sanitize_channel_layouts(ctx, ctx->outputs[i]->in_channel_layouts);
 
+    /* do not build the lists of all formats if no link would take them */
+    if (formats_declared(ctx))
+        return 0;
+
     formats = ff_all_formats(type);
     if ((ret = ff_set_common_formats(ctx, formats)) < 0)
         return ret;
@@ -349,82 +379,28 @@ static int filter_query_formats(AVFilterContext *ctx)
     return 0;
 }
 
-static int formats_declared(AVFilterContext *f)
-{
-    int i;
-
-    for (i = 0; i < f->nb_inputs; i++) {
-        if (!f->inputs[i]->out_formats)
-            return 0;
-        if (f->inputs[i]->type == AVMEDIA_TYPE_AUDIO &&
-            !(f->inputs[i]->out_samplerates &&
-              f->inputs[i]->out_channel_layouts))
-            return 0;
-    }
-    for (i = 0; i < f->nb_outputs; i++) {
-        if (!f->outputs[i]->in_formats)
-            return 0;
-        if (f->outputs[i]->type == AVMEDIA_TYPE_AUDIO &&
-            !(f->outputs[i]->in_samplerates &&
-              f->outputs[i]->in_channel_layouts))
-            return 0;
-    }
-    return 1;
-}
-
-static AVFilterFormats *clone_filter_formats(AVFilterFormats *arg)
-{
-    AVFilterFormats *a = av_memdup(arg, sizeof(*arg));
-    if (a) {
-        a->refcount = 0;
-        a->refs     = NULL;
-        a->formats  = av_memdup(a->formats, sizeof(*a->formats) * a->nb_formats);
-        if (!a->formats && arg->formats)
-            av_freep(&a);
-    }
-    return a;
-}
-
-static int can_merge_formats(AVFilterFormats *a_arg,
-                             AVFilterFormats *b_arg,
-                             enum AVMediaType type,
-                             int is_sample_rate)
+/**
+ * Look for a pair of formats of a video link that can be converted by
+ * only reinterpreting the frames, in the order of preference of the
+ * destination, and write the matching aliasformat filter arguments.
+ *
+ * @return 1 if a pair was found, 0 otherwise
+ */
+static int find_alias_formats(AVFilterLink *link, char *args, int args_size)
 {
-    AVFilterFormats *a, *b, *ret;
-    if (a_arg == b_arg)
-        return 1;
-    a = clone_filter_formats(a_arg);
-    b = clone_filter_formats(b_arg);
-
-    if (!a || !b) {
-        if (a)
-            av_freep(&a->formats);
-        if (b)
-            av_freep(&b->formats);
-
-        av_freep(&a);
-        av_freep(&b);
+    AVFilterFormats *src = link->in_formats, *dst = link->out_formats;
+    int i, j;
 
-        return 0;
-    }
+    for (i = 0; i < dst->nb_formats; i++)
+        for (j = 0; j < src->nb_formats; j++)
+            if (ff_pix_fmt_can_alias(src->formats[j], dst->formats[i])) {
+                snprintf(args, args_size, "src=%s:dst=%s",
+                         av_get_pix_fmt_name(src->formats[j]),
+                         av_get_pix_fmt_name(dst->formats[i]));
+                return 1;
+            }
 
-    if (is_sample_rate) {
-        ret = ff_merge_samplerates(a, b);
-    } else {
-        ret = ff_merge_formats(a, b, type);
-    }
-    if (ret) {
-        av_freep(&ret->formats);
-        av_freep(&ret->refs);
-        av_freep(&ret);
-        return 1;
-    } else {
-        av_freep(&a->formats);
-        av_freep(&b->formats);
-        av_freep(&a);
-        av_freep(&b);
-        return 0;
-    }
+    return 0;
 }
 
 /**
@@ -440,7 +416,7 @@ static int can_merge_formats(AVFilterFormats *a_arg,
 static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
 {
     int i, j, ret;
-    int scaler_count = 0, resampler_count = 0;
+    int scaler_count = 0, resampler_count = 0, alias_count = 0;
     int count_queried = 0;        /* successful calls to query_formats() */
     int count_merged = 0;         /* successful merge of formats lists */
     int count_already_merged = 0; /* lists already merged */
@@ -473,15 +449,14 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
 
             if (link->in_formats != link->out_formats
                 && link->in_formats && link->out_formats)
-                if (!can_merge_formats(link->in_formats, link->out_formats,
-                                      link->type, 0))
+                if (!ff_can_merge_formats(link->in_formats, link->out_formats,
+                                          link->type))
                     convert_needed = 1;
             if (link->type == AVMEDIA_TYPE_AUDIO) {
                 if (link->in_samplerates != link->out_samplerates
                     && link->in_samplerates && link->out_samplerates)
-                    if (!can_merge_formats(link->in_samplerates,
-                                           link->out_samplerates,
-                                           0, 1))
+                    if (!ff_can_merge_samplerates(link->in_samplerates,
+                                                  link->out_samplerates))
                         convert_needed = 1;
             }
 
@@ -519,6 +494,7 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
                 const AVFilter *filter;
                 AVFilterLink *inlink, *outlink;
                 char inst_name[30];
+                char alias_args[64];
 
                 if (graph->disable_auto_convert) {
                     av_log(log_ctx, AV_LOG_ERROR,
@@ -531,6 +507,19 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
                 /* couldn't merge format lists. auto-insert conversion filter */
                 switch (link->type) {
                 case AVMEDIA_TYPE_VIDEO:
+                    if (graph->alias_formats &&
+                        find_alias_formats(link, alias_args, sizeof(alias_args)) &&
+                        (filter = avfilter_get_by_name("aliasformat"))) {
+                        snprintf(inst_name, sizeof(inst_name), "auto_alias_%d",
+                                 alias_count++);
+
+                        if ((ret = avfilter_graph_create_filter(&convert, filter,
+                                                                inst_name, alias_args, NULL,
+                                                                graph)) < 0)
+                            return ret;
+                        break;
+                    }
+
                     if (!(filter = avfilter_get_by_name("scale"))) {
                         av_log(log_ctx, AV_LOG_ERROR, "'scale' filter "
                                "not present, cannot convert pixel formats.\n");
@@ -817,7 +806,8 @@ static int reduce_formats_on_filter(AVFilterContext *filter)
                 /* Turn the infinite list into a singleton */
                 fmts->all_layouts = fmts->all_counts  = 0;
                 if (ff_add_channel_layout(&outlink->in_channel_layouts, fmt) < 0)
-                    ret = 1;
+                    return AVERROR(ENOMEM);
+                ret = 1;
                 break;
             }
 
@@ -23,6 +23,8 @@
 #ifndef AVFILTER_BOXBLUR_H
 #define AVFILTER_BOXBLUR_H
 
+#include <stdint.h>
+
 #include "libavutil/eval.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/mem.h"
@@ -45,4 +47,25 @@ int ff_boxblur_eval_filter_params(AVFilterLink *inlink,
                                   FilterParam *chroma_param,
                                   FilterParam *alpha_param);
 
+typedef struct BoxBlurDSPContext {
+    /**
+     * Advance the running sums of a row of columns by one line:
+     * sum[x] += (add[x] - sub[x]) * inv, dst[x] = sum[x] >> 16.
+     *
+     * @param dst the output line
+     * @param add the line entering the box
+     * @param sub the line leaving the box
+     * @param sum the running sums, scaled by inv, of the columns
+     * @param inv reciprocal of the box length, in 1/65536th
+     * @param w   number of columns
+     */
+    void (*blur_row8)(uint8_t *dst, const uint8_t *add, const uint8_t *sub,
+                      int *sum, int inv, int w);
+    void (*blur_row16)(uint16_t *dst, const uint16_t *add, const uint16_t *sub,
+                       int *sum, int inv, int w);
+} BoxBlurDSPContext;
+
+void ff_boxblur_init_dsp(BoxBlurDSPContext *dsp);
+void ff_boxblur_init_dsp_x86(BoxBlurDSPContext *dsp);
+
 #endif // AVFILTER_BOXBLUR_H
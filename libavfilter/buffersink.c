@@ -83,6 +83,20 @@ static int return_or_keep_frame(BufferSinkContext *buf, AVFrame *out, AVFrame *i
     }
 }
 
+static void check_queued_frames(AVFilterContext *ctx)
+{
+    BufferSinkContext *buf = ctx->priv;
+
+    if (buf->warning_limit &&
+        ff_framequeue_queued_frames(&ctx->inputs[0]->fifo) >= buf->warning_limit) {
+        av_log(ctx, AV_LOG_WARNING,
+               "%d buffers queued in %s, something may be wrong.\n",
+               buf->warning_limit,
+               (char *)av_x_if_null(ctx->name, ctx->filter->name));
+        buf->warning_limit *= 10;
+    }
+}
+
 static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, int samples)
 {
     BufferSinkContext *buf = ctx->priv;
@@ -95,6 +109,13 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
         return return_or_keep_frame(buf, frame, buf->peeked_frame, flags);
 
     while (1) {
+        /* the queue is examined right here, so activating the sink for each
+         * frame it receives would only cost another run of the graph */
+        if (ctx->ready) {
+            ctx->ready = 0;
+            check_queued_frames(ctx);
+        }
+
         ret = samples ? ff_inlink_consume_samples(inlink, samples, samples, &cur_frame) :
                         ff_inlink_consume_frame(inlink, &cur_frame);
         if (ret < 0) {
@@ -127,6 +148,36 @@ int attribute_align_arg av_buffersink_get_samples(AVFilterContext *ctx,
     return get_frame_internal(ctx, frame, 0, nb_samples);
 }
 
+int attribute_align_arg av_buffersink_get_frames(AVFilterContext *ctx, AVFrame **frames,
+                                                 int nb_frames, int flags)
+{
+    AVFilterLink *inlink = ctx->inputs[0];
+    int samples = inlink->min_samples;
+    int i, ret;
+
+    if (flags & AV_BUFFERSINK_FLAG_PEEK)
+        return AVERROR(EINVAL);
+    if (nb_frames <= 0)
+        return 0;
+
+    /* only the first frame may require running the graph */
+    if ((ret = get_frame_internal(ctx, frames[0], flags, samples)) < 0)
+        return ret;
+
+    for (i = 1; i < nb_frames; i++) {
+        AVFrame *cur_frame;
+
+        ret = samples ? ff_inlink_consume_samples(inlink, samples, samples, &cur_frame) :
+                        ff_inlink_consume_frame(inlink, &cur_frame);
+        if (ret <= 0)
+            break;
+        av_frame_move_ref(frames[i], cur_frame);
+        av_frame_free(&cur_frame);
+    }
+
+    return i;
+}
+
 AVBufferSinkParams *av_buffersink_params_alloc(void)
 {
     static const int pixel_fmts[] = { AV_PIX_FMT_NONE };
@@ -157,16 +208,7 @@ static av_cold int common_init(AVFilterContext *ctx)
 
 static int activate(AVFilterContext *ctx)
 {
-    BufferSinkContext *buf = ctx->priv;
-
-    if (buf->warning_limit &&
-        ff_framequeue_queued_frames(&ctx->inputs[0]->fifo) >= buf->warning_limit) {
-        av_log(ctx, AV_LOG_WARNING,
-               "%d buffers queued in %s, something may be wrong.\n",
-               buf->warning_limit,
-               (char *)av_x_if_null(ctx->name, ctx->filter->name));
-        buf->warning_limit *= 10;
-    }
+    check_queued_frames(ctx);
 
     /* The frame is queued, the rest is up to get_frame_internal */
     return 0;
@@ -158,6 +158,30 @@ int av_buffersink_get_frame(AVFilterContext *ctx, AVFrame *frame);
  */
 int av_buffersink_get_samples(AVFilterContext *ctx, AVFrame *frame, int nb_samples);
 
+/**
+ * Get several frames with filtered data from sink.
+ *
+ * The graph is run only until the first frame is available, then the
+ * frames already queued on the sink are returned along with it, without
+ * running the graph again. If a frame size was set with
+ * av_buffersink_set_frame_size(), the audio frames returned have that
+ * number of samples, except at the end of stream.
+ *
+ * @param ctx        pointer to a buffersink or abuffersink filter context.
+ * @param frames     array of allocated frames that will be filled with data.
+ *                   The data must be freed using av_frame_unref() / av_frame_free()
+ * @param nb_frames  number of frames in the array
+ * @param flags      a combination of AV_BUFFERSINK_FLAG_* flags, except
+ *                   AV_BUFFERSINK_FLAG_PEEK
+ *
+ * @return
+ *         - the number of frames returned, at least 1 if nb_frames is
+ *           not 0.
+ *         - A negative AVERROR code with the same meaning as for
+ *           av_buffersink_get_frame() if no frame was returned.
+ */
+int av_buffersink_get_frames(AVFilterContext *ctx, AVFrame **frames, int nb_frames, int flags);
+
 /**
  * @}
  */
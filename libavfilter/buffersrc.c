@@ -266,6 +266,28 @@ static int av_buffersrc_add_frame_internal(AVFilterContext *ctx,
     return 0;
 }
 
+int attribute_align_arg av_buffersrc_add_frames(AVFilterContext *ctx, AVFrame **frames,
+                                                int nb_frames, int flags)
+{
+    int i, ret = 0;
+
+    /* queue all the frames, then run the graph only once for all of them */
+    for (i = 0; i < nb_frames; i++) {
+        ret = av_buffersrc_add_frame_flags(ctx, frames[i],
+                                           flags & ~AV_BUFFERSRC_FLAG_PUSH);
+        if (ret < 0)
+            break;
+    }
+
+    if (i && (flags & AV_BUFFERSRC_FLAG_PUSH)) {
+        int err = push_frame(ctx->graph);
+        if (err < 0)
+            return err;
+    }
+
+    return i ? i : ret;
+}
+
 int av_buffersrc_close(AVFilterContext *ctx, int64_t pts, unsigned flags)
 {
     BufferSourceContext *s = ctx->priv;
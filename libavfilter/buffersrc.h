@@ -193,6 +193,28 @@ av_warn_unused_result
 int av_buffersrc_add_frame_flags(AVFilterContext *buffer_src,
                                  AVFrame *frame, int flags);
 
+/**
+ * Add several frames to the buffer source.
+ *
+ * This is equivalent to calling av_buffersrc_add_frame_flags() on each
+ * frame in turn, except that with AV_BUFFERSRC_FLAG_PUSH the graph is run
+ * only once, after all the frames have been queued, which is cheaper for
+ * many small frames.
+ *
+ * @param buffer_src  pointer to a buffer source context
+ * @param frames      array of frames to be added, with the same semantics
+ *                    as the frame parameter of av_buffersrc_add_frame_flags()
+ * @param nb_frames   number of frames in the array
+ * @param flags       a combination of AV_BUFFERSRC_FLAG_*
+ * @return            the number of frames added, which is less than
+ *                    nb_frames if adding the next frame failed, or a
+ *                    negative AVERROR code if no frame could be added or
+ *                    running the graph failed
+ */
+av_warn_unused_result
+int av_buffersrc_add_frames(AVFilterContext *buffer_src, AVFrame **frames,
+                            int nb_frames, int flags);
+
 /**
  * Close the buffer source after EOF.
  *
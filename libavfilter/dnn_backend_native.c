@@ -25,6 +25,81 @@
 
 #include "dnn_backend_native.h"
 #include "libavutil/avassert.h"
+#include "libavutil/mem.h"
+
+static void convolve_slice(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
+
+// Reorders the kernel of a CONV layer so that the weights of all output
+// channels for one input channel and one kernel tap are contiguous.
+static int pack_kernel(ConvolutionalParams *conv_params)
+{
+    int filter_linesize = conv_params->kernel_size * conv_params->input_num;
+    int filter_size = conv_params->kernel_size * filter_linesize;
+    int packed_output_num = FFALIGN(conv_params->output_num, 16);
+    float *packed_kernel;
+
+    packed_kernel = av_mallocz_array(conv_params->input_num * conv_params->kernel_size * conv_params->kernel_size,
+                                     packed_output_num * sizeof(float));
+    if (!packed_kernel)
+        return AVERROR(ENOMEM);
+
+    for (int ch = 0; ch < conv_params->input_num; ++ch)
+        for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y)
+            for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x)
+                for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter)
+                    packed_kernel[((ch * conv_params->kernel_size + kernel_y) * conv_params->kernel_size + kernel_x) * packed_output_num + n_filter] =
+                        conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize + kernel_x * conv_params->input_num + ch];
+
+    conv_params->packed_kernel = packed_kernel;
+    conv_params->packed_output_num = packed_output_num;
+
+    return 0;
+}
+
+// Sets up the slice threads and their scratch buffers for the CONV layers.
+static int init_slice_threads(ConvolutionalNetwork *network, int nb_threads)
+{
+    int max_taps = 1, max_outputs = 16, ret, i;
+    int32_t layer;
+
+    for (layer = 1; layer < network->layers_num; ++layer){
+        if (network->layers[layer].type == CONV){
+            ConvolutionalParams *conv_params = (ConvolutionalParams *)network->layers[layer].params;
+            ret = pack_kernel(conv_params);
+            if (ret < 0)
+                return ret;
+            max_taps = FFMAX(max_taps, conv_params->kernel_size * conv_params->kernel_size);
+            max_outputs = FFMAX(max_outputs, conv_params->packed_output_num);
+        }
+    }
+
+    network->fdsp = avpriv_float_dsp_alloc(0);
+    if (!network->fdsp)
+        return AVERROR(ENOMEM);
+
+    if (nb_threads == 1)
+        ret = 1;
+    else
+        ret = avpriv_slicethread_create(&network->slicethread, network, convolve_slice, NULL, nb_threads);
+    if (ret == AVERROR(ENOSYS))
+        ret = 1;
+    else if (ret < 0)
+        return ret;
+    network->nb_threads = ret;
+
+    network->acc = av_mallocz_array(network->nb_threads, sizeof(*network->acc));
+    network->tap_offset = av_mallocz_array(network->nb_threads, sizeof(*network->tap_offset));
+    if (!network->acc || !network->tap_offset)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < network->nb_threads; ++i){
+        network->acc[i] = av_mallocz_array(max_outputs, sizeof(**network->acc));
+        network->tap_offset[i] = av_malloc_array(max_taps, sizeof(**network->tap_offset));
+        if (!network->acc[i] || !network->tap_offset[i])
+            return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
 
 static DNNReturnType set_input_output_native(void *model, DNNInputData *input, const char *input_name, const char **output_names, uint32_t nb_output)
 {
@@ -100,7 +175,7 @@ static DNNReturnType set_input_output_native(void *model, DNNInputData *input, c
 // layers_num,layer_type,layer_parameterss,layer_type,layer_parameters...
 // For CONV layer: activation_function, input_num, output_num, kernel_size, kernel, biases
 // For DEPTH_TO_SPACE layer: block_size
-DNNModel *ff_dnn_load_model_native(const char *model_filename)
+DNNModel *ff_dnn_load_model_native(const char *model_filename, int nb_threads)
 {
     DNNModel *model = NULL;
     ConvolutionalNetwork *network = NULL;
@@ -122,7 +197,7 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
     }
     file_size = avio_size(model_file_context);
 
-    network = av_malloc(sizeof(ConvolutionalNetwork));
+    network = av_mallocz(sizeof(ConvolutionalNetwork));
     if (!network){
         avio_closep(&model_file_context);
         av_freep(&model);
@@ -158,7 +233,7 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
         dnn_size += 4;
         switch (layer_type){
         case CONV:
-            conv_params = av_malloc(sizeof(ConvolutionalParams));
+            conv_params = av_mallocz(sizeof(ConvolutionalParams));
             if (!conv_params){
                 avio_closep(&model_file_context);
                 ff_dnn_free_model_native(&model);
@@ -216,7 +291,7 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
 
     avio_closep(&model_file_context);
 
-    if (dnn_size != file_size){
+    if (dnn_size != file_size || init_slice_threads(network, nb_threads) < 0){
         ff_dnn_free_model_native(&model);
         return NULL;
     }
@@ -228,54 +303,83 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
 
 #define CLAMP_TO_EDGE(x, w) ((x) < 0 ? 0 : ((x) >= (w) ? (w - 1) : (x)))
 
-static void convolve(const float *input, float *output, const ConvolutionalParams *conv_params, int width, int height)
+typedef struct ConvolveThreadData {
+    const float *input;
+    float *output;
+    const ConvolutionalParams *conv_params;
+    int width, height;
+} ConvolveThreadData;
+
+// The output pixels are computed as in a direct convolution, but the inner
+// loop runs over all output channels with vector_fmac_scalar(), the
+// contributions are accumulated in the same order as a scalar loop over the
+// input channels and kernel taps.
+static void convolve_slice(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
 {
+    ConvolutionalNetwork *network = priv;
+    const ConvolveThreadData *td = network->thread_data;
+    const ConvolutionalParams *conv_params = td->conv_params;
+    const float *input = td->input;
+    int width = td->width;
+    int height = td->height;
     int radius = conv_params->kernel_size >> 1;
+    int nb_taps = conv_params->kernel_size * conv_params->kernel_size;
     int src_linesize = width * conv_params->input_num;
-    int filter_linesize = conv_params->kernel_size * conv_params->input_num;
-    int filter_size = conv_params->kernel_size * filter_linesize;
     int pad_size = (conv_params->padding_method == VALID) ? (conv_params->kernel_size - 1) / 2 * conv_params->dilation : 0;
-
-    for (int y = pad_size; y < height - pad_size; ++y) {
+    int out_width = width - 2 * pad_size;
+    int out_height = height - 2 * pad_size;
+    int slice_start = pad_size + (out_height * jobnr) / nb_jobs;
+    int slice_end = pad_size + (out_height * (jobnr+1)) / nb_jobs;
+    float *output = td->output + (slice_start - pad_size) * out_width * conv_params->output_num;
+    float *acc = network->acc[threadnr];
+    int *tap_offset = network->tap_offset[threadnr];
+
+    for (int y = slice_start; y < slice_end; ++y) {
         for (int x = pad_size; x < width - pad_size; ++x) {
-            for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter) {
-                output[n_filter] = conv_params->biases[n_filter];
-
-                for (int ch = 0; ch < conv_params->input_num; ++ch) {
-                    for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
-                        for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
-                            float input_pel;
-                            if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
-                                int y_pos = CLAMP_TO_EDGE(y + (kernel_y - radius) * conv_params->dilation, height);
-                                int x_pos = CLAMP_TO_EDGE(x + (kernel_x - radius) * conv_params->dilation, width);
-                                input_pel = input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            } else {
-                                int y_pos = y + (kernel_y - radius) * conv_params->dilation;
-                                int x_pos = x + (kernel_x - radius) * conv_params->dilation;
-                                input_pel = (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) ? 0.0 :
-                                                   input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            }
-
-
-                            output[n_filter] += input_pel * conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
-                                                                                kernel_x * conv_params->input_num + ch];
-                        }
+            const float *kernel = conv_params->packed_kernel;
+
+            // input offsets of the kernel taps, -1 for the taps in the zero padding
+            for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
+                for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
+                    int y_pos = y + (kernel_y - radius) * conv_params->dilation;
+                    int x_pos = x + (kernel_x - radius) * conv_params->dilation;
+                    int *offset = &tap_offset[kernel_y * conv_params->kernel_size + kernel_x];
+                    if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
+                        y_pos = CLAMP_TO_EDGE(y_pos, height);
+                        x_pos = CLAMP_TO_EDGE(x_pos, width);
+                        *offset = y_pos * src_linesize + x_pos * conv_params->input_num;
+                    } else {
+                        *offset = (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) ? -1 :
+                                  y_pos * src_linesize + x_pos * conv_params->input_num;
                     }
                 }
+            }
+
+            memcpy(acc, conv_params->biases, conv_params->output_num * sizeof(*acc));
+            for (int ch = 0; ch < conv_params->input_num; ++ch) {
+                for (int tap = 0; tap < nb_taps; ++tap) {
+                    float input_pel = tap_offset[tap] < 0 ? 0.0 : input[tap_offset[tap] + ch];
+                    network->fdsp->vector_fmac_scalar(acc, kernel, input_pel, conv_params->packed_output_num);
+                    kernel += conv_params->packed_output_num;
+                }
+            }
+
+            for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter) {
                 switch (conv_params->activation){
                 case RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0);
+                    output[n_filter] = FFMAX(acc[n_filter], 0.0);
                     break;
                 case TANH:
-                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * output[n_filter])) - 1.0f;
+                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * acc[n_filter])) - 1.0f;
                     break;
                 case SIGMOID:
-                    output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
+                    output[n_filter] = 1.0f / (1.0f + exp(-acc[n_filter]));
                     break;
                 case NONE:
+                    output[n_filter] = acc[n_filter];
                     break;
                 case LEAKY_RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0) + 0.2 * FFMIN(output[n_filter], 0.0);
+                    output[n_filter] = FFMAX(acc[n_filter], 0.0) + 0.2 * FFMIN(acc[n_filter], 0.0);
                 }
             }
             output += conv_params->output_num;
@@ -283,6 +387,23 @@ static void convolve(const float *input, float *output, const ConvolutionalParam
     }
 }
 
+static void convolve(ConvolutionalNetwork *network, const float *input, float *output,
+                     const ConvolutionalParams *conv_params, int width, int height)
+{
+    ConvolveThreadData td = { input, output, conv_params, width, height };
+    int pad_size = (conv_params->padding_method == VALID) ? (conv_params->kernel_size - 1) / 2 * conv_params->dilation : 0;
+    int nb_jobs = FFMIN(height - 2 * pad_size, network->nb_threads);
+
+    if (nb_jobs <= 0)
+        return;
+
+    network->thread_data = &td;
+    if (network->slicethread)
+        avpriv_slicethread_execute(network->slicethread, nb_jobs, 0);
+    else
+        convolve_slice(network, 0, 0, 1, 1);
+}
+
 static void depth_to_space(const float *input, float *output, int block_size, int width, int height, int channels)
 {
     int y, x, by, bx, ch;
@@ -332,7 +453,7 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *output
         switch (network->layers[layer].type){
         case CONV:
             conv_params = (ConvolutionalParams *)network->layers[layer].params;
-            convolve(network->layers[layer - 1].output, network->layers[layer].output, conv_params, cur_width, cur_height);
+            convolve(network, network->layers[layer - 1].output, network->layers[layer].output, conv_params, cur_width, cur_height);
             cur_channels = conv_params->output_num;
             if (conv_params->padding_method == VALID) {
                 int pad_size = (conv_params->kernel_size - 1) * conv_params->dilation;
@@ -369,6 +490,7 @@ void ff_dnn_free_model_native(DNNModel **model)
     ConvolutionalNetwork *network;
     ConvolutionalParams *conv_params;
     int32_t layer;
+    int i;
 
     if (*model)
     {
@@ -379,10 +501,21 @@ void ff_dnn_free_model_native(DNNModel **model)
                 conv_params = (ConvolutionalParams *)network->layers[layer].params;
                 av_freep(&conv_params->kernel);
                 av_freep(&conv_params->biases);
+                av_freep(&conv_params->packed_kernel);
             }
             av_freep(&network->layers[layer].params);
         }
         av_freep(&network->layers);
+        avpriv_slicethread_free(&network->slicethread);
+        for (i = 0; i < network->nb_threads; ++i){
+            if (network->acc)
+                av_freep(&network->acc[i]);
+            if (network->tap_offset)
+                av_freep(&network->tap_offset[i]);
+        }
+        av_freep(&network->acc);
+        av_freep(&network->tap_offset);
+        av_freep(&network->fdsp);
         av_freep(&network);
         av_freep(model);
     }
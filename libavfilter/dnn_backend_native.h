@@ -29,6 +29,8 @@
 
 #include "dnn_interface.h"
 #include "libavformat/avio.h"
+#include "libavutil/float_dsp.h"
+#include "libavutil/slicethread.h"
 
 typedef enum {INPUT, CONV, DEPTH_TO_SPACE} DNNLayerType;
 
@@ -49,6 +51,10 @@ typedef struct ConvolutionalParams{
     int32_t dilation;
     float *kernel;
     float *biases;
+    // kernel reordered as [input_num][kernel_size][kernel_size][packed_output_num],
+    // the output channels are padded with zeros to a multiple of 16
+    float *packed_kernel;
+    int32_t packed_output_num;
 } ConvolutionalParams;
 
 typedef struct InputParams{
@@ -63,9 +69,16 @@ typedef struct DepthToSpaceParams{
 typedef struct ConvolutionalNetwork{
     Layer *layers;
     int32_t layers_num;
+    AVSliceThread *slicethread;
+    int nb_threads;
+    AVFloatDSPContext *fdsp;
+    // per thread output accumulators and input offsets of the kernel taps
+    float **acc;
+    int **tap_offset;
+    void *thread_data;
 } ConvolutionalNetwork;
 
-DNNModel *ff_dnn_load_model_native(const char *model_filename);
+DNNModel *ff_dnn_load_model_native(const char *model_filename, int nb_threads);
 
 DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *outputs, uint32_t nb_output);
 
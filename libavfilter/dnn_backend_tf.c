@@ -423,7 +423,7 @@ static DNNReturnType load_native_model(TFModel *tf_model, const char *model_file
     DNNModel *native_model = NULL;
     ConvolutionalNetwork *conv_network;
 
-    native_model = ff_dnn_load_model_native(model_filename);
+    native_model = ff_dnn_load_model_native(model_filename, 1);
     if (!native_model){
         return DNN_ERROR;
     }
@@ -501,7 +501,7 @@ static DNNReturnType load_native_model(TFModel *tf_model, const char *model_file
     return DNN_SUCCESS;
 }
 
-DNNModel *ff_dnn_load_model_tf(const char *model_filename)
+DNNModel *ff_dnn_load_model_tf(const char *model_filename, int nb_threads)
 {
     DNNModel *model = NULL;
     TFModel *tf_model = NULL;
@@ -48,6 +48,7 @@
 #include <math.h>               /* You may have to define _USE_MATH_DEFINES if you use MSVC */
 
 #include "libavutil/common.h"
+#include "libavutil/internal.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
 
@@ -78,12 +79,16 @@ struct FFEBUR128StateInternal {
     int *channel_map;
     /** How many samples fit in 100ms (rounded). */
     unsigned long samples_in_100ms;
+    /** Energy of each 100ms block of audio_data, one value per channel. */
+    double *block_energies;
     /** BS.1770 filter coefficients (nominator). */
     double b[5];
     /** BS.1770 filter coefficients (denominator). */
     double a[5];
     /** BS.1770 filter state. */
     double v[5][5];
+    /** SIMD version of the filter. */
+    FFEBUR128DSPContext dsp;
     /** Histograms, used to calculate LRA. */
     unsigned long *block_energy_histogram;
     unsigned long *short_term_block_energy_histogram;
@@ -256,11 +261,17 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
                                     st->channels * sizeof(double));
     CHECK_ERROR(!st->d->audio_data, 0, free_sample_peak)
 
+    st->d->block_energies =
+        (double *) av_mallocz_array(st->d->audio_data_frames / st->d->samples_in_100ms,
+                                    st->channels * sizeof(double));
+    CHECK_ERROR(!st->d->block_energies, 0, free_audio_data)
+
     ebur128_init_filter(st);
+    ff_ebur128_init_dsp(&st->d->dsp);
 
     st->d->block_energy_histogram =
         av_mallocz(1000 * sizeof(unsigned long));
-    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_audio_data)
+    CHECK_ERROR(!st->d->block_energy_histogram, 0, free_block_energies)
     st->d->short_term_block_energy_histogram =
         av_mallocz(1000 * sizeof(unsigned long));
     CHECK_ERROR(!st->d->short_term_block_energy_histogram, 0,
@@ -285,6 +296,8 @@ free_short_term_block_energy_histogram:
     av_free(st->d->short_term_block_energy_histogram);
 free_block_energy_histogram:
     av_free(st->d->block_energy_histogram);
+free_block_energies:
+    av_free(st->d->block_energies);
 free_audio_data:
     av_free(st->d->audio_data);
 free_sample_peak:
@@ -304,6 +317,7 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     av_free((*st)->d->block_energy_histogram);
     av_free((*st)->d->short_term_block_energy_histogram);
     av_free((*st)->d->audio_data);
+    av_free((*st)->d->block_energies);
     av_free((*st)->d->channel_map);
     av_free((*st)->d->sample_peak);
     av_free((*st)->d->data_ptrs);
@@ -312,12 +326,112 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     *st = NULL;
 }
 
+/* Maximum number of channels filtered together, which keeps their filter
+ * states in registers and interleaves their independent recursions. */
+#define MAX_LANES FF_EBUR128_LANES
+
+/* Number of samples per channel filtered by each call to the SIMD filter */
+#define SIMD_BLOCK 64
+
+av_cold void ff_ebur128_init_dsp(FFEBUR128DSPContext *dsp)
+{
+    dsp->filter_lanes = NULL;
+
+    if (ARCH_X86)
+        ff_ebur128_init_dsp_x86(dsp);
+}
+
 #define EBUR128_FILTER(type, scaling_factor)                                       \
+static av_always_inline void ebur128_filter_lanes_##type(FFEBUR128State* st,       \
+                                  const type** srcs, size_t src_index,             \
+                                  size_t frames, int stride,                       \
+                                  const int *chans, const int *cis, const int n) { \
+    double* audio_data = st->d->audio_data + st->d->audio_data_index;              \
+    const double a1 = st->d->a[1], a2 = st->d->a[2];                               \
+    const double a3 = st->d->a[3], a4 = st->d->a[4];                               \
+    const double b0 = st->d->b[0], b1 = st->d->b[1], b2 = st->d->b[2];             \
+    const double b3 = st->d->b[3], b4 = st->d->b[4];                               \
+    const type *src[MAX_LANES];                                                    \
+    double v[MAX_LANES][5];                                                        \
+    size_t i;                                                                      \
+    int l, j;                                                                      \
+                                                                                   \
+    for (l = 0; l < n; l++) {                                                      \
+        src[l] = srcs[chans[l]] + src_index;                                       \
+        for (j = 1; j < 5; j++)                                                    \
+            v[l][j] = st->d->v[cis[l]][j];                                         \
+    }                                                                              \
+    for (i = 0; i < frames; ++i) {                                                 \
+        for (l = 0; l < n; l++) {                                                  \
+            v[l][0] = (double) (src[l][i * stride] / scaling_factor)               \
+                    - a1 * v[l][1]                                                 \
+                    - a2 * v[l][2]                                                 \
+                    - a3 * v[l][3]                                                 \
+                    - a4 * v[l][4];                                                \
+            audio_data[i * st->channels + chans[l]] =                              \
+                      b0 * v[l][0]                                                 \
+                    + b1 * v[l][1]                                                 \
+                    + b2 * v[l][2]                                                 \
+                    + b3 * v[l][3]                                                 \
+                    + b4 * v[l][4];                                                \
+            v[l][4] = v[l][3];                                                     \
+            v[l][3] = v[l][2];                                                     \
+            v[l][2] = v[l][1];                                                     \
+            v[l][1] = v[l][0];                                                     \
+        }                                                                          \
+    }                                                                              \
+    for (l = 0; l < n; l++)                                                        \
+        for (j = 1; j < 5; j++)                                                    \
+            st->d->v[cis[l]][j] = fabs(v[l][j]) < DBL_MIN ? 0.0 : v[l][j];         \
+}                                                                                  \
+                                                                                   \
+/* the channels are gathered into the lanes of a buffer for filter_lanes */       \
+static void ebur128_filter_simd_##type(FFEBUR128State* st,                         \
+                                       const type** srcs, size_t src_index,        \
+                                       size_t frames, int stride,                  \
+                                       const int *chans, const int *cis) {         \
+    LOCAL_ALIGNED_32(double, buf, [SIMD_BLOCK * MAX_LANES]);                       \
+    LOCAL_ALIGNED_32(double, v, [4 * MAX_LANES]);                                  \
+    double* audio_data = st->d->audio_data + st->d->audio_data_index;              \
+    const type *src[MAX_LANES];                                                    \
+    double c[9];                                                                   \
+    size_t i, k, len;                                                              \
+    int l, j;                                                                      \
+                                                                                   \
+    for (j = 0; j < 5; j++)                                                        \
+        c[j] = st->d->b[j];                                                        \
+    for (j = 1; j < 5; j++)                                                        \
+        c[4 + j] = st->d->a[j];                                                    \
+    for (l = 0; l < MAX_LANES; l++) {                                              \
+        src[l] = srcs[chans[l]] + src_index;                                       \
+        for (j = 1; j < 5; j++)                                                    \
+            v[(j - 1) * MAX_LANES + l] = st->d->v[cis[l]][j];                      \
+    }                                                                              \
+    for (i = 0; i < frames; i += len) {                                            \
+        len = FFMIN(frames - i, SIMD_BLOCK);                                       \
+        for (k = 0; k < len; k++)                                                  \
+            for (l = 0; l < MAX_LANES; l++)                                        \
+                buf[k * MAX_LANES + l] =                                           \
+                    (double) (src[l][(i + k) * stride] / scaling_factor);          \
+        st->d->dsp.filter_lanes(buf, buf, v, c, len);                              \
+        for (k = 0; k < len; k++)                                                  \
+            for (l = 0; l < MAX_LANES; l++)                                        \
+                audio_data[(i + k) * st->channels + chans[l]] =                    \
+                    buf[k * MAX_LANES + l];                                        \
+    }                                                                              \
+    for (l = 0; l < MAX_LANES; l++)                                                \
+        for (j = 1; j < 5; j++) {                                                  \
+            double s = v[(j - 1) * MAX_LANES + l];                                 \
+            st->d->v[cis[l]][j] = fabs(s) < DBL_MIN ? 0.0 : s;                     \
+        }                                                                          \
+}                                                                                  \
+                                                                                   \
 static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
                                   size_t src_index, size_t frames,                 \
                                   int stride) {                                    \
-    double* audio_data = st->d->audio_data + st->d->audio_data_index;              \
+    int chans[MAX_LANES], cis[MAX_LANES];                                          \
     size_t i, c;                                                                   \
+    int n = 0, l;                                                                  \
                                                                                    \
     if ((st->mode & FF_EBUR128_MODE_SAMPLE_PEAK) == FF_EBUR128_MODE_SAMPLE_PEAK) { \
         for (c = 0; c < st->channels; ++c) {                                       \
@@ -334,31 +448,36 @@ static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,
             if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;          \
         }                                                                          \
     }                                                                              \
-    for (c = 0; c < st->channels; ++c) {                                           \
-        int ci = st->d->channel_map[c] - 1;                                        \
-        if (ci < 0) continue;                                                      \
-        else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
-        for (i = 0; i < frames; ++i) {                                             \
-            st->d->v[ci][0] = (double) (srcs[c][src_index + i * stride] / scaling_factor) \
-                         - st->d->a[1] * st->d->v[ci][1]                           \
-                         - st->d->a[2] * st->d->v[ci][2]                           \
-                         - st->d->a[3] * st->d->v[ci][3]                           \
-                         - st->d->a[4] * st->d->v[ci][4];                          \
-            audio_data[i * st->channels + c] =                                     \
-                           st->d->b[0] * st->d->v[ci][0]                           \
-                         + st->d->b[1] * st->d->v[ci][1]                           \
-                         + st->d->b[2] * st->d->v[ci][2]                           \
-                         + st->d->b[3] * st->d->v[ci][3]                           \
-                         + st->d->b[4] * st->d->v[ci][4];                          \
-            st->d->v[ci][4] = st->d->v[ci][3];                                     \
-            st->d->v[ci][3] = st->d->v[ci][2];                                     \
-            st->d->v[ci][2] = st->d->v[ci][1];                                     \
-            st->d->v[ci][1] = st->d->v[ci][0];                                     \
+    for (c = 0; c <= st->channels; ++c) {                                          \
+        int ci = -1;                                                               \
+        if (c < st->channels) {                                                    \
+            ci = st->d->channel_map[c] - 1;                                        \
+            if (ci < 0) continue;                                                  \
+            else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */        \
+            /* channels sharing a filter state must be filtered in turn */         \
+            for (l = 0; l < n && cis[l] != ci; l++);                               \
+            if (l == n && n < MAX_LANES) {                                         \
+                chans[n] = c;                                                      \
+                cis[n++] = ci;                                                     \
+                continue;                                                          \
+            }                                                                      \
+        }                                                                          \
+        switch (n) {                                                               \
+        case 1: ebur128_filter_lanes_##type(st, srcs, src_index, frames, stride, chans, cis, 1); break; \
+        case 2: ebur128_filter_lanes_##type(st, srcs, src_index, frames, stride, chans, cis, 2); break; \
+        case 3: ebur128_filter_lanes_##type(st, srcs, src_index, frames, stride, chans, cis, 3); break; \
+        case 4:                                                                    \
+            if (st->d->dsp.filter_lanes)                                           \
+                ebur128_filter_simd_##type(st, srcs, src_index, frames, stride, chans, cis); \
+            else                                                                   \
+                ebur128_filter_lanes_##type(st, srcs, src_index, frames, stride, chans, cis, 4); \
+            break;                                                                 \
+        }                                                                          \
+        n = 0;                                                                     \
+        if (ci >= 0) {                                                             \
+            chans[n] = c;                                                          \
+            cis[n++] = ci;                                                         \
         }                                                                          \
-        st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-        st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-        st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-        st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
     }                                                                              \
 }
 EBUR128_FILTER(short, -((double)SHRT_MIN))
@@ -389,10 +508,36 @@ static size_t find_histogram_index(double energy)
     return index_min;
 }
 
+/* Compute the energies of the 100ms blocks completed by the filtered frames
+ * [start, end) of audio_data, so that the gating blocks and the short term
+ * loudness, which always end on such a boundary, are computed by adding a few
+ * partial sums instead of going through the whole interval every time. */
+static void ebur128_calc_block_energies(FFEBUR128State * st,
+                                        size_t start, size_t end)
+{
+    const size_t n = st->d->samples_in_100ms;
+    size_t b, i, c;
+
+    for (b = start / n; (b + 1) * n <= end; ++b) {
+        double *energy = st->d->block_energies + b * st->channels;
+        const double *x = st->d->audio_data + b * n * st->channels;
+
+        for (c = 0; c < st->channels; ++c)
+            energy[c] = 0.0;
+        for (i = 0; i < n; ++i, x += st->channels)
+            for (c = 0; c < st->channels; ++c)
+                energy[c] += x[c] * x[c];
+    }
+}
+
 static void ebur128_calc_gating_block(FFEBUR128State * st,
                                       size_t frames_per_block,
                                       double *optional_output)
 {
+    const size_t n = st->d->samples_in_100ms;
+    const size_t nb_blocks = st->d->audio_data_frames / n;
+    const size_t index = st->d->audio_data_index / st->channels;
+    const int use_blocks = !(frames_per_block % n) && !(index % n);
     size_t i, c;
     double sum = 0.0;
     double channel_sum;
@@ -400,7 +545,13 @@ static void ebur128_calc_gating_block(FFEBUR128State * st,
         if (st->d->channel_map[c] == FF_EBUR128_UNUSED)
             continue;
         channel_sum = 0.0;
-        if (st->d->audio_data_index < frames_per_block * st->channels) {
+        if (use_blocks) {
+            size_t b = index / n;
+            for (i = 0; i < frames_per_block / n; ++i) {
+                b = b ? b - 1 : nb_blocks - 1;
+                channel_sum += st->d->block_energies[b * st->channels + c];
+            }
+        } else if (st->d->audio_data_index < frames_per_block * st->channels) {
             for (i = 0; i < st->d->audio_data_index / st->channels; ++i) {
                 channel_sum += st->d->audio_data[i * st->channels + c] *
                     st->d->audio_data[i * st->channels + c];
@@ -463,11 +614,13 @@ void ff_ebur128_add_frames_planar_##type(FFEBUR128State* st, const type** srcs,
                                  size_t frames, int stride) {                          \
     size_t src_index = 0;                                                              \
     while (frames > 0) {                                                               \
+        size_t start = st->d->audio_data_index / st->channels;                         \
         if (frames >= st->d->needed_frames) {                                          \
             ebur128_filter_##type(st, srcs, src_index, st->d->needed_frames, stride);  \
             src_index += st->d->needed_frames * stride;                                \
             frames -= st->d->needed_frames;                                            \
             st->d->audio_data_index += st->d->needed_frames * st->channels;            \
+            ebur128_calc_block_energies(st, start, start + st->d->needed_frames);      \
             /* calculate the new gating block */                                       \
             if ((st->mode & FF_EBUR128_MODE_I) == FF_EBUR128_MODE_I) {                 \
                 ebur128_calc_gating_block(st, st->d->samples_in_100ms * 4, NULL);      \
@@ -493,6 +646,7 @@ void ff_ebur128_add_frames_planar_##type(FFEBUR128State* st, const type** srcs,
         } else {                                                                       \
             ebur128_filter_##type(st, srcs, src_index, frames, stride);                \
             st->d->audio_data_index += frames * st->channels;                          \
+            ebur128_calc_block_energies(st, start, start + frames);                    \
             if ((st->mode & FF_EBUR128_MODE_LRA) == FF_EBUR128_MODE_LRA) {             \
                 st->d->short_term_frame_counter += frames;                             \
             }                                                                          \
@@ -293,4 +293,28 @@ int ff_ebur128_sample_peak(FFEBUR128State * st,
  */
 int ff_ebur128_relative_threshold(FFEBUR128State * st, double *out);
 
+/** Number of channels filtered at once by FFEBUR128DSPContext.filter_lanes */
+#define FF_EBUR128_LANES 4
+
+typedef struct FFEBUR128DSPContext {
+    /**
+     * Apply the K-weighting filter to FF_EBUR128_LANES channels, with the
+     * same operations in the same order as the C code.
+     * Left NULL if there is no SIMD version, the C code then filters the
+     * channels directly.
+     *
+     * @param dst    the filtered samples, the channels interleaved
+     * @param src    the input samples, the channels interleaved, may be dst
+     * @param v      the filter states, v[j * FF_EBUR128_LANES + l] is
+     *               the state j + 1 of channel l
+     * @param c      the filter coefficients b[0..4] followed by a[1..4]
+     * @param frames number of samples per channel
+     */
+    void (*filter_lanes)(double *dst, const double *src, double *v,
+                         const double *c, int frames);
+} FFEBUR128DSPContext;
+
+void ff_ebur128_init_dsp(FFEBUR128DSPContext *dsp);
+void ff_ebur128_init_dsp_x86(FFEBUR128DSPContext *dsp);
+
 #endif                          /* AVFILTER_EBUR128_H */
@@ -27,6 +27,7 @@
 #include "audio.h"
 #include "filters.h"
 #include "formats.h"
+#include "framestore.h"
 #include "internal.h"
 #include "video.h"
 
@@ -35,7 +36,7 @@ typedef struct LoopContext {
 
     AVAudioFifo *fifo;
     AVAudioFifo *left;
-    AVFrame **frames;
+    FFFrameStore *store;
     int nb_frames;
     int current_frame;
     int64_t start_pts;
@@ -49,6 +50,7 @@ typedef struct LoopContext {
     int64_t size;
     int64_t start;
     int64_t pts;
+    int64_t max_memory;
 } LoopContext;
 
 #define AFLAGS AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
@@ -257,8 +259,8 @@ static av_cold int init(AVFilterContext *ctx)
 {
     LoopContext *s = ctx->priv;
 
-    s->frames = av_calloc(s->size, sizeof(*s->frames));
-    if (!s->frames)
+    s->store = ff_framestore_alloc(ctx, s->max_memory);
+    if (!s->store)
         return AVERROR(ENOMEM);
 
     check_size(ctx);
@@ -269,12 +271,8 @@ static av_cold int init(AVFilterContext *ctx)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     LoopContext *s = ctx->priv;
-    int i;
 
-    for (i = 0; i < s->nb_frames; i++)
-        av_frame_free(&s->frames[i]);
-
-    av_freep(&s->frames);
+    ff_framestore_free(&s->store);
     s->nb_frames = 0;
 }
 
@@ -283,12 +281,12 @@ static int push_frame(AVFilterContext *ctx)
     AVFilterLink *outlink = ctx->outputs[0];
     LoopContext *s = ctx->priv;
     int64_t pts, duration;
+    AVFrame *out;
     int ret;
 
-    AVFrame *out = av_frame_clone(s->frames[s->current_frame]);
-
-    if (!out)
-        return AVERROR(ENOMEM);
+    ret = ff_framestore_get(s->store, s->current_frame, &out);
+    if (ret < 0)
+        return ret;
     out->pts += s->duration - s->start_pts;
     if (out->pkt_duration)
         duration = out->pkt_duration;
@@ -314,6 +312,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = ctx->outputs[0];
     LoopContext *s = ctx->priv;
+    AVFrame *stored;
     int64_t duration;
     int ret = 0;
 
@@ -321,11 +320,16 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         if (s->nb_frames < s->size) {
             if (!s->nb_frames)
                 s->start_pts = frame->pts;
-            s->frames[s->nb_frames] = av_frame_clone(frame);
-            if (!s->frames[s->nb_frames]) {
+            stored = av_frame_clone(frame);
+            if (!stored) {
                 av_frame_free(&frame);
                 return AVERROR(ENOMEM);
             }
+            ret = ff_framestore_add(s->store, stored);
+            if (ret < 0) {
+                av_frame_free(&frame);
+                return ret;
+            }
             s->nb_frames++;
             if (frame->pkt_duration)
                 duration = frame->pkt_duration;
@@ -391,6 +395,7 @@ static const AVOption loop_options[] = {
     { "loop",  "number of loops",              OFFSET(loop),  AV_OPT_TYPE_INT,   {.i64 = 0 }, -1, INT_MAX,   VFLAGS },
     { "size",  "max number of frames to loop", OFFSET(size),  AV_OPT_TYPE_INT64, {.i64 = 0 },  0, INT16_MAX, VFLAGS },
     { "start", "set the loop start frame",     OFFSET(start), AV_OPT_TYPE_INT64, {.i64 = 0 },  0, INT64_MAX, VFLAGS },
+    { "max_memory", "set the maximum size of the frames kept in memory", OFFSET(max_memory), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, VFLAGS },
     { NULL }
 };
 
@@ -21,20 +21,25 @@
 #include "libavutil/opt.h"
 #include "avfilter.h"
 #include "formats.h"
+#include "framestore.h"
 #include "internal.h"
 #include "video.h"
 
 #define DEFAULT_LENGTH 300
 
 typedef struct ReverseContext {
-    int nb_frames;
-    AVFrame **frames;
-    unsigned int frames_size;
+    const AVClass *class;
+    FFFrameStore *store;
     unsigned int pts_size;
     int64_t *pts;
     int flush_idx;
+    int64_t max_memory;
 } ReverseContext;
 
+#define OFFSET(x) offsetof(ReverseContext, x)
+#define AFLAGS AV_OPT_FLAG_AUDIO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+#define VFLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+
 static av_cold int init(AVFilterContext *ctx)
 {
     ReverseContext *s = ctx->priv;
@@ -44,9 +49,8 @@ static av_cold int init(AVFilterContext *ctx)
     if (!s->pts)
         return AVERROR(ENOMEM);
 
-    s->frames = av_fast_realloc(NULL, &s->frames_size,
-                                DEFAULT_LENGTH * sizeof(*(s->frames)));
-    if (!s->frames) {
+    s->store = ff_framestore_alloc(ctx, s->max_memory);
+    if (!s->store) {
         av_freep(&s->pts);
         return AVERROR(ENOMEM);
     }
@@ -59,34 +63,28 @@ static av_cold void uninit(AVFilterContext *ctx)
     ReverseContext *s = ctx->priv;
 
     av_freep(&s->pts);
-    av_freep(&s->frames);
+    ff_framestore_free(&s->store);
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     ReverseContext *s    = ctx->priv;
+    int nb_frames = ff_framestore_nb_frames(s->store);
     void *ptr;
 
-    if (s->nb_frames + 1 > s->pts_size / sizeof(*(s->pts))) {
+    if (nb_frames + 1 > s->pts_size / sizeof(*(s->pts))) {
         ptr = av_fast_realloc(s->pts, &s->pts_size, s->pts_size * 2);
-        if (!ptr)
+        if (!ptr) {
+            av_frame_free(&in);
             return AVERROR(ENOMEM);
+        }
         s->pts = ptr;
     }
 
-    if (s->nb_frames + 1 > s->frames_size / sizeof(*(s->frames))) {
-        ptr = av_fast_realloc(s->frames, &s->frames_size, s->frames_size * 2);
-        if (!ptr)
-            return AVERROR(ENOMEM);
-        s->frames = ptr;
-    }
-
-    s->frames[s->nb_frames] = in;
-    s->pts[s->nb_frames]    = in->pts;
-    s->nb_frames++;
+    s->pts[nb_frames] = in->pts;
 
-    return 0;
+    return ff_framestore_add(s->store, in);
 }
 
 #if CONFIG_REVERSE_FILTER
@@ -99,16 +97,26 @@ static int request_frame(AVFilterLink *outlink)
 
     ret = ff_request_frame(ctx->inputs[0]);
 
-    if (ret == AVERROR_EOF && s->nb_frames > 0) {
-        AVFrame *out = s->frames[s->nb_frames - 1];
-        out->pts     = s->pts[s->flush_idx++];
-        ret          = ff_filter_frame(outlink, out);
-        s->nb_frames--;
+    if (ret == AVERROR_EOF && ff_framestore_nb_frames(s->store) > 0) {
+        AVFrame *out;
+
+        ret = ff_framestore_take_last(s->store, &out);
+        if (ret < 0)
+            return ret;
+        out->pts = s->pts[s->flush_idx++];
+        ret      = ff_filter_frame(outlink, out);
     }
 
     return ret;
 }
 
+static const AVOption reverse_options[] = {
+    { "max_memory", "set the maximum size of the frames kept in memory", OFFSET(max_memory), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, VFLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(reverse);
+
 static const AVFilterPad reverse_inputs[] = {
     {
         .name         = "default",
@@ -131,6 +139,7 @@ AVFilter ff_vf_reverse = {
     .name        = "reverse",
     .description = NULL_IF_CONFIG_SMALL("Reverse a clip."),
     .priv_size   = sizeof(ReverseContext),
+    .priv_class  = &reverse_class,
     .init        = init,
     .uninit      = uninit,
     .inputs      = reverse_inputs,
@@ -253,21 +262,31 @@ static int areverse_request_frame(AVFilterLink *outlink)
 
     ret = ff_request_frame(ctx->inputs[0]);
 
-    if (ret == AVERROR_EOF && s->nb_frames > 0) {
-        AVFrame *out = s->frames[s->nb_frames - 1];
-        out->pts     = s->pts[s->flush_idx++];
+    if (ret == AVERROR_EOF && ff_framestore_nb_frames(s->store) > 0) {
+        AVFrame *out;
+
+        ret = ff_framestore_take_last(s->store, &out);
+        if (ret < 0)
+            return ret;
+        out->pts = s->pts[s->flush_idx++];
 
         if (av_sample_fmt_is_planar(out->format))
             reverse_samples_planar(out);
         else
             reverse_samples_packed(out);
         ret = ff_filter_frame(outlink, out);
-        s->nb_frames--;
     }
 
     return ret;
 }
 
+static const AVOption areverse_options[] = {
+    { "max_memory", "set the maximum size of the frames kept in memory", OFFSET(max_memory), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, AFLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(areverse);
+
 static const AVFilterPad areverse_inputs[] = {
     {
         .name           = "default",
@@ -292,6 +311,7 @@ AVFilter ff_af_areverse = {
     .description   = NULL_IF_CONFIG_SMALL("Reverse an audio clip."),
     .query_formats = query_formats,
     .priv_size     = sizeof(ReverseContext),
+    .priv_class    = &areverse_class,
     .init          = init,
     .uninit        = uninit,
     .inputs        = areverse_inputs,
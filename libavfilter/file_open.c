@@ -0,0 +1 @@
+#include "libavutil/file_open.c"
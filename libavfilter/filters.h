@@ -166,6 +166,22 @@ void ff_inlink_request_frame(AVFilterLink *link);
  */
 void ff_inlink_set_status(AVFilterLink *link, int status);
 
+/**
+ * Ask for a border to be reserved around the frames allocated for an input
+ * link, so that the filter can grow them in place.
+ * Must be called when configuring the link.
+ *
+ * @param border left, top, right and bottom border, in pixels
+ */
+void ff_inlink_set_reserve_border(AVFilterLink *link, const int border[4]);
+
+/**
+ * Get the border set with ff_inlink_set_reserve_border().
+ *
+ * @return 1 if a border was set, 0 otherwise
+ */
+int ff_inlink_get_reserve_border(AVFilterLink *link, int border[4]);
+
 /**
  * Test if a frame is wanted on an output link.
  */
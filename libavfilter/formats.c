@@ -54,77 +54,165 @@ do {                                                                       \
     av_freep(&a);                                                          \
 } while (0)
 
+#define FORMAT_SET_MIN_BITS 9
+
 /**
- * Add all formats common for a and b to ret, copy the refs and destroy
- * a and b.
+ * Set of formats, hashed for constant time lookups when intersecting
+ * lists, which would be quadratic otherwise.
  */
-#define MERGE_FORMATS(ret, a, b, fmts, nb, type, fail)                          \
-do {                                                                            \
-    int i, j, k = 0, count = FFMIN(a->nb, b->nb);                               \
-                                                                                \
-    if (!(ret = av_mallocz(sizeof(*ret))))                                      \
-        goto fail;                                                              \
-                                                                                \
-    if (count) {                                                                \
-        if (!(ret->fmts = av_malloc_array(count, sizeof(*ret->fmts))))          \
-            goto fail;                                                          \
-        for (i = 0; i < a->nb; i++)                                             \
-            for (j = 0; j < b->nb; j++)                                         \
-                if (a->fmts[i] == b->fmts[j]) {                                 \
-                    if(k >= FFMIN(a->nb, b->nb)){                               \
-                        av_log(NULL, AV_LOG_ERROR, "Duplicate formats in %s detected\n", __FUNCTION__); \
-                        av_free(ret->fmts);                                     \
-                        av_free(ret);                                           \
-                        return NULL;                                            \
-                    }                                                           \
-                    ret->fmts[k++] = a->fmts[i];                                \
-                }                                                               \
-    }                                                                           \
-    ret->nb = k;                                                                \
-    /* check that there was at least one common format */                       \
-    if (!ret->nb)                                                               \
-        goto fail;                                                              \
-                                                                                \
-    MERGE_REF(ret, a, fmts, type, fail);                                        \
-    MERGE_REF(ret, b, fmts, type, fail);                                        \
-} while (0)
+typedef struct FormatSet {
+    int     *keys;
+    uint8_t *used;
+    unsigned mask;
+    int      shift;
+    int      keys_buf[1 << FORMAT_SET_MIN_BITS];
+    uint8_t  used_buf[1 << FORMAT_SET_MIN_BITS];
+} FormatSet;
+
+static unsigned format_set_slot(const FormatSet *s, int fmt)
+{
+    return (unsigned)fmt * 0x9E3779B1U >> s->shift;
+}
 
-AVFilterFormats *ff_merge_formats(AVFilterFormats *a, AVFilterFormats *b,
-                                  enum AVMediaType type)
+static int format_set_init(FormatSet *s, const AVFilterFormats *f)
 {
-    AVFilterFormats *ret = NULL;
-    int i, j;
-    int alpha1=0, alpha2=0;
-    int chroma1=0, chroma2=0;
+    int bits = FORMAT_SET_MIN_BITS, i;
+
+    while ((1 << bits) < 2 * f->nb_formats)
+        bits++;
+
+    if (bits > FORMAT_SET_MIN_BITS) {
+        s->keys = av_malloc_array(1 << bits, sizeof(*s->keys));
+        s->used = av_mallocz(1 << bits);
+        if (!s->keys || !s->used) {
+            av_freep(&s->keys);
+            av_freep(&s->used);
+            return AVERROR(ENOMEM);
+        }
+    } else {
+        s->keys = s->keys_buf;
+        s->used = s->used_buf;
+        memset(s->used, 0, sizeof(s->used_buf));
+    }
+    s->mask  = (1 << bits) - 1;
+    s->shift = 32 - bits;
 
-    if (a == b)
-        return a;
+    for (i = 0; i < f->nb_formats; i++) {
+        unsigned slot = format_set_slot(s, f->formats[i]);
+
+        while (s->used[slot] && s->keys[slot] != f->formats[i])
+            slot = (slot + 1) & s->mask;
+        s->used[slot] = 1;
+        s->keys[slot] = f->formats[i];
+    }
+
+    return 0;
+}
+
+static int format_set_has(const FormatSet *s, int fmt)
+{
+    unsigned slot = format_set_slot(s, fmt);
+
+    while (s->used[slot]) {
+        if (s->keys[slot] == fmt)
+            return 1;
+        slot = (slot + 1) & s->mask;
+    }
+    return 0;
+}
 
-    /* Do not lose chroma or alpha in merging.
-       It happens if both lists have formats with chroma (resp. alpha), but
-       the only formats in common do not have it (e.g. YUV+gray vs.
-       RGB+gray): in that case, the merging would select the gray format,
-       possibly causing a lossy conversion elsewhere in the graph.
-       To avoid that, pretend that there are no common formats to force the
-       insertion of a conversion filter. */
-    if (type == AVMEDIA_TYPE_VIDEO)
+static void format_set_uninit(FormatSet *s)
+{
+    if (s->keys != s->keys_buf) {
+        av_freep(&s->keys);
+        av_freep(&s->used);
+    }
+}
+
+static int have_common_formats(const AVFilterFormats *a, const FormatSet *b)
+{
+    int i;
+
+    for (i = 0; i < a->nb_formats; i++)
+        if (format_set_has(b, a->formats[i]))
+            return 1;
+    return 0;
+}
+
+/**
+ * Check that merging the pixel formats lists a and b does not lose chroma
+ * or alpha.
+ * It happens if both lists have formats with chroma (resp. alpha), but
+ * the only formats in common do not have it (e.g. YUV+gray vs.
+ * RGB+gray): in that case, the merging would select the gray format,
+ * possibly causing a lossy conversion elsewhere in the graph.
+ * To avoid that, pretend that there are no common formats to force the
+ * insertion of a conversion filter.
+ */
+static int merge_keeps_chroma_alpha(const AVFilterFormats *a,
+                                    const AVFilterFormats *b,
+                                    const FormatSet *bset)
+{
+    int alpha_a = 0, alpha_b = 0, alpha_common = 0;
+    int chroma_a = 0, chroma_b = 0, chroma_common = 0;
+    int i;
+
+    for (i = 0; i < a->nb_formats; i++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(a->formats[i]);
+        int alpha  = desc->flags & AV_PIX_FMT_FLAG_ALPHA;
+        int chroma = desc->nb_components > 1;
+
+        alpha_a  |= alpha;
+        chroma_a |= chroma;
+        if (format_set_has(bset, a->formats[i])) {
+            alpha_common  |= alpha;
+            chroma_common |= chroma;
+        }
+    }
+    for (i = 0; i < b->nb_formats; i++) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(b->formats[i]);
+
+        alpha_b  |= desc->flags & AV_PIX_FMT_FLAG_ALPHA;
+        chroma_b |= desc->nb_components > 1;
+    }
+
+    return (alpha_a & alpha_b) <= alpha_common &&
+           (chroma_a && chroma_b) <= chroma_common;
+}
+
+/**
+ * Add all formats common for a and b to a new list, move the refs to it
+ * and destroy a and b.
+ */
+static AVFilterFormats *merge_formats_lists(AVFilterFormats *a,
+                                            AVFilterFormats *b,
+                                            const FormatSet *bset)
+{
+    AVFilterFormats *ret;
+    int i, k = 0, count = FFMIN(a->nb_formats, b->nb_formats);
+
+    if (!(ret = av_mallocz(sizeof(*ret))))
+        goto fail;
+
+    if (count) {
+        if (!(ret->formats = av_malloc_array(count, sizeof(*ret->formats))))
+            goto fail;
         for (i = 0; i < a->nb_formats; i++)
-            for (j = 0; j < b->nb_formats; j++) {
-                const AVPixFmtDescriptor *adesc = av_pix_fmt_desc_get(a->formats[i]);
-                const AVPixFmtDescriptor *bdesc = av_pix_fmt_desc_get(b->formats[j]);
-                alpha2 |= adesc->flags & bdesc->flags & AV_PIX_FMT_FLAG_ALPHA;
-                chroma2|= adesc->nb_components > 1 && bdesc->nb_components > 1;
-                if (a->formats[i] == b->formats[j]) {
-                    alpha1 |= adesc->flags & AV_PIX_FMT_FLAG_ALPHA;
-                    chroma1|= adesc->nb_components > 1;
+            if (format_set_has(bset, a->formats[i])) {
+                if (k >= count) {
+                    av_log(NULL, AV_LOG_ERROR, "Duplicate formats in %s detected\n", __FUNCTION__);
+                    goto fail;
                 }
+                ret->formats[k++] = a->formats[i];
             }
+    }
+    ret->nb_formats = k;
+    /* check that there was at least one common format */
+    if (!ret->nb_formats)
+        goto fail;
 
-    // If chroma or alpha can be lost through merging then do not merge
-    if (alpha2 > alpha1 || chroma2 > chroma1)
-        return NULL;
-
-    MERGE_FORMATS(ret, a, b, formats, nb_formats, AVFilterFormats, fail);
+    MERGE_REF(ret, a, formats, AVFilterFormats, fail);
+    MERGE_REF(ret, b, formats, AVFilterFormats, fail);
 
     return ret;
 fail:
@@ -136,6 +224,44 @@ fail:
     return NULL;
 }
 
+AVFilterFormats *ff_merge_formats(AVFilterFormats *a, AVFilterFormats *b,
+                                  enum AVMediaType type)
+{
+    AVFilterFormats *ret = NULL;
+    FormatSet bset;
+
+    if (a == b)
+        return a;
+
+    if (format_set_init(&bset, b) < 0)
+        return NULL;
+
+    if (type != AVMEDIA_TYPE_VIDEO || merge_keeps_chroma_alpha(a, b, &bset))
+        ret = merge_formats_lists(a, b, &bset);
+
+    format_set_uninit(&bset);
+    return ret;
+}
+
+int ff_can_merge_formats(const AVFilterFormats *a, const AVFilterFormats *b,
+                         enum AVMediaType type)
+{
+    FormatSet bset;
+    int ret;
+
+    if (a == b)
+        return 1;
+
+    if (format_set_init(&bset, b) < 0)
+        return 0;
+
+    ret = (type != AVMEDIA_TYPE_VIDEO || merge_keeps_chroma_alpha(a, b, &bset)) &&
+          have_common_formats(a, &bset);
+
+    format_set_uninit(&bset);
+    return ret;
+}
+
 AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
                                       AVFilterFormats *b)
 {
@@ -144,7 +270,12 @@ AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
     if (a == b) return a;
 
     if (a->nb_formats && b->nb_formats) {
-        MERGE_FORMATS(ret, a, b, formats, nb_formats, AVFilterFormats, fail);
+        FormatSet bset;
+
+        if (format_set_init(&bset, b) < 0)
+            return NULL;
+        ret = merge_formats_lists(a, b, &bset);
+        format_set_uninit(&bset);
     } else if (a->nb_formats) {
         MERGE_REF(a, b, formats, AVFilterFormats, fail);
         ret = a;
@@ -163,6 +294,21 @@ fail:
     return NULL;
 }
 
+int ff_can_merge_samplerates(const AVFilterFormats *a, const AVFilterFormats *b)
+{
+    FormatSet bset;
+    int ret;
+
+    if (a == b || !a->nb_formats || !b->nb_formats)
+        return 1;
+
+    if (format_set_init(&bset, b) < 0)
+        return 0;
+    ret = have_common_formats(a, &bset);
+    format_set_uninit(&bset);
+    return ret;
+}
+
 AVFilterChannelLayouts *ff_merge_channel_layouts(AVFilterChannelLayouts *a,
                                                  AVFilterChannelLayouts *b)
 {
@@ -350,25 +496,94 @@ int ff_add_channel_layout(AVFilterChannelLayouts **l, uint64_t channel_layout)
 AVFilterFormats *ff_all_formats(enum AVMediaType type)
 {
     AVFilterFormats *ret = NULL;
+    int nb_formats = 0;
 
+    /* count the formats first, to allocate the list at once */
     if (type == AVMEDIA_TYPE_VIDEO) {
         const AVPixFmtDescriptor *desc = NULL;
-        while ((desc = av_pix_fmt_desc_next(desc))) {
-            if (ff_add_format(&ret, av_pix_fmt_desc_get_id(desc)) < 0)
-                return NULL;
-        }
+        while ((desc = av_pix_fmt_desc_next(desc)))
+            nb_formats++;
     } else if (type == AVMEDIA_TYPE_AUDIO) {
-        enum AVSampleFormat fmt = 0;
-        while (av_get_sample_fmt_name(fmt)) {
-            if (ff_add_format(&ret, fmt) < 0)
-                return NULL;
-            fmt++;
+        while (av_get_sample_fmt_name(nb_formats))
+            nb_formats++;
+    }
+    if (!nb_formats)
+        return NULL;
+
+    if (!(ret = av_mallocz(sizeof(*ret))) ||
+        !(ret->formats = av_malloc_array(nb_formats, sizeof(*ret->formats)))) {
+        av_freep(&ret);
+        return NULL;
+    }
+
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        const AVPixFmtDescriptor *desc = NULL;
+        while ((desc = av_pix_fmt_desc_next(desc)))
+            ret->formats[ret->nb_formats++] = av_pix_fmt_desc_get_id(desc);
+    } else {
+        while (ret->nb_formats < nb_formats) {
+            ret->formats[ret->nb_formats] = ret->nb_formats;
+            ret->nb_formats++;
         }
     }
 
     return ret;
 }
 
+static enum AVPixelFormat pix_fmt_unjpeg(enum AVPixelFormat fmt)
+{
+    switch (fmt) {
+    case AV_PIX_FMT_YUVJ411P: return AV_PIX_FMT_YUV411P;
+    case AV_PIX_FMT_YUVJ420P: return AV_PIX_FMT_YUV420P;
+    case AV_PIX_FMT_YUVJ422P: return AV_PIX_FMT_YUV422P;
+    case AV_PIX_FMT_YUVJ440P: return AV_PIX_FMT_YUV440P;
+    case AV_PIX_FMT_YUVJ444P: return AV_PIX_FMT_YUV444P;
+    default:                  return fmt;
+    }
+}
+
+int ff_pix_fmt_can_alias(enum AVPixelFormat src, enum AVPixelFormat dst)
+{
+    const AVPixFmtDescriptor *sdesc, *ddesc;
+    int i;
+
+    /* A yuvj frame is always full range and stays valid as yuv once tagged
+     * so. The reverse does not hold: yuv frames are mostly limited range,
+     * which is only known per frame, and must then be expanded to full
+     * range to become yuvj, as scale does. */
+    src = pix_fmt_unjpeg(src);
+    if (src == dst)
+        return 1;
+
+    sdesc = av_pix_fmt_desc_get(src);
+    ddesc = av_pix_fmt_desc_get(dst);
+    if (!sdesc || !ddesc)
+        return 0;
+
+    /* only the luma plane of a YUV format as gray */
+    if ((sdesc->flags | ddesc->flags) & (AV_PIX_FMT_FLAG_HWACCEL |
+                                         AV_PIX_FMT_FLAG_BITSTREAM |
+                                         AV_PIX_FMT_FLAG_PAL |
+                                         AV_PIX_FMT_FLAG_RGB))
+        return 0;
+    if (sdesc->nb_components < 3 || ddesc->nb_components != 1 ||
+        !(sdesc->flags & AV_PIX_FMT_FLAG_PLANAR) ||
+        (sdesc->flags ^ ddesc->flags) & (AV_PIX_FMT_FLAG_BE |
+                                         AV_PIX_FMT_FLAG_FLOAT))
+        return 0;
+    if (sdesc->comp[0].plane  != 0                      ||
+        sdesc->comp[0].step   != ddesc->comp[0].step    ||
+        sdesc->comp[0].offset != ddesc->comp[0].offset  ||
+        sdesc->comp[0].shift  != ddesc->comp[0].shift   ||
+        sdesc->comp[0].depth  != ddesc->comp[0].depth)
+        return 0;
+    for (i = 1; i < sdesc->nb_components; i++)
+        if (sdesc->comp[i].plane == 0)
+            return 0;
+
+    return 1;
+}
+
 const int64_t avfilter_all_channel_layouts[] = {
 #include "all_channel_layouts.inc"
     -1
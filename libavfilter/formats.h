@@ -121,6 +121,12 @@ AVFilterChannelLayouts *ff_merge_channel_layouts(AVFilterChannelLayouts *a,
 AVFilterFormats *ff_merge_samplerates(AVFilterFormats *a,
                                       AVFilterFormats *b);
 
+/**
+ * Check whether ff_merge_samplerates() would succeed on a and b, without
+ * modifying them.
+ */
+int ff_can_merge_samplerates(const AVFilterFormats *a, const AVFilterFormats *b);
+
 /**
  * Construct an empty AVFilterChannelLayouts/AVFilterFormats struct --
  * representing any channel layout (with known disposition)/sample rate.
@@ -227,6 +233,19 @@ AVFilterFormats *ff_all_formats(enum AVMediaType type);
 av_warn_unused_result
 AVFilterFormats *ff_planar_sample_fmts(void);
 
+/**
+ * Check whether frames in the pixel format src can be reinterpreted as
+ * frames in the pixel format dst, by only changing the frame properties
+ * and dropping some planes, without touching the pixel data.
+ *
+ * This is not symmetric: yuvj formats can be reinterpreted as the matching
+ * yuv formats, but not the other way around, since a yuv frame may be
+ * limited range.
+ *
+ * @return 1 if they can, 0 otherwise
+ */
+int ff_pix_fmt_can_alias(enum AVPixelFormat src, enum AVPixelFormat dst);
+
 /**
  * Return a format list which contains the intersection of the formats of
  * a and b. Also, all the references of a, all the references of b, and
@@ -238,6 +257,13 @@ AVFilterFormats *ff_planar_sample_fmts(void);
 AVFilterFormats *ff_merge_formats(AVFilterFormats *a, AVFilterFormats *b,
                                   enum AVMediaType type);
 
+/**
+ * Check whether ff_merge_formats() would succeed on a and b, without
+ * modifying them.
+ */
+int ff_can_merge_formats(const AVFilterFormats *a, const AVFilterFormats *b,
+                         enum AVMediaType type);
+
 /**
  * Add *ref as a new reference to formats.
  * That is the pointers will point like in the ascii art below:
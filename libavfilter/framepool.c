@@ -45,6 +45,10 @@ struct FFFramePool {
     int align;
     int linesize[4];
     AVBufferPool *pools[4];
+    AVBufferRef* (*alloc)(int size);
+
+    /* number of owners, see ff_frame_pool_list_get_video() */
+    int refcount;
 
 };
 
@@ -66,6 +70,8 @@ FFFramePool *ff_frame_pool_video_init(AVBufferRef* (*alloc)(int size),
         return NULL;
 
     pool->type = AVMEDIA_TYPE_VIDEO;
+    pool->refcount = 1;
+    pool->alloc = alloc;
     pool->width = width;
     pool->height = height;
     pool->format = format;
@@ -132,6 +138,8 @@ FFFramePool *ff_frame_pool_audio_init(AVBufferRef* (*alloc)(int size),
     planar = av_sample_fmt_is_planar(format);
 
     pool->type = AVMEDIA_TYPE_AUDIO;
+    pool->refcount = 1;
+    pool->alloc = alloc;
     pool->planes = planar ? channels : 1;
     pool->channels = channels;
     pool->nb_samples = nb_samples;
@@ -288,9 +296,112 @@ void ff_frame_pool_uninit(FFFramePool **pool)
     if (!pool || !*pool)
         return;
 
+    if (--(*pool)->refcount > 0) {
+        *pool = NULL;
+        return;
+    }
+
     for (i = 0; i < 4; i++) {
         av_buffer_pool_uninit(&(*pool)->pools[i]);
     }
 
     av_freep(pool);
 }
+
+/**
+ * Drop the pools of the list that are not used by anyone else anymore.
+ */
+static void pool_list_prune(FFFramePoolList *list)
+{
+    int i, j;
+
+    for (i = j = 0; i < list->nb_pools; i++) {
+        if (list->pools[i]->refcount == 1)
+            ff_frame_pool_uninit(&list->pools[i]);
+        else
+            list->pools[j++] = list->pools[i];
+    }
+    list->nb_pools = j;
+}
+
+static FFFramePool *pool_list_add(FFFramePoolList *list, FFFramePool *pool)
+{
+    FFFramePool **pools;
+
+    if (!pool)
+        return NULL;
+
+    pools = av_realloc_array(list->pools, list->nb_pools + 1, sizeof(*list->pools));
+    if (!pools) {
+        /* the pool still works, it is only not shared */
+        return pool;
+    }
+    list->pools = pools;
+    list->pools[list->nb_pools++] = pool;
+    pool->refcount++;
+
+    return pool;
+}
+
+FFFramePool *ff_frame_pool_list_get_video(FFFramePoolList *list,
+                                          AVBufferRef* (*alloc)(int size),
+                                          int width,
+                                          int height,
+                                          enum AVPixelFormat format,
+                                          int align)
+{
+    int i;
+
+    for (i = 0; i < list->nb_pools; i++) {
+        FFFramePool *pool = list->pools[i];
+
+        if (pool->type == AVMEDIA_TYPE_VIDEO && pool->alloc == alloc &&
+            pool->width == width && pool->height == height &&
+            pool->format == format && pool->align == align) {
+            pool->refcount++;
+            return pool;
+        }
+    }
+
+    pool_list_prune(list);
+
+    return pool_list_add(list, ff_frame_pool_video_init(alloc, width, height,
+                                                        format, align));
+}
+
+FFFramePool *ff_frame_pool_list_get_audio(FFFramePoolList *list,
+                                          AVBufferRef* (*alloc)(int size),
+                                          int channels,
+                                          int nb_samples,
+                                          enum AVSampleFormat format,
+                                          int align)
+{
+    int i;
+
+    for (i = 0; i < list->nb_pools; i++) {
+        FFFramePool *pool = list->pools[i];
+
+        if (pool->type == AVMEDIA_TYPE_AUDIO && pool->alloc == alloc &&
+            pool->channels == channels && pool->nb_samples == nb_samples &&
+            pool->format == format && pool->align == align) {
+            pool->refcount++;
+            return pool;
+        }
+    }
+
+    pool_list_prune(list);
+
+    return pool_list_add(list, ff_frame_pool_audio_init(alloc, channels,
+                                                        nb_samples, format,
+                                                        align));
+}
+
+void ff_frame_pool_list_uninit(FFFramePoolList *list)
+{
+    int i;
+
+    for (i = 0; i < list->nb_pools; i++)
+        ff_frame_pool_uninit(&list->pools[i]);
+    av_freep(&list->pools);
+    list->nb_pools = 0;
+}
@@ -69,7 +69,8 @@ FFFramePool *ff_frame_pool_audio_init(AVBufferRef* (*alloc)(int size),
 
 /**
  * Deallocate the frame pool. It is safe to call this function while
- * some of the allocated frame are still in use.
+ * some of the allocated frame are still in use. If the pool was obtained
+ * from a FFFramePoolList, only the reference of the caller is released.
  *
  * @param pool pointer to the frame pool to be freed. It will be set to NULL.
  */
@@ -114,5 +115,54 @@ int ff_frame_pool_get_audio_config(FFFramePool *pool,
  */
 AVFrame *ff_frame_pool_get(FFFramePool *pool);
 
+/**
+ * List of frame pools shared between several users, typically all the
+ * links of a filter graph, so that the links with the same frame geometry
+ * recycle the same buffers.
+ *
+ * The list must be zeroed before use. It is not thread-safe: it must only
+ * be accessed by the thread running the graph.
+ */
+typedef struct FFFramePoolList {
+    FFFramePool **pools;
+    int nb_pools;
+} FFFramePoolList;
+
+/**
+ * Get a video frame pool with the given configuration from the list,
+ * creating it if needed. The parameters are the same as for
+ * ff_frame_pool_video_init().
+ *
+ * @return a reference to the pool, to be released with ff_frame_pool_uninit(),
+ *         NULL on error.
+ */
+FFFramePool *ff_frame_pool_list_get_video(FFFramePoolList *list,
+                                          AVBufferRef* (*alloc)(int size),
+                                          int width,
+                                          int height,
+                                          enum AVPixelFormat format,
+                                          int align);
+
+/**
+ * Get an audio frame pool with the given configuration from the list,
+ * creating it if needed. The parameters are the same as for
+ * ff_frame_pool_audio_init().
+ *
+ * @return a reference to the pool, to be released with ff_frame_pool_uninit(),
+ *         NULL on error.
+ */
+FFFramePool *ff_frame_pool_list_get_audio(FFFramePoolList *list,
+                                          AVBufferRef* (*alloc)(int size),
+                                          int channels,
+                                          int nb_samples,
+                                          enum AVSampleFormat format,
+                                          int align);
+
+/**
+ * Release the references of the list to its pools. The pools still
+ * referenced elsewhere stay valid.
+ */
+void ff_frame_pool_list_uninit(FFFramePoolList *list);
+
 
 #endif /* AVFILTER_FRAMEPOOL_H */
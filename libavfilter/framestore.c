@@ -0,0 +1,399 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if HAVE_IO_H
+#include <io.h>
+#endif
+
+#include "libavutil/avassert.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/samplefmt.h"
+#include "framestore.h"
+
+typedef struct StoredFrame {
+    /**
+     * The frame, only holding the properties when its data is in the
+     * temporary file.
+     */
+    AVFrame *frame;
+
+    /**
+     * Size of the frame data, 0 if it cannot be moved to the file.
+     */
+    int64_t size;
+
+    /**
+     * Position of the frame data in the temporary file, -1 if in memory.
+     */
+    int64_t pos;
+} StoredFrame;
+
+struct FFFrameStore {
+    void *log_ctx;
+    int64_t max_memory;
+
+    /**
+     * Size of the frame data currently in memory.
+     */
+    int64_t memory;
+
+    StoredFrame *frames;
+    unsigned int frames_size;
+    int nb_frames;
+
+    /**
+     * The frames before this index have been considered for moving to the
+     * temporary file already.
+     */
+    int nb_spilled;
+
+    int fd;
+    char *filename;
+    int64_t file_size;
+
+    uint8_t *buf;
+    unsigned int buf_size;
+};
+
+FFFrameStore *ff_framestore_alloc(void *log_ctx, int64_t max_memory)
+{
+    FFFrameStore *fs = av_mallocz(sizeof(*fs));
+
+    if (!fs)
+        return NULL;
+    fs->log_ctx    = log_ctx;
+    fs->max_memory = max_memory;
+    fs->fd         = -1;
+
+    return fs;
+}
+
+void ff_framestore_free(FFFrameStore **pfs)
+{
+    FFFrameStore *fs = *pfs;
+    int i;
+
+    if (!fs)
+        return;
+
+    for (i = 0; i < fs->nb_frames; i++)
+        av_frame_free(&fs->frames[i].frame);
+    av_freep(&fs->frames);
+    av_freep(&fs->buf);
+
+    if (fs->fd >= 0)
+        close(fs->fd);
+    if (fs->filename)
+        unlink(fs->filename);
+    av_freep(&fs->filename);
+
+    av_freep(pfs);
+}
+
+int ff_framestore_nb_frames(const FFFrameStore *fs)
+{
+    return fs->nb_frames;
+}
+
+static int64_t frame_data_size(const AVFrame *frame)
+{
+    int size;
+
+    if (frame->nb_samples > 0)
+        size = av_samples_get_buffer_size(NULL, frame->channels, frame->nb_samples,
+                                          frame->format, 1);
+    else if (!frame->hw_frames_ctx)
+        size = av_image_get_buffer_size(frame->format, frame->width, frame->height, 1);
+    else
+        size = 0;
+
+    return FFMAX(size, 0);
+}
+
+static AVFrame *alloc_frame_props(const AVFrame *src)
+{
+    AVFrame *frame = av_frame_alloc();
+
+    if (!frame)
+        return NULL;
+
+    frame->format         = src->format;
+    frame->width          = src->width;
+    frame->height         = src->height;
+    frame->nb_samples     = src->nb_samples;
+    frame->channels       = src->channels;
+    frame->channel_layout = src->channel_layout;
+    if (av_frame_copy_props(frame, src) < 0)
+        av_frame_free(&frame);
+
+    return frame;
+}
+
+static int open_file(FFFrameStore *fs)
+{
+    char *filename;
+
+    fs->fd = avpriv_tempfile("ffframestore", &filename, 0, fs->log_ctx);
+    if (fs->fd < 0) {
+        av_log(fs->log_ctx, AV_LOG_ERROR, "Failed to create temporary file\n");
+        return fs->fd;
+    }
+
+    /* keep the name to retry at the end if the file is still in use */
+    if (unlink(filename) < 0)
+        fs->filename = filename;
+    else
+        av_freep(&filename);
+
+    return 0;
+}
+
+static int write_data(FFFrameStore *fs, int64_t pos, const uint8_t *buf, int64_t size)
+{
+    if (lseek(fs->fd, pos, SEEK_SET) < 0)
+        return AVERROR(errno);
+
+    while (size > 0) {
+        int ret = write(fs->fd, buf, FFMIN(size, INT_MAX));
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        buf  += ret;
+        size -= ret;
+    }
+
+    return 0;
+}
+
+static int read_data(FFFrameStore *fs, int64_t pos, uint8_t *buf, int64_t size)
+{
+    if (lseek(fs->fd, pos, SEEK_SET) < 0)
+        return AVERROR(errno);
+
+    while (size > 0) {
+        int ret = read(fs->fd, buf, FFMIN(size, INT_MAX));
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return AVERROR(errno);
+        }
+        if (!ret)
+            return AVERROR(EIO);
+        buf  += ret;
+        size -= ret;
+    }
+
+    return 0;
+}
+
+/**
+ * Move the data of a frame to the end of the temporary file.
+ */
+static int spill_frame(FFFrameStore *fs, StoredFrame *sf)
+{
+    AVFrame *frame = sf->frame;
+    AVFrame *props;
+    int ret;
+
+    if (!sf->size || sf->pos >= 0)
+        return 0;
+
+    if (fs->fd < 0) {
+        ret = open_file(fs);
+        if (ret < 0)
+            return ret;
+    }
+
+    av_fast_malloc(&fs->buf, &fs->buf_size, sf->size);
+    if (!fs->buf)
+        return AVERROR(ENOMEM);
+
+    if (frame->nb_samples > 0) {
+        int planar = av_sample_fmt_is_planar(frame->format);
+        int planes = planar ? frame->channels : 1;
+        int plane_size = sf->size / planes;
+
+        for (int p = 0; p < planes; p++)
+            memcpy(fs->buf + p * plane_size, frame->extended_data[p], plane_size);
+    } else {
+        ret = av_image_copy_to_buffer(fs->buf, sf->size,
+                                      (const uint8_t * const *)frame->data, frame->linesize,
+                                      frame->format, frame->width, frame->height, 1);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = write_data(fs, fs->file_size, fs->buf, sf->size);
+    if (ret < 0) {
+        av_log(fs->log_ctx, AV_LOG_ERROR, "Failed to write to temporary file\n");
+        return ret;
+    }
+
+    props = alloc_frame_props(frame);
+    if (!props)
+        return AVERROR(ENOMEM);
+    av_frame_free(&sf->frame);
+    sf->frame = props;
+    sf->pos = fs->file_size;
+    fs->file_size += sf->size;
+    fs->memory -= sf->size;
+
+    return 0;
+}
+
+/**
+ * Read back the data of a frame from the temporary file into a new frame.
+ */
+static int load_frame(FFFrameStore *fs, const StoredFrame *sf, AVFrame **pframe)
+{
+    AVFrame *frame;
+    int ret;
+
+    av_fast_malloc(&fs->buf, &fs->buf_size, sf->size);
+    if (!fs->buf)
+        return AVERROR(ENOMEM);
+
+    ret = read_data(fs, sf->pos, fs->buf, sf->size);
+    if (ret < 0) {
+        av_log(fs->log_ctx, AV_LOG_ERROR, "Failed to read from temporary file\n");
+        return ret;
+    }
+
+    frame = alloc_frame_props(sf->frame);
+    if (!frame)
+        return AVERROR(ENOMEM);
+    ret = av_frame_get_buffer(frame, 0);
+    if (ret < 0)
+        goto fail;
+
+    if (frame->nb_samples > 0) {
+        int planar = av_sample_fmt_is_planar(frame->format);
+        int planes = planar ? frame->channels : 1;
+        int plane_size = sf->size / planes;
+
+        for (int p = 0; p < planes; p++)
+            memcpy(frame->extended_data[p], fs->buf + p * plane_size, plane_size);
+    } else {
+        uint8_t *data[4];
+        int linesize[4];
+
+        ret = av_image_fill_arrays(data, linesize, fs->buf, frame->format,
+                                   frame->width, frame->height, 1);
+        if (ret < 0)
+            goto fail;
+        av_image_copy(frame->data, frame->linesize, (const uint8_t **)data, linesize,
+                      frame->format, frame->width, frame->height);
+    }
+
+    *pframe = frame;
+    return 0;
+fail:
+    av_frame_free(&frame);
+    return ret;
+}
+
+int ff_framestore_add(FFFrameStore *fs, AVFrame *frame)
+{
+    StoredFrame *sf;
+    int ret;
+
+    if (fs->nb_frames + 1 > fs->frames_size / sizeof(*fs->frames)) {
+        void *ptr = av_fast_realloc(fs->frames, &fs->frames_size,
+                                    FFMAX(2 * fs->frames_size, 16 * sizeof(*fs->frames)));
+        if (!ptr) {
+            av_frame_free(&frame);
+            return AVERROR(ENOMEM);
+        }
+        fs->frames = ptr;
+    }
+
+    sf = &fs->frames[fs->nb_frames++];
+    sf->frame = frame;
+    sf->size  = frame_data_size(frame);
+    sf->pos   = -1;
+    fs->memory += sf->size;
+
+    /* move the oldest frames out of memory */
+    while (fs->max_memory && fs->memory > fs->max_memory &&
+           fs->nb_spilled < fs->nb_frames) {
+        ret = spill_frame(fs, &fs->frames[fs->nb_spilled]);
+        if (ret < 0) {
+            /* the new frame is spilled last, so it is still in memory */
+            sf = &fs->frames[--fs->nb_frames];
+            fs->memory -= sf->size;
+            av_frame_free(&sf->frame);
+            return ret;
+        }
+        fs->nb_spilled++;
+    }
+
+    return 0;
+}
+
+int ff_framestore_get(FFFrameStore *fs, int idx, AVFrame **frame)
+{
+    const StoredFrame *sf;
+
+    av_assert0(idx >= 0 && idx < fs->nb_frames);
+    sf = &fs->frames[idx];
+
+    if (sf->pos < 0) {
+        *frame = av_frame_clone(sf->frame);
+        return *frame ? 0 : AVERROR(ENOMEM);
+    }
+
+    return load_frame(fs, sf, frame);
+}
+
+int ff_framestore_take_last(FFFrameStore *fs, AVFrame **frame)
+{
+    StoredFrame *sf;
+    int ret;
+
+    av_assert0(fs->nb_frames > 0);
+    sf = &fs->frames[fs->nb_frames - 1];
+
+    if (sf->pos < 0) {
+        *frame = sf->frame;
+        fs->memory -= sf->size;
+    } else {
+        ret = load_frame(fs, sf, frame);
+        if (ret < 0)
+            return ret;
+        /* reuse the space if more frames are added later */
+        if (sf->pos + sf->size == fs->file_size)
+            fs->file_size = sf->pos;
+        av_frame_free(&sf->frame);
+    }
+
+    fs->nb_frames--;
+    fs->nb_spilled = FFMIN(fs->nb_spilled, fs->nb_frames);
+
+    return 0;
+}
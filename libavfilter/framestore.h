@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_FRAMESTORE_H
+#define AVFILTER_FRAMESTORE_H
+
+/**
+ * FFFrameStore: indexed storage for the filters that need to buffer long
+ * sequences of frames, like reverse or loop.
+ *
+ * The frames are kept in memory up to a given amount of frame data, the
+ * oldest frames are then moved to a temporary file and read back on access.
+ * Hardware frames always stay in memory.
+ */
+
+#include <stdint.h>
+
+#include "libavutil/frame.h"
+
+typedef struct FFFrameStore FFFrameStore;
+
+/**
+ * Allocate a frame store.
+ *
+ * @param log_ctx     context used for logging
+ * @param max_memory  maximum size in bytes of the frame data kept in memory,
+ *                    0 for no limit
+ * @return the store or NULL on allocation failure
+ */
+FFFrameStore *ff_framestore_alloc(void *log_ctx, int64_t max_memory);
+
+/**
+ * Free the store, all stored frames and the temporary file.
+ */
+void ff_framestore_free(FFFrameStore **fs);
+
+/**
+ * Number of frames in the store.
+ */
+int ff_framestore_nb_frames(const FFFrameStore *fs);
+
+/**
+ * Add a frame at the end of the store, the store takes ownership of the
+ * frame in all cases.
+ *
+ * @return >= 0 or an AVERROR code, in which case the frame was freed
+ *         without being added to the store
+ */
+int ff_framestore_add(FFFrameStore *fs, AVFrame *frame);
+
+/**
+ * Get a reference to a frame of the store, the frame stays in the store.
+ *
+ * @param idx   index of the frame, the first frame added is numbered 0
+ * @param frame set to a new frame that must be freed by the caller
+ * @return >= 0 or an AVERROR code
+ */
+int ff_framestore_get(FFFrameStore *fs, int idx, AVFrame **frame);
+
+/**
+ * Remove the last frame of the store and return it.
+ *
+ * @param frame set to the frame, which must be freed by the caller
+ * @return >= 0 or an AVERROR code
+ */
+int ff_framestore_take_last(FFFrameStore *fs, AVFrame **frame);
+
+#endif /* AVFILTER_FRAMESTORE_H */
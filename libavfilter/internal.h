@@ -149,6 +149,7 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+    FFFramePoolList frame_pools;
 };
 
 struct AVFilterInternal {
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2013 Clément Bœsch
+ * Copyright (c) 2018 Paul B Mahol
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_LUT3D_H
+#define AVFILTER_LUT3D_H
+
+#include <stdint.h>
+
+enum interp_mode {
+    INTERPOLATE_NEAREST,
+    INTERPOLATE_TRILINEAR,
+    INTERPOLATE_TETRAHEDRAL,
+    NB_INTERP_MODE
+};
+
+struct rgbvec {
+    float r, g, b;
+};
+
+/* 3D LUT don't often go up to level 32, but it is common to have a Hald CLUT
+ * of 512x512 (64x64x64) */
+#define MAX_LEVEL 128
+
+typedef struct LUT3DDSPContext {
+    /**
+     * Map a row of planar RGB pixels through the 3D LUT.
+     *
+     * @param dst     r, g and b destination rows
+     * @param src     r, g and b source rows
+     * @param width   number of pixels, must be a multiple of 8
+     * @param lut     the 3D LUT, indexed as lut[r][g][b]
+     * @param lutsize number of points along each dimension of the LUT
+     * @param scale   factors mapping the r, g and b pixel values to LUT
+     *                coordinates, followed by the maximum pixel value
+     */
+    void (*interp_row)(uint8_t *const dst[3], const uint8_t *const src[3], int width,
+                       const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL], int lutsize,
+                       const float *scale);
+
+    /**
+     * Set when interp_row is fast enough for packed pixels to be worth
+     * deinterleaving into planar rows for it. Left 0 by the C versions.
+     */
+    int deinterleave_packed;
+} LUT3DDSPContext;
+
+/**
+ * Set the row function for the given interpolation mode and sample size
+ * (8 or 16 bits). The C version is set first and replaced by a SIMD one
+ * where available. interp_row is left NULL for the nearest mode.
+ */
+void ff_lut3d_init_dsp(LUT3DDSPContext *dsp, int interpolation, int nbits);
+void ff_lut3d_init_dsp_x86(LUT3DDSPContext *dsp, int interpolation, int nbits);
+
+#endif /* AVFILTER_LUT3D_H */
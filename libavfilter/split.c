@@ -77,17 +77,29 @@ static av_cold void split_uninit(AVFilterContext *ctx)
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     AVFilterContext *ctx = inlink->dst;
-    int i, ret = AVERROR_EOF;
+    int i, last, ret = AVERROR_EOF;
 
-    for (i = 0; i < ctx->nb_outputs; i++) {
+    for (last = ctx->nb_outputs - 1; last >= 0; last--)
+        if (!ff_outlink_get_status(ctx->outputs[last]))
+            break;
+
+    for (i = 0; i <= last; i++) {
         AVFrame *buf_out;
 
         if (ff_outlink_get_status(ctx->outputs[i]))
             continue;
-        buf_out = av_frame_clone(frame);
-        if (!buf_out) {
-            ret = AVERROR(ENOMEM);
-            break;
+
+        /* hand the input frame over to the last output instead of
+         * cloning it one more time */
+        if (i == last) {
+            buf_out = frame;
+            frame   = NULL;
+        } else {
+            buf_out = av_frame_clone(frame);
+            if (!buf_out) {
+                ret = AVERROR(ENOMEM);
+                break;
+            }
         }
 
         ret = ff_filter_frame(ctx->outputs[i], buf_out);
@@ -0,0 +1,126 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Prints the conversion filters the format negotiation inserts with the
+ * alias_formats graph option, and checksums of the frames output through
+ * aliasformat. The output of scale may depend on the CPU and is not shown.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/frame.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+static const struct {
+    const char *desc;
+    int alias_formats;
+} tests[] = {
+    { "format=yuvj420p,format=yuv420p",     0 },
+    { "format=yuvj420p,format=yuv420p",     1 },
+    { "format=yuvj444p,format=yuv444p",     1 },
+    { "format=nv12,format=gray",            1 },
+    { "format=yuv420p10le,format=gray10le", 1 },
+    { "format=rgb24,format=gray",           1 },
+};
+
+static void print_frame(const AVFrame *frame)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    int p, y;
+
+    printf("  pts %"PRId64" %s %s", frame->pts, desc->name,
+           av_color_range_name(frame->color_range));
+    for (p = 0; p < av_pix_fmt_count_planes(frame->format); p++) {
+        int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                                 : frame->height;
+        int w = av_image_get_linesize(frame->format, frame->width, p);
+        unsigned long sum = 0;
+
+        for (y = 0; y < h; y++)
+            sum = av_adler32_update(sum, frame->data[p] + y * frame->linesize[p], w);
+        printf(" %08lx", sum);
+    }
+    printf("\n");
+}
+
+static int run_test(const char *chain, int alias_formats)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *sink = NULL;
+    AVFrame *frame = av_frame_alloc();
+    char desc[256];
+    int i, ret, aliased = 0;
+
+    printf("%s, alias_formats=%d\n", chain, alias_formats);
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    snprintf(desc, sizeof(desc), "testsrc2=s=160x90:r=25:d=0.12,%s,buffersink", chain);
+    if ((ret = av_opt_set_int(graph, "alias_formats", alias_formats, 0)) < 0 ||
+        (ret = avfilter_graph_parse_ptr(graph, desc, NULL, NULL, NULL)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        if (!strcmp(f->filter->name, "buffersink"))
+            sink = f;
+        if (!strcmp(f->filter->name, "aliasformat"))
+            aliased = 1;
+        if (!strncmp(f->name, "auto_", 5))
+            printf("  %s: %s -> %s\n", f->filter->name,
+                   av_get_pix_fmt_name(f->inputs[0]->format),
+                   av_get_pix_fmt_name(f->outputs[0]->format));
+    }
+
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        if (aliased)
+            print_frame(frame);
+        av_frame_unref(frame);
+    }
+    if (ret == AVERROR_EOF)
+        ret = 0;
+
+end:
+    if (ret < 0)
+        printf("  error: %s\n", av_err2str(ret));
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+int main(void)
+{
+    int i, ret = 0;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(tests); i++)
+        if (run_test(tests[i].desc, tests[i].alias_formats) < 0)
+            ret = 1;
+
+    return ret;
+}
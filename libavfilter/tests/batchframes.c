@@ -0,0 +1,272 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Moves frames through buffer -> buffersink graphs with
+ * av_buffersrc_add_frames() and av_buffersink_get_frames(), and prints what
+ * the calls return.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/samplefmt.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#define MAX_FRAMES      16
+#define AUDIO_SAMPLES   256
+
+typedef struct Graph {
+    AVFilterGraph *graph;
+    AVFilterContext *src, *sink;
+} Graph;
+
+static const char *ret_str(int ret)
+{
+    static char buf[AV_ERROR_MAX_STRING_SIZE];
+
+    if (ret >= 0) {
+        snprintf(buf, sizeof(buf), "%d", ret);
+        return buf;
+    }
+    if (ret == AVERROR(EAGAIN))
+        return "EAGAIN";
+    if (ret == AVERROR_EOF)
+        return "EOF";
+    if (ret == AVERROR(EINVAL))
+        return "EINVAL";
+    return av_make_error_string(buf, sizeof(buf), ret);
+}
+
+static int graph_init(Graph *g, enum AVMediaType type)
+{
+    const char *src_name  = type == AVMEDIA_TYPE_VIDEO ? "buffer"     : "abuffer";
+    const char *sink_name = type == AVMEDIA_TYPE_VIDEO ? "buffersink" : "abuffersink";
+    const char *src_args  = type == AVMEDIA_TYPE_VIDEO ?
+        "video_size=16x16:pix_fmt=gray:time_base=1/25" :
+        "sample_rate=8000:sample_fmt=s16:channel_layout=mono:time_base=1/8000";
+    int ret;
+
+    g->graph = avfilter_graph_alloc();
+    if (!g->graph)
+        return AVERROR(ENOMEM);
+
+    if ((ret = avfilter_graph_create_filter(&g->src, avfilter_get_by_name(src_name),
+                                            "src", src_args, NULL, g->graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(&g->sink, avfilter_get_by_name(sink_name),
+                                            "sink", NULL, NULL, g->graph)) < 0 ||
+        (ret = avfilter_link(g->src, 0, g->sink, 0)) < 0)
+        return ret;
+
+    return avfilter_graph_config(g->graph, NULL);
+}
+
+static AVFrame *make_frame(enum AVMediaType type, int64_t pts)
+{
+    AVFrame *frame = av_frame_alloc();
+
+    if (!frame)
+        return NULL;
+
+    frame->pts = pts;
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        frame->format = AV_PIX_FMT_GRAY8;
+        frame->width  = 16;
+        frame->height = 16;
+    } else {
+        frame->format         = AV_SAMPLE_FMT_S16;
+        frame->channel_layout = AV_CH_LAYOUT_MONO;
+        frame->channels       = 1;
+        frame->sample_rate    = 8000;
+        frame->nb_samples     = AUDIO_SAMPLES;
+    }
+
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+
+    if (type == AVMEDIA_TYPE_VIDEO) {
+        frame->data[0][0] = pts;
+    } else {
+        int16_t *samples = (int16_t *)frame->data[0];
+        int i;
+
+        for (i = 0; i < AUDIO_SAMPLES; i++)
+            samples[i] = pts + i;
+    }
+
+    return frame;
+}
+
+/* the frame at index skip is left NULL, to close the source */
+static int make_frames(enum AVMediaType type, AVFrame **frames, int nb_frames,
+                       int64_t pts_step, int skip)
+{
+    int i;
+
+    for (i = 0; i < nb_frames; i++) {
+        if (i == skip) {
+            frames[i] = NULL;
+            continue;
+        }
+        frames[i] = make_frame(type, i * pts_step);
+        if (!frames[i])
+            return AVERROR(ENOMEM);
+    }
+    return 0;
+}
+
+static void free_frames(AVFrame **frames, int nb_frames)
+{
+    int i;
+
+    for (i = 0; i < nb_frames; i++)
+        av_frame_free(&frames[i]);
+}
+
+/* pull batches of batch_size frames until the sink returns an error */
+static int pull_batches(Graph *g, int batch_size)
+{
+    AVFrame *frames[MAX_FRAMES] = { NULL };
+    int i, ret;
+
+    for (i = 0; i < batch_size; i++)
+        if (!(frames[i] = av_frame_alloc()))
+            return AVERROR(ENOMEM);
+
+    do {
+        ret = av_buffersink_get_frames(g->sink, frames, batch_size, 0);
+        printf("  get_frames(%d): %s\n", batch_size, ret_str(ret));
+        for (i = 0; i < ret; i++) {
+            const AVFrame *f = frames[i];
+
+            if (f->nb_samples)
+                printf("    pts %"PRId64" samples %d first %d\n", f->pts,
+                       f->nb_samples, ((const int16_t *)f->data[0])[0]);
+            else
+                printf("    pts %"PRId64" first %d\n", f->pts, f->data[0][0]);
+            av_frame_unref(frames[i]);
+        }
+    } while (ret > 0);
+
+    free_frames(frames, batch_size);
+    return ret == AVERROR(EAGAIN) || ret == AVERROR_EOF ? 0 : ret;
+}
+
+static int test_video_batches(void)
+{
+    AVFrame *frames[10] = { NULL };
+    Graph g = { 0 };
+    int ret;
+
+    printf("video, 10 frames pushed at once, pulled 4 by 4\n");
+    if ((ret = graph_init(&g, AVMEDIA_TYPE_VIDEO)) < 0 ||
+        (ret = make_frames(AVMEDIA_TYPE_VIDEO, frames, 10, 1, -1)) < 0)
+        goto end;
+
+    ret = av_buffersrc_add_frames(g.src, frames, 10, AV_BUFFERSRC_FLAG_PUSH);
+    printf("  add_frames(10): %s\n", ret_str(ret));
+    if (ret < 0 || (ret = pull_batches(&g, 4)) < 0)
+        goto end;
+
+    ret = av_buffersrc_add_frame(g.src, NULL);
+    if (ret >= 0)
+        ret = pull_batches(&g, 4);
+
+end:
+    free_frames(frames, 10);
+    avfilter_graph_free(&g.graph);
+    return ret;
+}
+
+static int test_video_closed(void)
+{
+    AVFrame *frames[5] = { NULL };
+    Graph g = { 0 };
+    int ret;
+
+    printf("video, source closed in the middle of a batch\n");
+    if ((ret = graph_init(&g, AVMEDIA_TYPE_VIDEO)) < 0 ||
+        (ret = make_frames(AVMEDIA_TYPE_VIDEO, frames, 5, 1, 2)) < 0)
+        goto end;
+
+    /* the frames after the NULL one are rejected */
+    ret = av_buffersrc_add_frames(g.src, frames, 5, 0);
+    printf("  add_frames(5): %s\n", ret_str(ret));
+    if (ret < 0)
+        goto end;
+    printf("  frame 3 left to the caller: %s\n", frames[3]->buf[0] ? "yes" : "no");
+
+    /* nothing can be added any more */
+    ret = av_buffersrc_add_frames(g.src, frames + 3, 2, 0);
+    printf("  add_frames(2): %s\n", ret_str(ret));
+
+    ret = pull_batches(&g, 8);
+
+end:
+    free_frames(frames, 5);
+    avfilter_graph_free(&g.graph);
+    return ret;
+}
+
+static int test_audio_frame_size(void)
+{
+    AVFrame *frames[4] = { NULL };
+    Graph g = { 0 };
+    int ret;
+
+    printf("audio, 4 frames of %d samples pulled as frames of 300\n", AUDIO_SAMPLES);
+    if ((ret = graph_init(&g, AVMEDIA_TYPE_AUDIO)) < 0 ||
+        (ret = make_frames(AVMEDIA_TYPE_AUDIO, frames, 4, AUDIO_SAMPLES, -1)) < 0)
+        goto end;
+    av_buffersink_set_frame_size(g.sink, 300);
+
+    ret = av_buffersrc_add_frames(g.src, frames, 4, 0);
+    printf("  add_frames(4): %s\n", ret_str(ret));
+    if (ret < 0 || (ret = pull_batches(&g, 8)) < 0)
+        goto end;
+
+    ret = av_buffersrc_add_frame(g.src, NULL);
+    if (ret >= 0)
+        ret = pull_batches(&g, 8);
+
+end:
+    free_frames(frames, 4);
+    avfilter_graph_free(&g.graph);
+    return ret;
+}
+
+int main(void)
+{
+    int ret;
+
+    if ((ret = test_video_batches()) < 0 ||
+        (ret = test_video_closed()) < 0 ||
+        (ret = test_audio_frame_size()) < 0) {
+        fprintf(stderr, "Test failed: %s\n", ret_str(ret));
+        return 1;
+    }
+
+    return 0;
+}
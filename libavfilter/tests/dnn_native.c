@@ -0,0 +1,279 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Compares the CONV layers of the native DNN backend with a naive
+ * convolution. With an iteration count as argument, it times an ESPCN-like
+ * model instead.
+ */
+
+#include "libavfilter/dnn_backend_native.c"
+#include "libavutil/lfg.h"
+#include "libavutil/time.h"
+
+typedef struct LayerDesc {
+    int input_num, output_num, kernel_size, dilation;
+    DNNActivationFunc activation;
+    DNNConvPaddingParam padding_method;
+} LayerDesc;
+
+// the convolution as it was done before the layers were sliced and vectorized
+static void convolve_ref(const float *input, float *output, const ConvolutionalParams *conv_params, int width, int height)
+{
+    int radius = conv_params->kernel_size >> 1;
+    int src_linesize = width * conv_params->input_num;
+    int filter_linesize = conv_params->kernel_size * conv_params->input_num;
+    int filter_size = conv_params->kernel_size * filter_linesize;
+    int pad_size = (conv_params->padding_method == VALID) ? (conv_params->kernel_size - 1) / 2 * conv_params->dilation : 0;
+
+    for (int y = pad_size; y < height - pad_size; ++y) {
+        for (int x = pad_size; x < width - pad_size; ++x) {
+            for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter) {
+                output[n_filter] = conv_params->biases[n_filter];
+
+                for (int ch = 0; ch < conv_params->input_num; ++ch) {
+                    for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
+                        for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
+                            float input_pel;
+                            if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
+                                int y_pos = CLAMP_TO_EDGE(y + (kernel_y - radius) * conv_params->dilation, height);
+                                int x_pos = CLAMP_TO_EDGE(x + (kernel_x - radius) * conv_params->dilation, width);
+                                input_pel = input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
+                            } else {
+                                int y_pos = y + (kernel_y - radius) * conv_params->dilation;
+                                int x_pos = x + (kernel_x - radius) * conv_params->dilation;
+                                input_pel = (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) ? 0.0 :
+                                                   input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
+                            }
+
+                            output[n_filter] += input_pel * conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
+                                                                                kernel_x * conv_params->input_num + ch];
+                        }
+                    }
+                }
+                switch (conv_params->activation){
+                case RELU:
+                    output[n_filter] = FFMAX(output[n_filter], 0.0);
+                    break;
+                case TANH:
+                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * output[n_filter])) - 1.0f;
+                    break;
+                case SIGMOID:
+                    output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
+                    break;
+                case NONE:
+                    break;
+                case LEAKY_RELU:
+                    output[n_filter] = FFMAX(output[n_filter], 0.0) + 0.2 * FFMIN(output[n_filter], 0.0);
+                }
+            }
+            output += conv_params->output_num;
+        }
+    }
+}
+
+static float random_float(AVLFG *lfg)
+{
+    return av_lfg_get(lfg) / (float)UINT_MAX * 2.0f - 1.0f;
+}
+
+// builds the network the same way as ff_dnn_load_model_native() does
+static DNNModel *create_model(AVLFG *lfg, const LayerDesc *desc, int nb_layers)
+{
+    DNNModel *model = av_mallocz(sizeof(*model));
+    ConvolutionalNetwork *network = av_mallocz(sizeof(*network));
+    int i, layer;
+
+    if (!model || !network)
+        goto fail;
+    model->model = network;
+
+    network->layers = av_mallocz_array(1 + nb_layers, sizeof(*network->layers));
+    if (!network->layers)
+        goto fail;
+    network->layers_num = 1 + nb_layers;
+    network->layers[0].type = INPUT;
+    network->layers[0].params = av_mallocz(sizeof(InputParams));
+    if (!network->layers[0].params)
+        goto fail;
+
+    for (layer = 1; layer < network->layers_num; ++layer){
+        const LayerDesc *d = &desc[layer - 1];
+        int kernel_size = d->input_num * d->output_num * d->kernel_size * d->kernel_size;
+        ConvolutionalParams *conv_params = av_mallocz(sizeof(*conv_params));
+
+        network->layers[layer].type = CONV;
+        network->layers[layer].params = conv_params;
+        if (!conv_params)
+            goto fail;
+        conv_params->input_num = d->input_num;
+        conv_params->output_num = d->output_num;
+        conv_params->kernel_size = d->kernel_size;
+        conv_params->dilation = d->dilation;
+        conv_params->activation = d->activation;
+        conv_params->padding_method = d->padding_method;
+        conv_params->kernel = av_malloc_array(kernel_size, sizeof(float));
+        conv_params->biases = av_malloc_array(d->output_num, sizeof(float));
+        if (!conv_params->kernel || !conv_params->biases)
+            goto fail;
+        for (i = 0; i < kernel_size; ++i)
+            conv_params->kernel[i] = random_float(lfg) / d->kernel_size;
+        for (i = 0; i < d->output_num; ++i)
+            conv_params->biases[i] = random_float(lfg) * 0.1f;
+    }
+
+    if (init_slice_threads(network, 0) < 0)
+        goto fail;
+    model->set_input_output = &set_input_output_native;
+
+    return model;
+fail:
+    if (network && network->layers) {
+        ff_dnn_free_model_native(&model);
+        return NULL;
+    }
+    av_free(model);
+    av_free(network);
+    return NULL;
+}
+
+static int run_model(DNNModel *model, AVLFG *lfg, int width, int height, int channels,
+                     DNNData *output)
+{
+    DNNInputData input = { .dt = DNN_FLOAT, .width = width, .height = height, .channels = channels };
+    float *data;
+
+    if (model->set_input_output(model->model, &input, "x", NULL, 0) != DNN_SUCCESS)
+        return -1;
+    data = input.data;
+    for (int i = 0; i < width * height * channels; ++i)
+        data[i] = (random_float(lfg) + 1.0f) * 0.5f;
+
+    if (ff_dnn_execute_model_native(model, output, 1) != DNN_SUCCESS)
+        return -1;
+
+    return 0;
+}
+
+static int test_layer(AVLFG *lfg, const LayerDesc *desc, int width, int height)
+{
+    DNNModel *model = create_model(lfg, desc, 1);
+    ConvolutionalNetwork *network;
+    DNNData output;
+    float *ref = NULL;
+    int size, ret = 1;
+
+    if (!model)
+        return 1;
+    network = model->model;
+
+    if (run_model(model, lfg, width, height, desc->input_num, &output) < 0)
+        goto end;
+
+    size = output.width * output.height * output.channels;
+    ref = av_malloc_array(size, sizeof(*ref));
+    if (!ref)
+        goto end;
+    convolve_ref(network->layers[0].output, ref, network->layers[1].params, width, height);
+
+    for (int i = 0; i < size; ++i) {
+        if (fabsf(output.data[i] - ref[i]) > 1e-5f * FFMAX(fabsf(ref[i]), 1.0f)) {
+            printf("mismatch at %d: %f != %f\n", i, output.data[i], ref[i]);
+            goto end;
+        }
+    }
+    ret = 0;
+
+end:
+    printf("conv %dx%d %d->%d dilation %d activation %d padding %d: %s\n",
+           desc->kernel_size, desc->kernel_size, desc->input_num, desc->output_num,
+           desc->dilation, desc->activation, desc->padding_method, ret ? "FAIL" : "OK");
+    av_free(ref);
+    ff_dnn_free_model_native(&model);
+    return ret;
+}
+
+static int benchmark(AVLFG *lfg, int iterations)
+{
+    // the CONV layers of the ESPCN model used by the sr filter
+    static const LayerDesc espcn[] = {
+        { 1,  64, 5, 1, TANH,    SAME_CLAMP_TO_EDGE },
+        { 64, 32, 3, 1, TANH,    SAME_CLAMP_TO_EDGE },
+        { 32,  4, 3, 1, SIGMOID, SAME_CLAMP_TO_EDGE },
+    };
+    const int width = 480, height = 270;
+    DNNModel *model = create_model(lfg, espcn, FF_ARRAY_ELEMS(espcn));
+    ConvolutionalNetwork *network;
+    DNNData output;
+    float *ref = NULL;
+    int64_t t;
+
+    if (!model)
+        return 1;
+    network = model->model;
+
+    t = av_gettime_relative();
+    for (int i = 0; i < iterations; ++i) {
+        if (run_model(model, lfg, width, height, 1, &output) < 0) {
+            ff_dnn_free_model_native(&model);
+            return 1;
+        }
+    }
+    t = av_gettime_relative() - t;
+    printf("espcn %dx%d, %d threads: %.2f ms per frame\n", width, height,
+           network->nb_threads, t / 1000.0 / iterations);
+
+    ref = av_malloc_array(width * height * 64, sizeof(*ref));
+    if (ref) {
+        t = av_gettime_relative();
+        convolve_ref(network->layers[0].output, ref, network->layers[1].params, width, height);
+        convolve_ref(network->layers[1].output, ref, network->layers[2].params, width, height);
+        convolve_ref(network->layers[2].output, ref, network->layers[3].params, width, height);
+        t = av_gettime_relative() - t;
+        printf("espcn %dx%d, naive convolution: %.2f ms per frame\n", width, height, t / 1000.0);
+    }
+
+    av_free(ref);
+    ff_dnn_free_model_native(&model);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const LayerDesc layers[] = {
+        { 1,  64, 5, 1, TANH,       SAME_CLAMP_TO_EDGE },
+        { 64, 32, 3, 1, RELU,       SAME_CLAMP_TO_EDGE },
+        { 32,  4, 3, 1, SIGMOID,    SAME_CLAMP_TO_EDGE },
+        { 3,  17, 3, 2, LEAKY_RELU, SAME },
+        { 5,   1, 5, 1, NONE,       SAME },
+        { 6,  12, 3, 2, RELU,       VALID },
+        { 4,   8, 1, 1, TANH,       VALID },
+    };
+    AVLFG lfg;
+    int ret = 0;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    if (argc > 1)
+        return benchmark(&lfg, FFMAX(atoi(argv[1]), 1));
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(layers); ++i)
+        ret |= test_layer(&lfg, &layers[i], 23, 17);
+
+    return ret;
+}
@@ -0,0 +1,66 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_TONEMAP_H
+#define AVFILTER_TONEMAP_H
+
+enum TonemapAlgorithm {
+    TONEMAP_NONE,
+    TONEMAP_LINEAR,
+    TONEMAP_GAMMA,
+    TONEMAP_CLIP,
+    TONEMAP_REINHARD,
+    TONEMAP_HABLE,
+    TONEMAP_MOBIUS,
+    TONEMAP_MAX,
+};
+
+/**
+ * Number of constants used by the tonemap functions: the luma coefficients
+ * of the 3 planes, the desaturation strength (0 disables the desaturation)
+ * and the parameters of the curve, see ff_tonemap_init_consts().
+ */
+#define TONEMAP_NB_CONSTS 12
+
+typedef struct TonemapDSPContext {
+    /**
+     * Tonemap a row of float pixels.
+     *
+     * @param dst   the 3 destination planes
+     * @param src   the 3 source planes, in the order of the luma coefficients
+     * @param width number of pixels
+     * @param c     constants filled by ff_tonemap_init_consts()
+     */
+    void (*tonemap)(float *const dst[3], const float *const src[3], int width,
+                    const float *c);
+} TonemapDSPContext;
+
+/**
+ * Fill the TONEMAP_NB_CONSTS constants of the tonemap functions.
+ *
+ * @param luma  luma coefficients of the 3 planes, NULL disables the
+ *              desaturation
+ */
+void ff_tonemap_init_consts(float *c, enum TonemapAlgorithm algo,
+                            const double *luma, double desat,
+                            double param, double peak);
+
+void ff_tonemap_init_dsp(TonemapDSPContext *dsp, enum TonemapAlgorithm algo);
+void ff_tonemap_init_dsp_x86(TonemapDSPContext *dsp, enum TonemapAlgorithm algo);
+
+#endif /* AVFILTER_TONEMAP_H */
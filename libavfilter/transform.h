@@ -124,4 +124,16 @@ int avfilter_transform(const uint8_t *src, uint8_t *dst,
                         enum InterpolateMethod interpolate,
                         enum FillMethod fill);
 
+/**
+ * Same as avfilter_transform(), but only write the destination lines
+ * [slice_start, slice_end). The whole source image may be read.
+ */
+int avfilter_transform_slice(const uint8_t *src, uint8_t *dst,
+                             int src_stride, int dst_stride,
+                             int width, int height,
+                             int slice_start, int slice_end,
+                             const float *matrix,
+                             enum InterpolateMethod interpolate,
+                             enum FillMethod fill);
+
 #endif /* AVFILTER_TRANSFORM_H */
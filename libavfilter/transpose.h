@@ -18,6 +18,9 @@
 #ifndef AVFILTER_TRANSPOSE_H
 #define AVFILTER_TRANSPOSE_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 enum PassthroughType {
     TRANSPOSE_PT_TYPE_NONE,
     TRANSPOSE_PT_TYPE_LANDSCAPE,
@@ -34,4 +37,15 @@ enum TransposeDir {
     TRANSPOSE_VFLIP,
 };
 
+typedef struct TransVtable {
+    void (*transpose_8x8)(uint8_t *src, ptrdiff_t src_linesize,
+                          uint8_t *dst, ptrdiff_t dst_linesize);
+    void (*transpose_block)(uint8_t *src, ptrdiff_t src_linesize,
+                            uint8_t *dst, ptrdiff_t dst_linesize,
+                            int w, int h);
+} TransVtable;
+
+void ff_transpose_init(TransVtable *v, int pixstep);
+void ff_transpose_init_x86(TransVtable *v, int pixstep);
+
 #endif
@@ -0,0 +1,164 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "truepeak.h"
+
+#define TAPS       49   ///< length of the interpolation filter
+#define MAX_FACTOR 4
+#define BLOCK      1024 ///< samples of a channel interpolated at once
+
+struct FFTruePeakContext {
+    int channels;
+    int factor;         ///< oversampling factor
+    int phase_taps;     ///< taps of each phase of the interpolator
+    double *coeffs;     ///< phase_taps x factor, the phases of a tap side by side
+    double *history;    ///< last phase_taps - 1 input samples of each channel
+    double *buf;        ///< history and a block of one channel, contiguous
+    FFTruePeakDSPContext dsp;
+};
+
+FFTruePeakContext *ff_truepeak_alloc(int channels, int sample_rate)
+{
+    FFTruePeakContext *tp = av_mallocz(sizeof(*tp));
+    int i, f, k;
+
+    if (!tp)
+        return NULL;
+
+    tp->channels   = channels;
+    tp->factor     = sample_rate < 96000 ? 4 : sample_rate < 192000 ? 2 : 1;
+    tp->phase_taps = (TAPS + tp->factor - 1) / tp->factor;
+    tp->coeffs     = av_calloc(tp->phase_taps * tp->factor, sizeof(*tp->coeffs));
+    tp->history    = av_calloc(channels * tp->phase_taps, sizeof(*tp->history));
+    tp->buf        = av_calloc(tp->phase_taps + BLOCK, sizeof(*tp->buf));
+    if (!tp->coeffs || !tp->history || !tp->buf) {
+        ff_truepeak_free(&tp);
+        return NULL;
+    }
+
+    /* Hann windowed sinc, cut at the input Nyquist frequency. Tap
+     * i = k * factor + f belongs to phase f and applies to the input sample
+     * k periods in the past, stored in reverse order so that every output
+     * is a dot product with consecutive input samples. */
+    for (i = 0; i < TAPS; i++) {
+        const double m = i - (TAPS - 1) / 2.0;
+        double c = 1.0;
+
+        if (fabs(m) > 1e-6)
+            c = sin(m * M_PI / tp->factor) / (m * M_PI / tp->factor);
+        c *= 0.5 * (1 - cos(2 * M_PI * i / (TAPS - 1)));
+
+        k = i / tp->factor;
+        f = i % tp->factor;
+        tp->coeffs[(tp->phase_taps - 1 - k) * tp->factor + f] = c;
+    }
+
+    ff_truepeak_init_dsp(&tp->dsp);
+
+    return tp;
+}
+
+static av_always_inline double interpolate_peak(const double *coeffs, const double *x,
+                                                int nb_samples, int phase_taps,
+                                                const int factor)
+{
+    double peak = 0.0;
+    int i, k, f;
+
+    for (i = 0; i < nb_samples; i++) {
+        const double *c = coeffs;
+        double acc[MAX_FACTOR] = { 0.0 };
+
+        for (k = 0; k < phase_taps; k++, c += factor)
+            for (f = 0; f < factor; f++)
+                acc[f] += c[f] * x[i + k];
+        for (f = 0; f < factor; f++)
+            peak = FFMAX(peak, fabs(acc[f]));
+    }
+
+    return peak;
+}
+
+static double interpolate_peak4_c(const double *coeffs, const double *x,
+                                  int nb_samples, int phase_taps)
+{
+    return interpolate_peak(coeffs, x, nb_samples, phase_taps, 4);
+}
+
+av_cold void ff_truepeak_init_dsp(FFTruePeakDSPContext *dsp)
+{
+    dsp->interpolate_peak4 = interpolate_peak4_c;
+
+    if (ARCH_X86)
+        ff_truepeak_init_dsp_x86(dsp);
+}
+
+void ff_truepeak_process(FFTruePeakContext *tp, double *peaks,
+                         const double *samples, int nb_samples)
+{
+    const int channels = tp->channels;
+    const int nb_history = tp->phase_taps - 1;
+    int ch, i, offset;
+
+    if (tp->factor == 1) {
+        for (i = 0; i < nb_samples; i++)
+            for (ch = 0; ch < channels; ch++)
+                peaks[ch] = FFMAX(peaks[ch], fabs(samples[i * channels + ch]));
+        return;
+    }
+
+    for (offset = 0; offset < nb_samples; offset += BLOCK) {
+        const int n = FFMIN(BLOCK, nb_samples - offset);
+        const double *src = samples + offset * channels;
+
+        for (ch = 0; ch < channels; ch++) {
+            double *history = tp->history + ch * tp->phase_taps;
+            double *x = tp->buf;
+            double peak;
+
+            memcpy(x, history, nb_history * sizeof(*x));
+            for (i = 0; i < n; i++)
+                x[nb_history + i] = src[i * channels + ch];
+
+            if (tp->factor == 4)
+                peak = tp->dsp.interpolate_peak4(tp->coeffs, x, n, tp->phase_taps);
+            else
+                peak = interpolate_peak(tp->coeffs, x, n, tp->phase_taps, 2);
+            peaks[ch] = FFMAX(peaks[ch], peak);
+
+            memcpy(history, x + n, nb_history * sizeof(*x));
+        }
+    }
+}
+
+void ff_truepeak_free(FFTruePeakContext **tp)
+{
+    if (!*tp)
+        return;
+    av_freep(&(*tp)->coeffs);
+    av_freep(&(*tp)->history);
+    av_freep(&(*tp)->buf);
+    av_freep(tp);
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_TRUEPEAK_H
+#define AVFILTER_TRUEPEAK_H
+
+/**
+ * @file
+ * True peak meter as specified by ITU-R BS.1770, Annex 2: the signal is
+ * oversampled by a polyphase interpolator and the peaks are measured on the
+ * interpolated samples.
+ */
+
+typedef struct FFTruePeakContext FFTruePeakContext;
+
+typedef struct FFTruePeakDSPContext {
+    /**
+     * Oversample a channel 4 times and return its peak.
+     *
+     * @param coeffs     the 4 phases of each of the phase_taps taps, side by
+     *                   side, the tap of the oldest input sample first
+     * @param x          nb_samples + phase_taps - 1 input samples
+     * @param nb_samples number of input samples to interpolate
+     * @return the maximum absolute value of the interpolated samples
+     */
+    double (*interpolate_peak4)(const double *coeffs, const double *x,
+                                int nb_samples, int phase_taps);
+} FFTruePeakDSPContext;
+
+void ff_truepeak_init_dsp(FFTruePeakDSPContext *dsp);
+void ff_truepeak_init_dsp_x86(FFTruePeakDSPContext *dsp);
+
+/**
+ * Allocate a true peak meter. The signal is oversampled 4 times below 96kHz,
+ * 2 times below 192kHz and left untouched above.
+ *
+ * @return the meter, or NULL on allocation failure
+ */
+FFTruePeakContext *ff_truepeak_alloc(int channels, int sample_rate);
+
+/**
+ * Oversample interleaved double samples and measure their peaks.
+ *
+ * @param peaks      maximum absolute value of each channel, updated with the
+ *                   interpolated samples
+ * @param samples    interleaved input samples
+ * @param nb_samples number of samples per channel
+ */
+void ff_truepeak_process(FFTruePeakContext *tp, double *peaks,
+                         const double *samples, int nb_samples);
+
+void ff_truepeak_free(FFTruePeakContext **tp);
+
+#endif /* AVFILTER_TRUEPEAK_H */
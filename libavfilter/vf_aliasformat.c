@@ -0,0 +1,150 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * reinterpret frames in a layout-compatible pixel format, without copying
+ */
+
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "formats.h"
+#include "internal.h"
+#include "video.h"
+
+typedef struct AliasFormatContext {
+    const AVClass *class;
+    enum AVPixelFormat src_fmt;
+    enum AVPixelFormat dst_fmt;
+    int src_jpeg;               ///< the input format is a full range yuvj one
+    int nb_planes;              ///< number of planes kept in the output
+} AliasFormatContext;
+
+#define OFFSET(x) offsetof(AliasFormatContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
+
+static const AVOption aliasformat_options[] = {
+    { "src", "set the input pixel format",  OFFSET(src_fmt), AV_OPT_TYPE_PIXEL_FMT, {.i64=AV_PIX_FMT_NONE}, -1, INT_MAX, FLAGS },
+    { "dst", "set the output pixel format", OFFSET(dst_fmt), AV_OPT_TYPE_PIXEL_FMT, {.i64=AV_PIX_FMT_NONE}, -1, INT_MAX, FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(aliasformat);
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    AliasFormatContext *s = ctx->priv;
+
+    if (s->src_fmt == AV_PIX_FMT_NONE || s->dst_fmt == AV_PIX_FMT_NONE) {
+        av_log(ctx, AV_LOG_ERROR, "Both src and dst pixel formats must be set.\n");
+        return AVERROR(EINVAL);
+    }
+
+    if (!ff_pix_fmt_can_alias(s->src_fmt, s->dst_fmt)) {
+        av_log(ctx, AV_LOG_ERROR, "Pixel format %s can not be reinterpreted as %s.\n",
+               av_get_pix_fmt_name(s->src_fmt), av_get_pix_fmt_name(s->dst_fmt));
+        return AVERROR(EINVAL);
+    }
+
+    s->src_jpeg  = s->src_fmt == AV_PIX_FMT_YUVJ411P ||
+                   s->src_fmt == AV_PIX_FMT_YUVJ420P ||
+                   s->src_fmt == AV_PIX_FMT_YUVJ422P ||
+                   s->src_fmt == AV_PIX_FMT_YUVJ440P ||
+                   s->src_fmt == AV_PIX_FMT_YUVJ444P;
+    s->nb_planes = av_pix_fmt_count_planes(s->dst_fmt);
+
+    return 0;
+}
+
+static int query_formats(AVFilterContext *ctx)
+{
+    AliasFormatContext *s = ctx->priv;
+    int src_fmts[] = { s->src_fmt, AV_PIX_FMT_NONE };
+    int dst_fmts[] = { s->dst_fmt, AV_PIX_FMT_NONE };
+    int ret;
+
+    if ((ret = ff_formats_ref(ff_make_format_list(src_fmts),
+                              &ctx->inputs[0]->out_formats)) < 0)
+        return ret;
+    return ff_formats_ref(ff_make_format_list(dst_fmts),
+                          &ctx->outputs[0]->in_formats);
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AliasFormatContext *s = ctx->priv;
+    int i;
+
+    if (s->nb_planes < av_pix_fmt_count_planes(s->src_fmt)) {
+        /* drop the references to the buffers of the planes we do not keep */
+        AVBufferRef *buf = av_frame_get_plane_buffer(frame, 0);
+
+        for (i = 0; i < FF_ARRAY_ELEMS(frame->buf) && buf != frame->buf[i]; i++);
+        if (buf && i < FF_ARRAY_ELEMS(frame->buf)) {
+            frame->buf[i] = frame->buf[0];
+            frame->buf[0] = buf;
+            for (i = 1; i < FF_ARRAY_ELEMS(frame->buf); i++)
+                av_buffer_unref(&frame->buf[i]);
+        }
+
+        for (i = s->nb_planes; i < FF_ARRAY_ELEMS(frame->data); i++) {
+            frame->data[i]     = NULL;
+            frame->linesize[i] = 0;
+        }
+    }
+
+    /* keep the meaning of the samples, which the formats leave implicit */
+    if (s->src_jpeg)
+        frame->color_range = AVCOL_RANGE_JPEG;
+    else if (frame->color_range == AVCOL_RANGE_UNSPECIFIED)
+        frame->color_range = AVCOL_RANGE_MPEG;
+
+    frame->format = s->dst_fmt;
+
+    return ff_filter_frame(ctx->outputs[0], frame);
+}
+
+static const AVFilterPad aliasformat_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .filter_frame = filter_frame,
+    },
+    { NULL }
+};
+
+static const AVFilterPad aliasformat_outputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_aliasformat = {
+    .name          = "aliasformat",
+    .description   = NULL_IF_CONFIG_SMALL("Reinterpret the frames in a layout-compatible pixel format."),
+    .priv_size     = sizeof(AliasFormatContext),
+    .priv_class    = &aliasformat_class,
+    .init          = init,
+    .query_formats = query_formats,
+    .inputs        = aliasformat_inputs,
+    .outputs       = aliasformat_outputs,
+};
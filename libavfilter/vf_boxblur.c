@@ -27,6 +27,7 @@
 
 #include "libavutil/avstring.h"
 #include "libavutil/common.h"
+#include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "avfilter.h"
 #include "formats.h"
@@ -34,6 +35,12 @@
 #include "video.h"
 #include "boxblur.h"
 
+/* width in pixels of the column tiles of the vertical pass */
+#define TILE_W 64
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
 
 typedef struct BoxBlurContext {
     const AVClass *class;
@@ -44,15 +51,17 @@ typedef struct BoxBlurContext {
     int hsub, vsub;
     int radius[4];
     int power[4];
-    uint8_t *temp[2]; ///< temporary buffer used in blur_power()
+    int depth;
+    BoxBlurDSPContext dsp;
+    uint8_t *temp;              ///< temporary buffers used by each job
+    size_t temp_size;           ///< size of the buffers of a job
 } BoxBlurContext;
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
     BoxBlurContext *s = ctx->priv;
 
-    av_freep(&s->temp[0]);
-    av_freep(&s->temp[1]);
+    av_freep(&s->temp);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -78,12 +87,17 @@ static int config_input(AVFilterLink *inlink)
     AVFilterContext    *ctx = inlink->dst;
     BoxBlurContext *s = ctx->priv;
     int w = inlink->w, h = inlink->h;
+    int nb_threads = ff_filter_get_nb_threads(ctx);
     int ret;
 
-    if (!(s->temp[0] = av_malloc(2*FFMAX(w, h))) ||
-        !(s->temp[1] = av_malloc(2*FFMAX(w, h))))
+    /* two lines for hblur() or two column tiles and their sums for vblur() */
+    s->temp_size = FFALIGN(FFMAX(2 * 2 * w, 2 * 2 * TILE_W * h + TILE_W * sizeof(int)), 32);
+    av_freep(&s->temp);
+    if (!(s->temp = av_malloc_array(nb_threads, s->temp_size)))
         return AVERROR(ENOMEM);
 
+    s->depth = desc->comp[0].depth;
+    ff_boxblur_init_dsp(&s->dsp);
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
 
@@ -157,6 +171,65 @@ BLUR(uint16_t, 16)
 
 #undef BLUR
 
+/* The same running sums, computed for a tile of adjacent columns at once:
+ * every step processes a whole row of the tile, which is contiguous in
+ * memory, instead of walking each column with the stride of the image. */
+#define BLUR_COLUMNS(type, depth)                                           \
+static void blur_row ## depth ## _c(type *dst, const type *add, const type *sub, \
+                                    int *sum, int inv, int w)               \
+{                                                                           \
+    int x;                                                                  \
+                                                                            \
+    for (x = 0; x < w; x++) {                                               \
+        sum[x] += (add[x] - sub[x])*inv;                                    \
+        dst[x] = sum[x]>>16;                                                \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static void blur_columns ## depth(const BoxBlurDSPContext *dsp,             \
+                                  type *dst, ptrdiff_t dst_linesize,        \
+                                  const type *src, ptrdiff_t src_linesize,  \
+                                  int w, int len, int radius, int *sum)     \
+{                                                                           \
+    const int length = radius*2 + 1;                                        \
+    const int inv = ((1<<16) + length/2)/length;                            \
+    int x, y;                                                               \
+                                                                            \
+    for (x = 0; x < w; x++)                                                 \
+        sum[x] = src[radius*src_linesize + x];                              \
+    for (y = 0; y < radius; y++)                                            \
+        for (x = 0; x < w; x++)                                             \
+            sum[x] += src[y*src_linesize + x]<<1;                           \
+    for (x = 0; x < w; x++)                                                 \
+        sum[x] = sum[x]*inv + (1<<15);                                      \
+                                                                            \
+    for (y = 0; y <= radius; y++)                                           \
+        dsp->blur_row ## depth(dst + y*dst_linesize, src + (radius+y)*src_linesize, \
+                               src + (radius-y)*src_linesize, sum, inv, w); \
+                                                                            \
+    for (; y < len-radius; y++)                                             \
+        dsp->blur_row ## depth(dst + y*dst_linesize, src + (radius+y)*src_linesize, \
+                               src + (y-radius-1)*src_linesize, sum, inv, w); \
+                                                                            \
+    for (; y < len; y++)                                                    \
+        dsp->blur_row ## depth(dst + y*dst_linesize, src + (2*len-radius-y-1)*src_linesize, \
+                               src + (y-radius-1)*src_linesize, sum, inv, w); \
+}
+
+BLUR_COLUMNS(uint8_t,   8)
+BLUR_COLUMNS(uint16_t, 16)
+
+#undef BLUR_COLUMNS
+
+av_cold void ff_boxblur_init_dsp(BoxBlurDSPContext *dsp)
+{
+    dsp->blur_row8  = blur_row8_c;
+    dsp->blur_row16 = blur_row16_c;
+
+    if (ARCH_X86)
+        ff_boxblur_init_dsp_x86(dsp);
+}
+
 static inline void blur(uint8_t *dst, int dst_step, const uint8_t *src, int src_step,
                         int len, int radius, int pixsize)
 {
@@ -211,32 +284,100 @@ static void hblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_li
                    w, radius, power, temp, pixsize);
 }
 
-static void vblur(uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
-                  int w, int h, int radius, int power, uint8_t *temp[2], int pixsize)
+static void blur_columns(const BoxBlurDSPContext *dsp,
+                         uint8_t *dst, ptrdiff_t dst_linesize,
+                         const uint8_t *src, ptrdiff_t src_linesize,
+                         int w, int len, int radius, int *sum, int pixsize)
+{
+    if (pixsize == 1) blur_columns8 (dsp, dst, dst_linesize, src, src_linesize, w, len, radius, sum);
+    else              blur_columns16(dsp, (uint16_t*)dst, dst_linesize>>1, (const uint16_t*)src, src_linesize>>1,
+                                     w, len, radius, sum);
+}
+
+static void vblur(const BoxBlurDSPContext *dsp,
+                  uint8_t *dst, int dst_linesize, const uint8_t *src, int src_linesize,
+                  int w, int h, int radius, int power, uint8_t *temp, int pixsize)
 {
-    int x;
+    const int tile_linesize = TILE_W * pixsize;
+    uint8_t *a = temp, *b = temp + tile_linesize * h;
+    int *sum = (int *)(b + tile_linesize * h);
 
-    if (radius == 0 && dst == src)
+    if (radius == 0 || power == 0) {
+        if (dst != src)
+            av_image_copy_plane(dst, dst_linesize, src, src_linesize, w * pixsize, h);
         return;
+    }
+
+    blur_columns(dsp, a, tile_linesize, src, src_linesize, w, h, radius, sum, pixsize);
+    for (; power > 2; power--) {
+        blur_columns(dsp, b, tile_linesize, a, tile_linesize, w, h, radius, sum, pixsize);
+        FFSWAP(uint8_t *, a, b);
+    }
+    if (power > 1)
+        blur_columns(dsp, dst, dst_linesize, a, tile_linesize, w, h, radius, sum, pixsize);
+    else
+        av_image_copy_plane(dst, dst_linesize, a, tile_linesize, w * pixsize, h);
+}
+
+static int filter_slice_h(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in = td->in, *out = td->out;
+    const int pixsize = (s->depth + 7) / 8;
+    uint8_t *temp = s->temp + jobnr * s->temp_size;
+    uint8_t *lines[2] = { temp, temp + 2 * in->width };
+    int plane;
+
+    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++) {
+        const int w = plane == 1 || plane == 2 ? AV_CEIL_RSHIFT(in->width,  s->hsub) : in->width;
+        const int h = plane == 1 || plane == 2 ? AV_CEIL_RSHIFT(in->height, s->vsub) : in->height;
+        const int slice_start = (h *  jobnr     ) / nb_jobs;
+        const int slice_end   = (h * (jobnr + 1)) / nb_jobs;
+
+        hblur(out->data[plane] + slice_start * out->linesize[plane], out->linesize[plane],
+              in ->data[plane] + slice_start * in ->linesize[plane], in ->linesize[plane],
+              w, slice_end - slice_start, s->radius[plane], s->power[plane],
+              lines, pixsize);
+    }
+
+    return 0;
+}
+
+static int filter_slice_v(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    BoxBlurContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *out = td->out;
+    const int pixsize = (s->depth + 7) / 8;
+    uint8_t *temp = s->temp + jobnr * s->temp_size;
+    int plane, x;
+
+    for (plane = 0; plane < 4 && out->data[plane] && out->linesize[plane]; plane++) {
+        const int w = plane == 1 || plane == 2 ? AV_CEIL_RSHIFT(out->width,  s->hsub) : out->width;
+        const int h = plane == 1 || plane == 2 ? AV_CEIL_RSHIFT(out->height, s->vsub) : out->height;
+        const int slice_start = (w *  jobnr     ) / nb_jobs;
+        const int slice_end   = (w * (jobnr + 1)) / nb_jobs;
+
+        for (x = slice_start; x < slice_end; x += TILE_W) {
+            uint8_t *dst = out->data[plane] + x * pixsize;
+
+            vblur(&s->dsp, dst, out->linesize[plane], dst, out->linesize[plane],
+                  FFMIN(TILE_W, slice_end - x), h, s->radius[plane], s->power[plane],
+                  temp, pixsize);
+        }
+    }
 
-    for (x = 0; x < w; x++)
-        blur_power(dst + x*pixsize, dst_linesize, src + x*pixsize, src_linesize,
-                   h, radius, power, temp, pixsize);
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
-    BoxBlurContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    ThreadData td;
     AVFrame *out;
-    int plane;
-    int cw = AV_CEIL_RSHIFT(inlink->w, s->hsub), ch = AV_CEIL_RSHIFT(in->height, s->vsub);
-    int w[4] = { inlink->w, cw, cw, inlink->w };
-    int h[4] = { in->height, ch, ch, in->height };
-    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-    const int depth = desc->comp[0].depth;
-    const int pixsize = (depth+7)/8;
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
     if (!out) {
@@ -245,17 +386,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        hblur(out->data[plane], out->linesize[plane],
-              in ->data[plane], in ->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
-
-    for (plane = 0; plane < 4 && in->data[plane] && in->linesize[plane]; plane++)
-        vblur(out->data[plane], out->linesize[plane],
-              out->data[plane], out->linesize[plane],
-              w[plane], h[plane], s->radius[plane], s->power[plane],
-              s->temp, pixsize);
+    td.in  = in;
+    td.out = out;
+    ctx->internal->execute(ctx, filter_slice_h, &td, NULL, FFMIN(in->height, nb_threads));
+    ctx->internal->execute(ctx, filter_slice_v, &td, NULL, FFMIN(in->width,  nb_threads));
 
     av_frame_free(&in);
 
@@ -313,5 +447,5 @@ AVFilter ff_vf_boxblur = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_boxblur_inputs,
     .outputs       = avfilter_vf_boxblur_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
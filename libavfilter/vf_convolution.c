@@ -25,48 +25,11 @@
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "avfilter.h"
+#include "convolution.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
 
-enum MatrixMode {
-    MATRIX_SQUARE,
-    MATRIX_ROW,
-    MATRIX_COLUMN,
-    MATRIX_NBMODES,
-};
-
-typedef struct ConvolutionContext {
-    const AVClass *class;
-
-    char *matrix_str[4];
-    float rdiv[4];
-    float bias[4];
-    int mode[4];
-    float scale;
-    float delta;
-    int planes;
-
-    int size[4];
-    int depth;
-    int max;
-    int bpc;
-    int nb_planes;
-    int nb_threads;
-    int planewidth[4];
-    int planeheight[4];
-    int matrix[4][49];
-    int matrix_length[4];
-    int copy[4];
-
-    void (*setup[4])(int radius, const uint8_t *c[], const uint8_t *src, int stride,
-                     int x, int width, int y, int height, int bpc);
-    void (*filter[4])(uint8_t *dst, int width,
-                      float rdiv, float bias, const int *const matrix,
-                      const uint8_t *c[], int peak, int radius,
-                      int dstride, int stride);
-} ConvolutionContext;
-
 #define OFFSET(x) offsetof(ConvolutionContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 
@@ -591,12 +554,48 @@ static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
+void ff_convolution_init(ConvolutionContext *s, enum ConvolutionType type, int depth)
+{
+    int p;
+
+    for (p = 0; p < 4; p++) {
+        if (s->copy[p])
+            continue;
+
+        switch (type) {
+        case CONVOLUTION_MATRIX:
+            if (s->mode[p] == MATRIX_ROW)
+                s->filter[p] = depth > 8 ? filter16_row    : filter_row;
+            else if (s->mode[p] == MATRIX_COLUMN)
+                s->filter[p] = depth > 8 ? filter16_column : filter_column;
+            else if (s->size[p] == 3)
+                s->filter[p] = depth > 8 ? filter16_3x3    : filter_3x3;
+            else if (s->size[p] == 5)
+                s->filter[p] = depth > 8 ? filter16_5x5    : filter_5x5;
+            else if (s->size[p] == 7)
+                s->filter[p] = depth > 8 ? filter16_7x7    : filter_7x7;
+            break;
+        case CONVOLUTION_PREWITT:
+            s->filter[p] = depth > 8 ? filter16_prewitt : filter_prewitt;
+            break;
+        case CONVOLUTION_ROBERTS:
+            s->filter[p] = depth > 8 ? filter16_roberts : filter_roberts;
+            break;
+        case CONVOLUTION_SOBEL:
+            s->filter[p] = depth > 8 ? filter16_sobel   : filter_sobel;
+            break;
+        }
+    }
+
+    if (ARCH_X86)
+        ff_convolution_init_x86(s, type, depth);
+}
+
 static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     ConvolutionContext *s = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-    int p;
 
     s->depth = desc->comp[0].depth;
     s->max = (1 << s->depth) - 1;
@@ -610,34 +609,14 @@ static int config_input(AVFilterLink *inlink)
     s->nb_threads = ff_filter_get_nb_threads(ctx);
     s->bpc = (s->depth + 7) / 8;
 
-    if (!strcmp(ctx->filter->name, "convolution")) {
-        if (s->depth > 8) {
-            for (p = 0; p < s->nb_planes; p++) {
-                if (s->mode[p] == MATRIX_ROW)
-                    s->filter[p] = filter16_row;
-                else if (s->mode[p] == MATRIX_COLUMN)
-                    s->filter[p] = filter16_column;
-                else if (s->size[p] == 3)
-                    s->filter[p] = filter16_3x3;
-                else if (s->size[p] == 5)
-                    s->filter[p] = filter16_5x5;
-                else if (s->size[p] == 7)
-                    s->filter[p] = filter16_7x7;
-            }
-        }
-    } else if (!strcmp(ctx->filter->name, "prewitt")) {
-        if (s->depth > 8)
-            for (p = 0; p < s->nb_planes; p++)
-                s->filter[p] = filter16_prewitt;
-    } else if (!strcmp(ctx->filter->name, "roberts")) {
-        if (s->depth > 8)
-            for (p = 0; p < s->nb_planes; p++)
-                s->filter[p] = filter16_roberts;
-    } else if (!strcmp(ctx->filter->name, "sobel")) {
-        if (s->depth > 8)
-            for (p = 0; p < s->nb_planes; p++)
-                s->filter[p] = filter16_sobel;
-    }
+    if (!strcmp(ctx->filter->name, "convolution"))
+        ff_convolution_init(s, CONVOLUTION_MATRIX, s->depth);
+    else if (!strcmp(ctx->filter->name, "prewitt"))
+        ff_convolution_init(s, CONVOLUTION_PREWITT, s->depth);
+    else if (!strcmp(ctx->filter->name, "roberts"))
+        ff_convolution_init(s, CONVOLUTION_ROBERTS, s->depth);
+    else if (!strcmp(ctx->filter->name, "sobel"))
+        ff_convolution_init(s, CONVOLUTION_SOBEL, s->depth);
 
     return 0;
 }
@@ -692,33 +671,25 @@ static av_cold int init(AVFilterContext *ctx)
                 return AVERROR(EINVAL);
             }
             if (s->mode[i] == MATRIX_ROW) {
-                s->filter[i] = filter_row;
                 s->setup[i] = setup_row;
                 s->size[i] = s->matrix_length[i];
             } else if (s->mode[i] == MATRIX_COLUMN) {
-                s->filter[i] = filter_column;
                 s->setup[i] = setup_column;
                 s->size[i] = s->matrix_length[i];
             } else if (s->matrix_length[i] == 9) {
                 s->size[i] = 3;
                 if (!memcmp(matrix, same3x3, sizeof(same3x3)))
                     s->copy[i] = 1;
-                else
-                    s->filter[i] = filter_3x3;
                 s->setup[i] = setup_3x3;
             } else if (s->matrix_length[i] == 25) {
                 s->size[i] = 5;
                 if (!memcmp(matrix, same5x5, sizeof(same5x5)))
                     s->copy[i] = 1;
-                else
-                    s->filter[i] = filter_5x5;
                 s->setup[i] = setup_5x5;
             } else if (s->matrix_length[i] == 49) {
                 s->size[i] = 7;
                 if (!memcmp(matrix, same7x7, sizeof(same7x7)))
                     s->copy[i] = 1;
-                else
-                    s->filter[i] = filter_7x7;
                 s->setup[i] = setup_7x7;
             } else {
                 return AVERROR(EINVAL);
@@ -734,9 +705,7 @@ static av_cold int init(AVFilterContext *ctx)
         }
     } else if (!strcmp(ctx->filter->name, "prewitt")) {
         for (i = 0; i < 4; i++) {
-            if ((1 << i) & s->planes)
-                s->filter[i] = filter_prewitt;
-            else
+            if (!((1 << i) & s->planes))
                 s->copy[i] = 1;
             s->size[i] = 3;
             s->setup[i] = setup_3x3;
@@ -745,9 +714,7 @@ static av_cold int init(AVFilterContext *ctx)
         }
     } else if (!strcmp(ctx->filter->name, "roberts")) {
         for (i = 0; i < 4; i++) {
-            if ((1 << i) & s->planes)
-                s->filter[i] = filter_roberts;
-            else
+            if (!((1 << i) & s->planes))
                 s->copy[i] = 1;
             s->size[i] = 3;
             s->setup[i] = setup_3x3;
@@ -756,9 +723,7 @@ static av_cold int init(AVFilterContext *ctx)
         }
     } else if (!strcmp(ctx->filter->name, "sobel")) {
         for (i = 0; i < 4; i++) {
-            if ((1 << i) & s->planes)
-                s->filter[i] = filter_sobel;
-            else
+            if (!((1 << i) & s->planes))
                 s->copy[i] = 1;
             s->size[i] = 3;
             s->setup[i] = setup_3x3;
@@ -225,6 +225,45 @@ static double block_angle(int x, int y, int cx, int cy, IntMotionVector *shift)
            diff;
 }
 
+typedef struct MotionThreadData {
+    uint8_t *src1, *src2;
+    int stride;
+    int nb_cols, nb_rows;
+} MotionThreadData;
+
+/**
+ * Search the motion of the blocks in a range of block rows.
+ */
+static int find_motion_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DeshakeContext *deshake = ctx->priv;
+    const MotionThreadData *td = arg;
+    const int row_start = (td->nb_rows *  jobnr     ) / nb_jobs;
+    const int row_end   = (td->nb_rows * (jobnr + 1)) / nb_jobs;
+    IntMotionVector mv = {0, 0};
+    int i, j;
+
+    for (j = row_start; j < row_end; j++) {
+        const int y = deshake->ry + j * deshake->blocksize * 2;
+        IntMotionVector *mvs = deshake->mvs + j * td->nb_cols;
+
+        // We use a width of 16 here to match the sad function
+        for (i = 0; i < td->nb_cols; i++) {
+            const int x = deshake->rx + i * 16;
+
+            // If the contrast is too low, just skip this block as it probably
+            // won't be very useful to us.
+            if (block_contrast(td->src2, x, y, td->stride, deshake->blocksize) > deshake->contrast) {
+                find_block_motion(deshake, td->src1, td->src2, x, y, td->stride, &mv);
+                mvs[i] = mv;
+            } else {
+                mvs[i].x = mvs[i].y = -1;
+            }
+        }
+    }
+    return 0;
+}
+
 /**
  * Find the estimated global motion for a scene given the most likely shift
  * for each block in the frame. The global motion is estimated to be the
@@ -232,13 +271,16 @@ static double block_angle(int x, int y, int cx, int cy, IntMotionVector *shift)
  * move one pixel to the right and two pixels down, this would yield a
  * motion vector (1, -2).
  */
-static void find_motion(DeshakeContext *deshake, uint8_t *src1, uint8_t *src2,
+static void find_motion(AVFilterContext *ctx, uint8_t *src1, uint8_t *src2,
                         int width, int height, int stride, Transform *t)
 {
-    int x, y;
-    IntMotionVector mv = {0, 0};
+    DeshakeContext *deshake = ctx->priv;
+    MotionThreadData td;
+    int x, y, i, j, nb_jobs;
     int count_max_value = 0;
-    int contrast;
+    const int step = deshake->blocksize * 2;
+    const int w = width  - deshake->rx * 2 - 16;
+    const int h = height - deshake->ry * 2 - step;
 
     int pos;
     int center_x = 0, center_y = 0;
@@ -253,25 +295,39 @@ static void find_motion(DeshakeContext *deshake, uint8_t *src1, uint8_t *src2,
         }
     }
 
+    td.src1    = src1;
+    td.src2    = src2;
+    td.stride  = stride;
+    td.nb_cols = w > 0 ? (w + 15) / 16 : 0;
+    td.nb_rows = h > 0 ? (h + step - 1) / step : 0;
+    av_fast_malloc(&deshake->mvs, &deshake->mvs_size, td.nb_cols * td.nb_rows * sizeof(*deshake->mvs));
+    if (!deshake->mvs)
+        td.nb_rows = 0;
+
+    // Find motion for every block. Without a search range, the less
+    // exhaustive search starts from the previous block's vector, so the
+    // blocks have to be searched in order.
+    nb_jobs = FFMIN(td.nb_rows, ff_filter_get_nb_threads(ctx));
+    if (deshake->search == SMART_EXHAUSTIVE && (!deshake->rx || !deshake->ry))
+        nb_jobs = FFMIN(td.nb_rows, 1);
+    if (nb_jobs)
+        ctx->internal->execute(ctx, find_motion_slice, &td, NULL, nb_jobs);
+
+    // Store the motion vectors in the counts
     pos = 0;
-    // Find motion for every block and store the motion vector in the counts
-    for (y = deshake->ry; y < height - deshake->ry - (deshake->blocksize * 2); y += deshake->blocksize * 2) {
-        // We use a width of 16 here to match the sad function
-        for (x = deshake->rx; x < width - deshake->rx - 16; x += 16) {
-            // If the contrast is too low, just skip this block as it probably
-            // won't be very useful to us.
-            contrast = block_contrast(src2, x, y, stride, deshake->blocksize);
-            if (contrast > deshake->contrast) {
-                //av_log(NULL, AV_LOG_ERROR, "%d\n", contrast);
-                find_block_motion(deshake, src1, src2, x, y, stride, &mv);
-                if (mv.x != -1 && mv.y != -1) {
-                    deshake->counts[mv.x + deshake->rx][mv.y + deshake->ry] += 1;
-                    if (x > deshake->rx && y > deshake->ry)
-                        deshake->angles[pos++] = block_angle(x, y, 0, 0, &mv);
-
-                    center_x += mv.x;
-                    center_y += mv.y;
-                }
+    for (j = 0; j < td.nb_rows; j++) {
+        y = deshake->ry + j * step;
+        for (i = 0; i < td.nb_cols; i++) {
+            IntMotionVector *mv = &deshake->mvs[j * td.nb_cols + i];
+
+            x = deshake->rx + i * 16;
+            if (mv->x != -1 && mv->y != -1) {
+                deshake->counts[mv->x + deshake->rx][mv->y + deshake->ry] += 1;
+                if (x > deshake->rx && y > deshake->ry)
+                    deshake->angles[pos++] = block_angle(x, y, 0, 0, mv);
+
+                center_x += mv->x;
+                center_y += mv->y;
             }
         }
     }
@@ -312,30 +368,60 @@ static void find_motion(DeshakeContext *deshake, uint8_t *src1, uint8_t *src2,
     //av_log(NULL, AV_LOG_ERROR, "%d x %d\n", avg->x, avg->y);
 }
 
-static int deshake_transform_c(AVFilterContext *ctx,
-                                    int width, int height, int cw, int ch,
-                                    const float *matrix_y, const float *matrix_uv,
-                                    enum InterpolateMethod interpolate,
-                                    enum FillMethod fill, AVFrame *in, AVFrame *out)
-{
-    int i = 0, ret = 0;
-    const float *matrixs[3];
+typedef struct TransformThreadData {
+    AVFrame *in, *out;
+    const float *matrix[3];
     int plane_w[3], plane_h[3];
-    matrixs[0] = matrix_y;
-    matrixs[1] =  matrixs[2] = matrix_uv;
-    plane_w[0] = width;
-    plane_w[1] = plane_w[2] = cw;
-    plane_h[0] = height;
-    plane_h[1] = plane_h[2] = ch;
+    enum InterpolateMethod interpolate;
+    enum FillMethod fill;
+} TransformThreadData;
+
+static int transform_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    const TransformThreadData *td = arg;
+    int i, ret;
 
     for (i = 0; i < 3; i++) {
+        const int h = td->plane_h[i];
+        const int slice_start = (h *  jobnr     ) / nb_jobs;
+        const int slice_end   = (h * (jobnr + 1)) / nb_jobs;
+
         // Transform the luma and chroma planes
-        ret = avfilter_transform(in->data[i], out->data[i], in->linesize[i], out->linesize[i],
-                                 plane_w[i], plane_h[i], matrixs[i], interpolate, fill);
+        ret = avfilter_transform_slice(td->in->data[i], td->out->data[i],
+                                       td->in->linesize[i], td->out->linesize[i],
+                                       td->plane_w[i], h, slice_start, slice_end,
+                                       td->matrix[i], td->interpolate, td->fill);
         if (ret < 0)
             return ret;
     }
-    return ret;
+    return 0;
+}
+
+static int deshake_transform_c(AVFilterContext *ctx,
+                                    int width, int height, int cw, int ch,
+                                    const float *matrix_y, const float *matrix_uv,
+                                    enum InterpolateMethod interpolate,
+                                    enum FillMethod fill, AVFrame *in, AVFrame *out)
+{
+    TransformThreadData td;
+    const int nb_jobs = FFMAX(FFMIN(ch, ff_filter_get_nb_threads(ctx)), 1);
+
+    if ((unsigned)interpolate >= INTERPOLATE_COUNT)
+        return AVERROR(EINVAL);
+
+    td.in  = in;
+    td.out = out;
+    td.matrix[0] = matrix_y;
+    td.matrix[1] = td.matrix[2] = matrix_uv;
+    td.plane_w[0] = width;
+    td.plane_w[1] = td.plane_w[2] = cw;
+    td.plane_h[0] = height;
+    td.plane_h[1] = td.plane_h[2] = ch;
+    td.interpolate = interpolate;
+    td.fill        = fill;
+
+    ctx->internal->execute(ctx, transform_slice, &td, NULL, nb_jobs);
+    return 0;
 }
 
 static av_cold int init(AVFilterContext *ctx)
@@ -403,6 +489,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_frame_free(&deshake->ref);
     av_freep(&deshake->angles);
     deshake->angles_size = 0;
+    av_freep(&deshake->mvs);
+    deshake->mvs_size = 0;
     if (deshake->fp)
         fclose(deshake->fp);
 }
@@ -436,7 +524,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
 
     if (deshake->cx < 0 || deshake->cy < 0 || deshake->cw < 0 || deshake->ch < 0) {
         // Find the most likely global motion for the current frame
-        find_motion(deshake, (deshake->ref == NULL) ? in->data[0] : deshake->ref->data[0], in->data[0], link->w, link->h, in->linesize[0], &t);
+        find_motion(link->dst, (deshake->ref == NULL) ? in->data[0] : deshake->ref->data[0], in->data[0], link->w, link->h, in->linesize[0], &t);
     } else {
         uint8_t *src1 = (deshake->ref == NULL) ? in->data[0] : deshake->ref->data[0];
         uint8_t *src2 = in->data[0];
@@ -453,7 +541,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         src1 += deshake->cy * in->linesize[0] + deshake->cx;
         src2 += deshake->cy * in->linesize[0] + deshake->cx;
 
-        find_motion(deshake, src1, src2, deshake->cw, deshake->ch, in->linesize[0], &t);
+        find_motion(link->dst, src1, src2, deshake->cw, deshake->ch, in->linesize[0], &t);
     }
 
 
@@ -557,4 +645,5 @@ AVFilter ff_vf_deshake = {
     .inputs        = deshake_inputs,
     .outputs       = deshake_outputs,
     .priv_class    = &deshake_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
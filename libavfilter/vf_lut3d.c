@@ -35,6 +35,7 @@
 #include "formats.h"
 #include "framesync.h"
 #include "internal.h"
+#include "lut3d.h"
 #include "video.h"
 
 #define R 0
@@ -42,21 +43,6 @@
 #define B 2
 #define A 3
 
-enum interp_mode {
-    INTERPOLATE_NEAREST,
-    INTERPOLATE_TRILINEAR,
-    INTERPOLATE_TETRAHEDRAL,
-    NB_INTERP_MODE
-};
-
-struct rgbvec {
-    float r, g, b;
-};
-
-/* 3D LUT don't often go up to level 32, but it is common to have a Hald CLUT
- * of 512x512 (64x64x64) */
-#define MAX_LEVEL 128
-
 typedef struct LUT3DContext {
     const AVClass *class;
     int interpolation;          ///<interp_mode
@@ -67,6 +53,8 @@ typedef struct LUT3DContext {
     struct rgbvec scale;
     struct rgbvec lut[MAX_LEVEL][MAX_LEVEL][MAX_LEVEL];
     int lutsize;
+    LUT3DDSPContext dsp;
+    int deinterleave;           ///< run packed pixels through dsp.interp_row
 #if CONFIG_HALDCLUT_FILTER
     uint8_t clut_rgba_map[4];
     int clut_step;
@@ -105,35 +93,35 @@ static inline struct rgbvec lerp(const struct rgbvec *v0, const struct rgbvec *v
 
 #define NEAR(x) ((int)((x) + .5))
 #define PREV(x) ((int)(x))
-#define NEXT(x) (FFMIN((int)(x) + 1, lut3d->lutsize - 1))
+#define NEXT(x) (FFMIN((int)(x) + 1, lutsize - 1))
 
 /**
  * Get the nearest defined point
  */
-static inline struct rgbvec interp_nearest(const LUT3DContext *lut3d,
-                                           const struct rgbvec *s)
+static inline struct rgbvec interp_nearest(const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL],
+                                           int lutsize, const struct rgbvec *s)
 {
-    return lut3d->lut[NEAR(s->r)][NEAR(s->g)][NEAR(s->b)];
+    return lut[NEAR(s->r)][NEAR(s->g)][NEAR(s->b)];
 }
 
 /**
  * Interpolate using the 8 vertices of a cube
  * @see https://en.wikipedia.org/wiki/Trilinear_interpolation
  */
-static inline struct rgbvec interp_trilinear(const LUT3DContext *lut3d,
-                                             const struct rgbvec *s)
+static inline struct rgbvec interp_trilinear(const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL],
+                                             int lutsize, const struct rgbvec *s)
 {
     const int prev[] = {PREV(s->r), PREV(s->g), PREV(s->b)};
     const int next[] = {NEXT(s->r), NEXT(s->g), NEXT(s->b)};
     const struct rgbvec d = {s->r - prev[0], s->g - prev[1], s->b - prev[2]};
-    const struct rgbvec c000 = lut3d->lut[prev[0]][prev[1]][prev[2]];
-    const struct rgbvec c001 = lut3d->lut[prev[0]][prev[1]][next[2]];
-    const struct rgbvec c010 = lut3d->lut[prev[0]][next[1]][prev[2]];
-    const struct rgbvec c011 = lut3d->lut[prev[0]][next[1]][next[2]];
-    const struct rgbvec c100 = lut3d->lut[next[0]][prev[1]][prev[2]];
-    const struct rgbvec c101 = lut3d->lut[next[0]][prev[1]][next[2]];
-    const struct rgbvec c110 = lut3d->lut[next[0]][next[1]][prev[2]];
-    const struct rgbvec c111 = lut3d->lut[next[0]][next[1]][next[2]];
+    const struct rgbvec c000 = lut[prev[0]][prev[1]][prev[2]];
+    const struct rgbvec c001 = lut[prev[0]][prev[1]][next[2]];
+    const struct rgbvec c010 = lut[prev[0]][next[1]][prev[2]];
+    const struct rgbvec c011 = lut[prev[0]][next[1]][next[2]];
+    const struct rgbvec c100 = lut[next[0]][prev[1]][prev[2]];
+    const struct rgbvec c101 = lut[next[0]][prev[1]][next[2]];
+    const struct rgbvec c110 = lut[next[0]][next[1]][prev[2]];
+    const struct rgbvec c111 = lut[next[0]][next[1]][next[2]];
     const struct rgbvec c00  = lerp(&c000, &c100, d.r);
     const struct rgbvec c10  = lerp(&c010, &c110, d.r);
     const struct rgbvec c01  = lerp(&c001, &c101, d.r);
@@ -148,51 +136,51 @@ static inline struct rgbvec interp_trilinear(const LUT3DContext *lut3d,
  * Tetrahedral interpolation. Based on code found in Truelight Software Library paper.
  * @see http://www.filmlight.ltd.uk/pdf/whitepapers/FL-TL-TN-0057-SoftwareLib.pdf
  */
-static inline struct rgbvec interp_tetrahedral(const LUT3DContext *lut3d,
-                                               const struct rgbvec *s)
+static inline struct rgbvec interp_tetrahedral(const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL],
+                                               int lutsize, const struct rgbvec *s)
 {
     const int prev[] = {PREV(s->r), PREV(s->g), PREV(s->b)};
     const int next[] = {NEXT(s->r), NEXT(s->g), NEXT(s->b)};
     const struct rgbvec d = {s->r - prev[0], s->g - prev[1], s->b - prev[2]};
-    const struct rgbvec c000 = lut3d->lut[prev[0]][prev[1]][prev[2]];
-    const struct rgbvec c111 = lut3d->lut[next[0]][next[1]][next[2]];
+    const struct rgbvec c000 = lut[prev[0]][prev[1]][prev[2]];
+    const struct rgbvec c111 = lut[next[0]][next[1]][next[2]];
     struct rgbvec c;
     if (d.r > d.g) {
         if (d.g > d.b) {
-            const struct rgbvec c100 = lut3d->lut[next[0]][prev[1]][prev[2]];
-            const struct rgbvec c110 = lut3d->lut[next[0]][next[1]][prev[2]];
+            const struct rgbvec c100 = lut[next[0]][prev[1]][prev[2]];
+            const struct rgbvec c110 = lut[next[0]][next[1]][prev[2]];
             c.r = (1-d.r) * c000.r + (d.r-d.g) * c100.r + (d.g-d.b) * c110.r + (d.b) * c111.r;
             c.g = (1-d.r) * c000.g + (d.r-d.g) * c100.g + (d.g-d.b) * c110.g + (d.b) * c111.g;
             c.b = (1-d.r) * c000.b + (d.r-d.g) * c100.b + (d.g-d.b) * c110.b + (d.b) * c111.b;
         } else if (d.r > d.b) {
-            const struct rgbvec c100 = lut3d->lut[next[0]][prev[1]][prev[2]];
-            const struct rgbvec c101 = lut3d->lut[next[0]][prev[1]][next[2]];
+            const struct rgbvec c100 = lut[next[0]][prev[1]][prev[2]];
+            const struct rgbvec c101 = lut[next[0]][prev[1]][next[2]];
             c.r = (1-d.r) * c000.r + (d.r-d.b) * c100.r + (d.b-d.g) * c101.r + (d.g) * c111.r;
             c.g = (1-d.r) * c000.g + (d.r-d.b) * c100.g + (d.b-d.g) * c101.g + (d.g) * c111.g;
             c.b = (1-d.r) * c000.b + (d.r-d.b) * c100.b + (d.b-d.g) * c101.b + (d.g) * c111.b;
         } else {
-            const struct rgbvec c001 = lut3d->lut[prev[0]][prev[1]][next[2]];
-            const struct rgbvec c101 = lut3d->lut[next[0]][prev[1]][next[2]];
+            const struct rgbvec c001 = lut[prev[0]][prev[1]][next[2]];
+            const struct rgbvec c101 = lut[next[0]][prev[1]][next[2]];
             c.r = (1-d.b) * c000.r + (d.b-d.r) * c001.r + (d.r-d.g) * c101.r + (d.g) * c111.r;
             c.g = (1-d.b) * c000.g + (d.b-d.r) * c001.g + (d.r-d.g) * c101.g + (d.g) * c111.g;
             c.b = (1-d.b) * c000.b + (d.b-d.r) * c001.b + (d.r-d.g) * c101.b + (d.g) * c111.b;
         }
     } else {
         if (d.b > d.g) {
-            const struct rgbvec c001 = lut3d->lut[prev[0]][prev[1]][next[2]];
-            const struct rgbvec c011 = lut3d->lut[prev[0]][next[1]][next[2]];
+            const struct rgbvec c001 = lut[prev[0]][prev[1]][next[2]];
+            const struct rgbvec c011 = lut[prev[0]][next[1]][next[2]];
             c.r = (1-d.b) * c000.r + (d.b-d.g) * c001.r + (d.g-d.r) * c011.r + (d.r) * c111.r;
             c.g = (1-d.b) * c000.g + (d.b-d.g) * c001.g + (d.g-d.r) * c011.g + (d.r) * c111.g;
             c.b = (1-d.b) * c000.b + (d.b-d.g) * c001.b + (d.g-d.r) * c011.b + (d.r) * c111.b;
         } else if (d.b > d.r) {
-            const struct rgbvec c010 = lut3d->lut[prev[0]][next[1]][prev[2]];
-            const struct rgbvec c011 = lut3d->lut[prev[0]][next[1]][next[2]];
+            const struct rgbvec c010 = lut[prev[0]][next[1]][prev[2]];
+            const struct rgbvec c011 = lut[prev[0]][next[1]][next[2]];
             c.r = (1-d.g) * c000.r + (d.g-d.b) * c010.r + (d.b-d.r) * c011.r + (d.r) * c111.r;
             c.g = (1-d.g) * c000.g + (d.g-d.b) * c010.g + (d.b-d.r) * c011.g + (d.r) * c111.g;
             c.b = (1-d.g) * c000.b + (d.g-d.b) * c010.b + (d.b-d.r) * c011.b + (d.r) * c111.b;
         } else {
-            const struct rgbvec c010 = lut3d->lut[prev[0]][next[1]][prev[2]];
-            const struct rgbvec c110 = lut3d->lut[next[0]][next[1]][prev[2]];
+            const struct rgbvec c010 = lut[prev[0]][next[1]][prev[2]];
+            const struct rgbvec c110 = lut[next[0]][next[1]][prev[2]];
             c.r = (1-d.g) * c000.r + (d.g-d.r) * c010.r + (d.r-d.b) * c110.r + (d.b) * c111.r;
             c.g = (1-d.g) * c000.g + (d.g-d.r) * c010.g + (d.r-d.b) * c110.g + (d.b) * c111.g;
             c.b = (1-d.g) * c000.b + (d.g-d.r) * c010.b + (d.r-d.b) * c110.b + (d.b) * c111.b;
@@ -201,6 +189,57 @@ static inline struct rgbvec interp_tetrahedral(const LUT3DContext *lut3d,
     return c;
 }
 
+#define DEFINE_INTERP_ROW(name, nbits)                                                          \
+static void interp_row_##name##_##nbits(uint8_t *const dst[3], const uint8_t *const src[3],    \
+                                        int width,                                              \
+                                        const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL],       \
+                                        int lutsize, const float *scale)                        \
+{                                                                                               \
+    uint##nbits##_t *dstr = (uint##nbits##_t *)dst[0];                                          \
+    uint##nbits##_t *dstg = (uint##nbits##_t *)dst[1];                                          \
+    uint##nbits##_t *dstb = (uint##nbits##_t *)dst[2];                                          \
+    const uint##nbits##_t *srcr = (const uint##nbits##_t *)src[0];                              \
+    const uint##nbits##_t *srcg = (const uint##nbits##_t *)src[1];                              \
+    const uint##nbits##_t *srcb = (const uint##nbits##_t *)src[2];                              \
+    const int max = scale[3];                                                                   \
+    int x;                                                                                      \
+                                                                                                \
+    for (x = 0; x < width; x++) {                                                               \
+        const struct rgbvec scaled_rgb = {srcr[x] * scale[0],                                   \
+                                          srcg[x] * scale[1],                                   \
+                                          srcb[x] * scale[2]};                                  \
+        struct rgbvec vec = interp_##name(lut, lutsize, &scaled_rgb);                           \
+        dstr[x] = av_clip(vec.r * scale[3], 0, max);                                            \
+        dstg[x] = av_clip(vec.g * scale[3], 0, max);                                            \
+        dstb[x] = av_clip(vec.b * scale[3], 0, max);                                            \
+    }                                                                                           \
+}
+
+DEFINE_INTERP_ROW(trilinear,    8)
+DEFINE_INTERP_ROW(trilinear,   16)
+DEFINE_INTERP_ROW(tetrahedral,  8)
+DEFINE_INTERP_ROW(tetrahedral, 16)
+
+av_cold void ff_lut3d_init_dsp(LUT3DDSPContext *dsp, int interpolation, int nbits)
+{
+    dsp->deinterleave_packed = 0;
+
+    switch (interpolation) {
+    case INTERPOLATE_TRILINEAR:
+        dsp->interp_row = nbits > 8 ? interp_row_trilinear_16 : interp_row_trilinear_8;
+        break;
+    case INTERPOLATE_TETRAHEDRAL:
+        dsp->interp_row = nbits > 8 ? interp_row_tetrahedral_16 : interp_row_tetrahedral_8;
+        break;
+    default:
+        dsp->interp_row = NULL;
+        return;
+    }
+
+    if (ARCH_X86)
+        ff_lut3d_init_dsp_x86(dsp, interpolation, nbits);
+}
+
 #define DEFINE_INTERP_FUNC_PLANAR(name, nbits, depth)                                                  \
 static int interp_##nbits##_##name##_p##depth(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs) \
 {                                                                                                      \
@@ -223,27 +262,33 @@ static int interp_##nbits##_##name##_p##depth(AVFilterContext *ctx, void *arg, i
     const float scale_r = (lut3d->scale.r / ((1<<depth) - 1)) * (lut3d->lutsize - 1);                  \
     const float scale_g = (lut3d->scale.g / ((1<<depth) - 1)) * (lut3d->lutsize - 1);                  \
     const float scale_b = (lut3d->scale.b / ((1<<depth) - 1)) * (lut3d->lutsize - 1);                  \
+    const float scale[4] = { scale_r, scale_g, scale_b, (1<<depth) - 1 };                              \
                                                                                                        \
     for (y = slice_start; y < slice_end; y++) {                                                        \
         uint##nbits##_t *dstg = (uint##nbits##_t *)grow;                                               \
         uint##nbits##_t *dstb = (uint##nbits##_t *)brow;                                               \
         uint##nbits##_t *dstr = (uint##nbits##_t *)rrow;                                               \
-        uint##nbits##_t *dsta = (uint##nbits##_t *)arow;                                               \
         const uint##nbits##_t *srcg = (const uint##nbits##_t *)srcgrow;                                \
         const uint##nbits##_t *srcb = (const uint##nbits##_t *)srcbrow;                                \
         const uint##nbits##_t *srcr = (const uint##nbits##_t *)srcrrow;                                \
-        const uint##nbits##_t *srca = (const uint##nbits##_t *)srcarow;                                \
-        for (x = 0; x < in->width; x++) {                                                              \
+        x = 0;                                                                                         \
+        if (lut3d->dsp.interp_row) {                                                                   \
+            uint8_t *const dst[3] = { rrow, grow, brow };                                              \
+            const uint8_t *const src[3] = { srcrrow, srcgrow, srcbrow };                               \
+            x = in->width & ~7;                                                                        \
+            lut3d->dsp.interp_row(dst, src, x, lut3d->lut, lut3d->lutsize, scale);                     \
+        }                                                                                              \
+        for (; x < in->width; x++) {                                                                   \
             const struct rgbvec scaled_rgb = {srcr[x] * scale_r,                                       \
                                               srcg[x] * scale_g,                                       \
                                               srcb[x] * scale_b};                                      \
-            struct rgbvec vec = interp_##name(lut3d, &scaled_rgb);                                     \
+            struct rgbvec vec = interp_##name(lut3d->lut, lut3d->lutsize, &scaled_rgb);                \
             dstr[x] = av_clip_uintp2(vec.r * (float)((1<<depth) - 1), depth);                          \
             dstg[x] = av_clip_uintp2(vec.g * (float)((1<<depth) - 1), depth);                          \
             dstb[x] = av_clip_uintp2(vec.b * (float)((1<<depth) - 1), depth);                          \
-            if (!direct && in->linesize[3])                                                            \
-                dsta[x] = srca[x];                                                                     \
         }                                                                                              \
+        if (!direct && in->linesize[3])                                                                \
+            memcpy(arow, srcarow, in->width * (nbits / 8));                                            \
         grow += out->linesize[0];                                                                      \
         brow += out->linesize[1];                                                                      \
         rrow += out->linesize[2];                                                                      \
@@ -280,6 +325,9 @@ DEFINE_INTERP_FUNC_PLANAR(nearest,     16, 16)
 DEFINE_INTERP_FUNC_PLANAR(trilinear,   16, 16)
 DEFINE_INTERP_FUNC_PLANAR(tetrahedral, 16, 16)
 
+/* number of packed pixels converted to planar at once */
+#define BLOCK_SIZE 64
+
 #define DEFINE_INTERP_FUNC(name, nbits)                                                             \
 static int interp_##nbits##_##name(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)         \
 {                                                                                                   \
@@ -301,15 +349,45 @@ static int interp_##nbits##_##name(AVFilterContext *ctx, void *arg, int jobnr, i
     const float scale_r = (lut3d->scale.r / ((1<<nbits) - 1)) * (lut3d->lutsize - 1);               \
     const float scale_g = (lut3d->scale.g / ((1<<nbits) - 1)) * (lut3d->lutsize - 1);               \
     const float scale_b = (lut3d->scale.b / ((1<<nbits) - 1)) * (lut3d->lutsize - 1);               \
+    const float scale[4] = { scale_r, scale_g, scale_b, (1<<nbits) - 1 };                           \
                                                                                                     \
     for (y = slice_start; y < slice_end; y++) {                                                     \
         uint##nbits##_t *dst = (uint##nbits##_t *)dstrow;                                           \
         const uint##nbits##_t *src = (const uint##nbits##_t *)srcrow;                               \
-        for (x = 0; x < in->width * step; x += step) {                                              \
+        int w;                                                                                      \
+        /* deinterleave blocks of pixels for the planar row function */                             \
+        for (x = 0; lut3d->deinterleave && x + 8 <= in->width; x += w) {                            \
+            DECLARE_ALIGNED(32, uint##nbits##_t, buf)[6][BLOCK_SIZE];                               \
+            uint8_t *const dstp[3] = { (uint8_t *)buf[3],                                           \
+                                       (uint8_t *)buf[4],                                           \
+                                       (uint8_t *)buf[5] };                                         \
+            const uint8_t *const srcp[3] = { (const uint8_t *)buf[0],                               \
+                                             (const uint8_t *)buf[1],                               \
+                                             (const uint8_t *)buf[2] };                             \
+            int i;                                                                                  \
+                                                                                                    \
+            w = FFMIN(in->width - x, BLOCK_SIZE) & ~7;                                              \
+            for (i = 0; i < w; i++) {                                                               \
+                const uint##nbits##_t *p = src + (x + i) * step;                                    \
+                buf[0][i] = p[r];                                                                   \
+                buf[1][i] = p[g];                                                                   \
+                buf[2][i] = p[b];                                                                   \
+            }                                                                                       \
+            lut3d->dsp.interp_row(dstp, srcp, w, lut3d->lut, lut3d->lutsize, scale);                \
+            for (i = 0; i < w; i++) {                                                               \
+                uint##nbits##_t *p = dst + (x + i) * step;                                          \
+                if (!direct && step == 4)                                                           \
+                    p[a] = src[(x + i) * step + a];                                                 \
+                p[r] = buf[3][i];                                                                   \
+                p[g] = buf[4][i];                                                                   \
+                p[b] = buf[5][i];                                                                   \
+            }                                                                                       \
+        }                                                                                           \
+        for (x *= step; x < in->width * step; x += step) {                                          \
             const struct rgbvec scaled_rgb = {src[x + r] * scale_r,                                 \
                                               src[x + g] * scale_g,                                 \
                                               src[x + b] * scale_b};                                \
-            struct rgbvec vec = interp_##name(lut3d, &scaled_rgb);                                  \
+            struct rgbvec vec = interp_##name(lut3d->lut, lut3d->lutsize, &scaled_rgb);             \
             dst[x + r] = av_clip_uint##nbits(vec.r * (float)((1<<nbits) - 1));                      \
             dst[x + g] = av_clip_uint##nbits(vec.g * (float)((1<<nbits) - 1));                      \
             dst[x + b] = av_clip_uint##nbits(vec.b * (float)((1<<nbits) - 1));                      \
@@ -721,6 +799,9 @@ static int config_input(AVFilterLink *inlink)
         av_assert0(0);
     }
 
+    ff_lut3d_init_dsp(&lut3d->dsp, lut3d->interpolation, depth);
+    lut3d->deinterleave = !planar && lut3d->dsp.deinterleave_packed;
+
     return 0;
 }
 
@@ -333,6 +333,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
                 }
         }
     }
+    emms_c();
 
     return ff_filter_frame(ctx->outputs[0], out);
 }
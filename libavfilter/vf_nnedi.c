@@ -22,7 +22,6 @@
 #include <float.h>
 
 #include "libavutil/common.h"
-#include "libavutil/float_dsp.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
@@ -30,6 +29,7 @@
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
+#include "vf_nnedidsp.h"
 
 typedef struct FrameData {
     uint8_t *paddedp[3];
@@ -43,8 +43,10 @@ typedef struct FrameData {
     int field[3];
 
     int32_t *lcount[3];
-    float *input;
-    float *temp;
+    float *input;           ///< per-job input buffers, 512 floats each
+    float *temp;            ///< per-job scratch buffers, temp_size bytes each
+    size_t temp_size;
+    int nb_threads;
 } FrameData;
 
 typedef struct NNEDIContext {
@@ -58,7 +60,7 @@ typedef struct NNEDIContext {
     int eof;
     int64_t cur_pts;
 
-    AVFloatDSPContext *fdsp;
+    NNEDIDSPContext dsp;
     int nb_planes;
     int linesize[4];
     int planeheight[4];
@@ -84,8 +86,8 @@ typedef struct NNEDIContext {
     int max_value;
 
     void (*copy_pad)(const AVFrame *, FrameData *, struct NNEDIContext *, int);
-    void (*evalfunc_0)(struct NNEDIContext *, FrameData *);
-    void (*evalfunc_1)(struct NNEDIContext *, FrameData *);
+    void (*evalfunc_0)(struct NNEDIContext *, FrameData *, int jobnr, int nb_jobs);
+    void (*evalfunc_1)(struct NNEDIContext *, FrameData *, int jobnr, int nb_jobs);
 
     // Functions used in evalfunc_0
     void (*readpixels)(const uint8_t *, const int, float *);
@@ -265,24 +267,25 @@ static void elliott(float *data, const int n)
         data[i] = data[i] / (1.0f + FFABS(data[i]));
 }
 
-static void dot_prod(NNEDIContext *s, const float *data, const float *weights, float *vals, const int n, const int len, const float *scale)
+static void dot_prod_c(const float *data, const float *weights, float *vals,
+                       int n, int len, const float *scale)
 {
-    int i;
+    int i, j;
 
     for (i = 0; i < n; i++) {
-        float sum;
+        float sum = 0;
 
-        sum = s->fdsp->scalarproduct_float(data, &weights[i * len], len);
+        for (j = 0; j < len; j++)
+            sum += data[j] * weights[i * len + j];
 
         vals[i] = sum * scale[0] + weights[n * len + i];
     }
 }
 
-static void dot_prods(NNEDIContext *s, const float *dataf, const float *weightsf, float *vals, const int n, const int len, const float *scale)
+static void dot_prods_c(const int16_t *data, const int16_t *weights, float *vals,
+                        int n, int len, const float *scale)
 {
-    const int16_t *data = (int16_t *)dataf;
-    const int16_t *weights = (int16_t *)weightsf;
-    const float *wf = (float *)&weights[n * len];
+    const float *wf = (const float *)&weights[n * len];
     int i, j;
 
     for (i = 0; i < n; i++) {
@@ -294,6 +297,35 @@ static void dot_prods(NNEDIContext *s, const float *dataf, const float *weightsf
     }
 }
 
+av_cold void ff_nnedi_init(NNEDIDSPContext *dsp)
+{
+    dsp->dot_prod  = dot_prod_c;
+    dsp->dot_prods = dot_prods_c;
+
+    if (ARCH_X86)
+        ff_nnedi_init_x86(dsp);
+}
+
+/* the simd versions only handle rows that are a multiple of 16 long */
+static void dot_prod(NNEDIContext *s, const float *data, const float *weights, float *vals, const int n, const int len, const float *scale)
+{
+    if (len & 15)
+        dot_prod_c(data, weights, vals, n, len, scale);
+    else
+        s->dsp.dot_prod(data, weights, vals, n, len, scale);
+}
+
+static void dot_prods(NNEDIContext *s, const float *dataf, const float *weightsf, float *vals, const int n, const int len, const float *scale)
+{
+    const int16_t *data = (int16_t *)dataf;
+    const int16_t *weights = (int16_t *)weightsf;
+
+    if (len & 15)
+        dot_prods_c(data, weights, vals, n, len, scale);
+    else
+        s->dsp.dot_prods(data, weights, vals, n, len, scale);
+}
+
 static void compute_network0(NNEDIContext *s, const float *input, const float *weights, uint8_t *d)
 {
     float t, temp[12], scale = 1.0f;
@@ -415,12 +447,11 @@ static void compute_network0new(NNEDIContext *s, const float *datai, const float
     ((int *)d)[0] = mask;
 }
 
-static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
+static void evalfunc_0(NNEDIContext *s, FrameData *frame_data, int jobnr, int nb_jobs)
 {
-    float *input = frame_data->input;
+    float *input = frame_data->input + jobnr * 512;
     const float *weights0 = s->weights0;
-    float *temp = frame_data->temp;
-    uint8_t *tempu = (uint8_t *)temp;
+    uint8_t *tempu = (uint8_t *)frame_data->temp + jobnr * frame_data->temp_size;
     int plane, x, y;
 
     // And now the actual work.
@@ -431,31 +462,35 @@ static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
         const int width = frame_data->padded_width[plane];
         const int height = frame_data->padded_height[plane];
 
+        const int field = frame_data->field[plane];
+        const int slice_start = ((height - 12) *  jobnr     ) / nb_jobs;
+        const int slice_end   = ((height - 12) * (jobnr + 1)) / nb_jobs;
+        const int ystart = slice_start + ((slice_start & 1) != field);
         uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
         const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
         const uint8_t *src3p;
-        int ystart, ystop;
         int32_t *lcount;
 
         if (!(s->process_plane & (1 << plane)))
             continue;
 
-        for (y = 1 - frame_data->field[plane]; y < height - 12; y += 2) {
+        for (y = slice_start; y < slice_end; y++) {
+            if ((y & 1) == field)
+                continue;
             memcpy(dstp + y * dst_stride,
                    srcp + 32 + (6 + y) * src_stride,
                    (width - 64) * sizeof(uint8_t));
 
         }
 
-        ystart = 6 + frame_data->field[plane];
-        ystop = height - 6;
-        srcp += ystart * src_stride;
-        dstp += (ystart - 6) * dst_stride - 32;
-        src3p = srcp - src_stride * 3;
-        lcount = frame_data->lcount[plane] - 6;
+        // Rows are addressed in output coordinates, the padded source
+        // starts 6 lines above.
+        src3p = srcp + (ystart + 3) * src_stride;
+        dstp += ystart * dst_stride - 32;
+        lcount = frame_data->lcount[plane];
 
         if (s->pscrn == 1) { // original
-            for (y = ystart; y < ystop; y += 2) {
+            for (y = ystart; y < slice_end; y += 2) {
                 for (x = 32; x < width - 32; x++) {
                     s->readpixels((const uint8_t *)(src3p + x - 5), src_stride, input);
                     s->compute_network0(s, input, weights0, tempu+x);
@@ -465,7 +500,7 @@ static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
                 dstp += dst_stride * 2;
             }
         } else if (s->pscrn > 1) { // new
-            for (y = ystart; y < ystop; y += 2) {
+            for (y = ystart; y < slice_end; y += 2) {
                 for (x = 32; x < width - 32; x += 4) {
                     s->readpixels((const uint8_t *)(src3p + x - 6), src_stride, input);
                     s->compute_network0(s, input, weights0, tempu + x);
@@ -475,7 +510,7 @@ static void evalfunc_0(NNEDIContext *s, FrameData *frame_data)
                 dstp += dst_stride * 2;
             }
         } else { // no prescreening
-            for (y = ystart; y < ystop; y += 2) {
+            for (y = ystart; y < slice_end; y += 2) {
                 memset(dstp + 32, 255, (width - 64) * sizeof(uint8_t));
                 lcount[y] += width - 64;
                 dstp += dst_stride * 2;
@@ -575,10 +610,10 @@ static void weighted_avg_elliott_mul5_m16(const float *w, const int n, float *ms
 }
 
 
-static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
+static void evalfunc_1(NNEDIContext *s, FrameData *frame_data, int jobnr, int nb_jobs)
 {
-    float *input = frame_data->input;
-    float *temp = frame_data->temp;
+    float *input = frame_data->input + jobnr * 512;
+    float *temp = (float *)((uint8_t *)frame_data->temp + jobnr * frame_data->temp_size);
     float **weights1 = s->weights1;
     const int qual = s->qual;
     const int asize = s->asize;
@@ -599,8 +634,10 @@ static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
         uint8_t *dstp = (uint8_t *)frame_data->dstp[plane];
         const int dst_stride = frame_data->dst_stride[plane] / sizeof(uint8_t);
 
-        const int ystart = frame_data->field[plane];
-        const int ystop = height - 12;
+        const int field = frame_data->field[plane];
+        const int slice_start = ((height - 12) *  jobnr     ) / nb_jobs;
+        const int slice_end   = ((height - 12) * (jobnr + 1)) / nb_jobs;
+        const int ystart = slice_start + ((slice_start & 1) != field);
         const uint8_t *srcpp;
 
         if (!(s->process_plane & (1 << plane)))
@@ -610,7 +647,7 @@ static void evalfunc_1(NNEDIContext *s, FrameData *frame_data)
         dstp += ystart * dst_stride - 32;
         srcpp = srcp - (ydia - 1) * src_stride - xdiad2m1;
 
-        for (y = ystart; y < ystop; y += 2) {
+        for (y = ystart; y < slice_end; y += 2) {
             for (x = 32; x < width - 32; x++) {
                 float mstd[4];
 
@@ -679,6 +716,20 @@ static void select_functions(NNEDIContext *s)
     s->expfunc = e2_m16;
 }
 
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    NNEDIContext *s = ctx->priv;
+    FrameData *frame_data = arg;
+
+    // Handles prescreening and the cubic interpolation.
+    s->evalfunc_0(s, frame_data, jobnr, nb_jobs);
+
+    // The rest.
+    s->evalfunc_1(s, frame_data, jobnr, nb_jobs);
+
+    return 0;
+}
+
 static int modnpf(const int m, const int n)
 {
     if ((m % n) == 0)
@@ -766,27 +817,26 @@ static int get_frame(AVFilterContext *ctx, int is_second)
     }
 
     if (!frame_data->input) {
-        frame_data->input = av_malloc(512 * sizeof(float));
+        frame_data->nb_threads = ff_filter_get_nb_threads(ctx);
+        frame_data->input = av_malloc_array(frame_data->nb_threads, 512 * sizeof(float));
         if (!frame_data->input)
             return AVERROR(ENOMEM);
     }
     // evalfunc_0 requires at least padded_width[0] bytes.
     // evalfunc_1 requires at least 512 floats.
     if (!frame_data->temp) {
-        temp_size = FFMAX(frame_data->padded_width[0], 512 * sizeof(float));
-        frame_data->temp = av_malloc(temp_size);
+        temp_size = FFALIGN(FFMAX(frame_data->padded_width[0], 512 * sizeof(float)), 64);
+        frame_data->temp = av_malloc_array(frame_data->nb_threads, temp_size);
         if (!frame_data->temp)
             return AVERROR(ENOMEM);
+        frame_data->temp_size = temp_size;
     }
 
     // Copy src to a padded "frame" in frame_data and mirror the edges.
     s->copy_pad(src, frame_data, s, field_n);
 
-    // Handles prescreening and the cubic interpolation.
-    s->evalfunc_0(s, frame_data);
-
-    // The rest.
-    s->evalfunc_1(s, frame_data);
+    ctx->internal->execute(ctx, filter_slice, frame_data, NULL,
+                           FFMIN(s->planeheight[1], frame_data->nb_threads));
 
     return 0;
 }
@@ -1147,9 +1197,7 @@ static av_cold int init(AVFilterContext *ctx)
 
     select_functions(s);
 
-    s->fdsp = avpriv_float_dsp_alloc(0);
-    if (!s->fdsp)
-        ret = AVERROR(ENOMEM);
+    ff_nnedi_init(&s->dsp);
 
 fail:
     av_free(bdata);
@@ -1173,7 +1221,6 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_freep(&s->frame_data.input);
     av_freep(&s->frame_data.temp);
-    av_freep(&s->fdsp);
     av_frame_free(&s->second);
 }
 
@@ -1207,5 +1254,5 @@ AVFilter ff_vf_nnedi = {
     .query_formats = query_formats,
     .inputs        = inputs,
     .outputs       = outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
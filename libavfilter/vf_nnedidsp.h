@@ -0,0 +1,48 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_NNEDIDSP_H
+#define AVFILTER_NNEDIDSP_H
+
+#include <stdint.h>
+
+typedef struct NNEDIDSPContext {
+    /**
+     * Evaluate n neurons on the same input:
+     * vals[i] = dot(data, weights + i * len) * scale[0] + weights[n * len + i]
+     *
+     * n is a multiple of 4 and len a multiple of 16.
+     */
+    void (*dot_prod)(const float *data, const float *weights, float *vals,
+                     int n, int len, const float *scale);
+
+    /**
+     * int16 variant of dot_prod. The per-neuron multipliers and biases
+     * follow the n * len weights as floats, interleaved in groups of four
+     * (4 multipliers, 4 biases, ...).
+     *
+     * n is a multiple of 4 and len a multiple of 16.
+     */
+    void (*dot_prods)(const int16_t *data, const int16_t *weights, float *vals,
+                      int n, int len, const float *scale);
+} NNEDIDSPContext;
+
+void ff_nnedi_init(NNEDIDSPContext *dsp);
+void ff_nnedi_init_x86(NNEDIDSPContext *dsp);
+
+#endif /* AVFILTER_NNEDIDSP_H */
@@ -42,7 +42,9 @@
 #include "vf_overlay.h"
 
 typedef struct ThreadData {
-    AVFrame *dst, *src;
+    AVFrame *dst;
+    const AVFrame *src;
+    int x, y;                   ///< position of src in dst
 } ThreadData;
 
 static const char *const var_names[] = {
@@ -83,6 +85,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     OverlayContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
+    av_frame_free(&s->overlay_crop);
+    av_buffer_unref(&s->alpha_box_buf);
     av_expr_free(s->x_pexpr); s->x_pexpr = NULL;
     av_expr_free(s->y_pexpr); s->y_pexpr = NULL;
 }
@@ -657,161 +661,141 @@ static av_always_inline void blend_slice_planar_rgb(AVFilterContext *ctx,
 
 static int blend_slice_yuv420(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 0, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 0, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuva420(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 1, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 1, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuv422(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 0, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 0, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuva422(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 1, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 1, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuv444(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 0, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 0, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuva444(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 1, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 1, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_gbrp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 0, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 0, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_gbrap(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 1, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 1, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuv420_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 0, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 0, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuva420_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 1, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 1, 1, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuv422_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 0, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 0, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuva422_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 1, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 1, 0, 1, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuv444_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 0, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 0, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_yuva444_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 1, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_yuv(ctx, td->dst, td->src, 0, 0, 1, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_gbrp_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 0, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 0, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_gbrap_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 1, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_planar_rgb(ctx, td->dst, td->src, 0, 0, 1, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_rgb(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_packed_rgb(ctx, td->dst, td->src, 0, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_packed_rgb(ctx, td->dst, td->src, 0, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_rgba(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_packed_rgb(ctx, td->dst, td->src, 1, s->x, s->y, 1, jobnr, nb_jobs);
+    blend_slice_packed_rgb(ctx, td->dst, td->src, 1, td->x, td->y, 1, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_rgb_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_packed_rgb(ctx, td->dst, td->src, 0, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_packed_rgb(ctx, td->dst, td->src, 0, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
 static int blend_slice_rgba_pm(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    OverlayContext *s = ctx->priv;
     ThreadData *td = arg;
-    blend_slice_packed_rgb(ctx, td->dst, td->src, 1, s->x, s->y, 0, jobnr, nb_jobs);
+    blend_slice_packed_rgb(ctx, td->dst, td->src, 1, td->x, td->y, 0, jobnr, nb_jobs);
     return 0;
 }
 
@@ -927,13 +911,123 @@ end:
     return 0;
 }
 
+static int row_is_transparent(const uint8_t *a, int w, int step)
+{
+    unsigned v = 0;
+    int x;
+
+    if (step == 1) {
+        for (x = 0; x < w; x++)
+            v |= a[x];
+    } else {
+        for (x = 0; x < w; x++)
+            v |= a[x * step];
+    }
+    return !v;
+}
+
+static void find_alpha_box(const uint8_t *a, ptrdiff_t linesize, int step,
+                           int w, int h, int box[4])
+{
+    int x, y, x0 = w, x1 = 0, y0, y1;
+
+    for (y0 = 0; y0 < h && row_is_transparent(a + y0 * linesize, w, step); y0++);
+    if (y0 == h) {
+        box[0] = box[1] = box[2] = box[3] = 0;
+        return;
+    }
+    for (y1 = h; row_is_transparent(a + (y1 - 1) * linesize, w, step); y1--);
+
+    for (y = y0; y < y1; y++) {
+        const uint8_t *row = a + y * linesize;
+
+        for (x = 0;  x < x0 && !row[ x      * step]; x++);
+        x0 = x;
+        for (x = w;  x > x1 && !row[(x - 1) * step]; x--);
+        x1 = x;
+    }
+
+    box[0] = x0;
+    box[1] = y0;
+    box[2] = x1;
+    box[3] = y1;
+}
+
+/**
+ * Restrict the overlay frame to the area holding non transparent pixels.
+ *
+ * The area is found once per overlay picture: the same frame is usually
+ * blended on many main frames, a still subtitle for instance.
+ *
+ * @return the overlay frame or a cropped view of it, with x and y updated
+ *         accordingly, or NULL if the frame is fully transparent
+ */
+static const AVFrame *crop_transparent_borders(OverlayContext *s, AVFrame *src,
+                                               int *x, int *y)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(src->format);
+    const int hsub = desc->log2_chroma_w;
+    const int vsub = desc->log2_chroma_h;
+    const int plane  = s->overlay_is_packed_rgb ? 0 : 3;
+    const int offset = s->overlay_is_packed_rgb ? s->overlay_rgba_map[A] : 0;
+    const int step   = s->overlay_is_packed_rgb ? s->overlay_pix_step[0] : 1;
+    const int *box = s->alpha_box;
+    AVBufferRef *buf = av_frame_get_plane_buffer(src, plane);
+    AVFrame *crop = s->overlay_crop;
+    int x0, y0, x1, y1, i;
+
+    if (!buf)
+        return src;
+
+    /* holding a reference keeps the buffer from being written to or reused */
+    if (!s->alpha_box_buf || s->alpha_box_buf->buffer != buf->buffer ||
+        s->alpha_box_data != src->data[plane] ||
+        s->alpha_box_w != src->width || s->alpha_box_h != src->height) {
+        av_buffer_unref(&s->alpha_box_buf);
+        find_alpha_box(src->data[plane] + offset, src->linesize[plane], step,
+                       src->width, src->height, s->alpha_box);
+        s->alpha_box_buf  = av_buffer_ref(buf);
+        s->alpha_box_data = src->data[plane];
+        s->alpha_box_w    = src->width;
+        s->alpha_box_h    = src->height;
+    }
+
+    if (box[2] <= box[0])
+        return NULL;
+
+    /* keep whole chroma samples, plus one transparent sample after the box
+     * so that the alpha averaging at its edges is unchanged */
+    x0 = box[0] >> hsub << hsub;
+    y0 = box[1] >> vsub << vsub;
+    x1 = FFMIN(FFALIGN(box[2], 1 << hsub) + (hsub << hsub), src->width);
+    y1 = FFMIN(FFALIGN(box[3], 1 << vsub) + (vsub << vsub), src->height);
+    if (!x0 && !y0 && x1 == src->width && y1 == src->height)
+        return src;
+
+    crop->format = src->format;
+    crop->width  = x1 - x0;
+    crop->height = y1 - y0;
+    for (i = 0; i < 4 && src->data[i]; i++) {
+        int hs = i == 1 || i == 2 ? hsub : 0;
+        int vs = i == 1 || i == 2 ? vsub : 0;
+
+        crop->data[i]     = src->data[i] + (y0 >> vs) * src->linesize[i] +
+                                           (x0 >> hs) * s->overlay_pix_step[i];
+        crop->linesize[i] = src->linesize[i];
+    }
+    *x += x0;
+    *y += y0;
+    return crop;
+}
+
 static int do_blend(FFFrameSync *fs)
 {
     AVFilterContext *ctx = fs->parent;
     AVFrame *mainpic, *second;
+    const AVFrame *src;
     OverlayContext *s = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
-    int ret;
+    int ret, x, y;
 
     ret = ff_framesync_dualinput_get_writable(fs, &mainpic, &second);
     if (ret < 0)
@@ -961,13 +1055,23 @@ static int do_blend(FFFrameSync *fs)
                s->var_values[VAR_Y], s->y);
     }
 
-    if (s->x < mainpic->width  && s->x + second->width  >= 0 &&
-        s->y < mainpic->height && s->y + second->height >= 0) {
+    x = s->x;
+    y = s->y;
+    src = second;
+    /* fully transparent pixels leave the main picture untouched */
+    if (s->overlay_has_alpha && !s->alpha_format)
+        src = crop_transparent_borders(s, second, &x, &y);
+
+    if (src &&
+        x < mainpic->width  && x + src->width  >= 0 &&
+        y < mainpic->height && y + src->height >= 0) {
         ThreadData td;
 
         td.dst = mainpic;
-        td.src = second;
-        ctx->internal->execute(ctx, s->blend_slice, &td, NULL, FFMIN(FFMAX(1, FFMIN3(s->y + second->height, FFMIN(second->height, mainpic->height), mainpic->height - s->y)),
+        td.src = src;
+        td.x   = x;
+        td.y   = y;
+        ctx->internal->execute(ctx, s->blend_slice, &td, NULL, FFMIN(FFMAX(1, FFMIN3(y + src->height, FFMIN(src->height, mainpic->height), mainpic->height - y)),
                                                                      ff_filter_get_nb_threads(ctx)));
     }
     return ff_filter_frame(ctx->outputs[0], mainpic);
@@ -977,6 +1081,10 @@ static av_cold int init(AVFilterContext *ctx)
 {
     OverlayContext *s = ctx->priv;
 
+    s->overlay_crop = av_frame_alloc();
+    if (!s->overlay_crop)
+        return AVERROR(ENOMEM);
+
     s->fs.on_event = do_blend;
     return 0;
 }
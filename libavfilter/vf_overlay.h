@@ -78,6 +78,12 @@ typedef struct OverlayContext {
     int (*blend_row[4])(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a, int w,
                         ptrdiff_t alinesize);
     int (*blend_slice)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
+
+    AVFrame *overlay_crop;      ///< visible part of the overlay frame
+    AVBufferRef *alpha_box_buf; ///< buffer of the overlay alpha the box was found in
+    const uint8_t *alpha_box_data;
+    int alpha_box_w, alpha_box_h;
+    int alpha_box[4];           ///< x0, y0, x1, y1 of the non transparent area
 } OverlayContext;
 
 void ff_overlay_init_x86(OverlayContext *s, int format, int pix_format,
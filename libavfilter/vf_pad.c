@@ -27,6 +27,7 @@
 #include <float.h>  /* DBL_MAX */
 
 #include "avfilter.h"
+#include "filters.h"
 #include "formats.h"
 #include "internal.h"
 #include "video.h"
@@ -107,7 +108,7 @@ static int config_input(AVFilterLink *inlink)
     AVFilterContext *ctx = inlink->dst;
     PadContext *s = ctx->priv;
     AVRational adjusted_aspect = s->aspect;
-    int ret;
+    int ret, border[4];
     double var_values[VARS_NB], res;
     char *expr;
 
@@ -207,6 +208,14 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
+    /* let the frames modified in place before us be allocated with room
+     * for the padding */
+    border[0] = s->x;
+    border[1] = s->y;
+    border[2] = s->w - s->x - inlink->w;
+    border[3] = s->h - s->y - inlink->h;
+    ff_inlink_set_reserve_border(inlink, border);
+
     return 0;
 
 eval_fail:
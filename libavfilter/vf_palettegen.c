@@ -49,6 +49,7 @@ struct range_box {
 struct hist_node {
     struct color_ref *entries;
     int nb_entries;
+    int nb_allocated;
 };
 
 enum {
@@ -61,6 +62,8 @@ enum {
 #define NBITS 5
 #define HIST_SIZE (1<<(3*NBITS))
 
+#define MAX_THREADS 16
+
 typedef struct PaletteGenContext {
     const AVClass *class;
 
@@ -70,6 +73,8 @@ typedef struct PaletteGenContext {
 
     AVFrame *prev_frame;                    // previous frame used for the diff stats_mode
     struct hist_node histogram[HIST_SIZE];  // histogram/hashtable of the colors
+    struct hist_node (*thread_hist)[HIST_SIZE]; // per slice histograms, merged into histogram after each frame
+    int nb_threads;                         // number of thread_hist
     struct color_ref **refs;                // references of all the colors used in the stream
     int nb_refs;                            // number of color references (or number of different colors)
     struct range_box boxes[256];            // define the segmentation of the colorspace (the final palette)
@@ -403,9 +408,11 @@ static inline unsigned color_hash(uint32_t color)
 }
 
 /**
- * Locate the color in the hash table and increment its counter.
+ * Locate the color in the hash table and add count to its counter.
+ * New colors are appended to their bucket, so the order of the entries
+ * only depends on the order the colors are first seen.
  */
-static int color_inc(struct hist_node *hist, uint32_t color)
+static int color_add(struct hist_node *hist, uint32_t color, uint64_t count)
 {
     int i;
     const unsigned hash = color_hash(color);
@@ -415,36 +422,63 @@ static int color_inc(struct hist_node *hist, uint32_t color)
     for (i = 0; i < node->nb_entries; i++) {
         e = &node->entries[i];
         if (e->color == color) {
-            e->count++;
+            e->count += count;
             return 0;
         }
     }
 
-    e = av_dynarray2_add((void**)&node->entries, &node->nb_entries,
-                         sizeof(*node->entries), NULL);
-    if (!e)
-        return AVERROR(ENOMEM);
+    if (node->nb_entries == node->nb_allocated) {
+        const int nb_allocated = FFMAX(4, 2 * node->nb_allocated);
+        e = av_realloc_array(node->entries, nb_allocated, sizeof(*node->entries));
+        if (!e)
+            return AVERROR(ENOMEM);
+        node->entries      = e;
+        node->nb_allocated = nb_allocated;
+    }
+    e = &node->entries[node->nb_entries++];
     e->color = color;
-    e->count = 1;
+    e->count = count;
     return 1;
 }
 
+typedef struct ThreadData {
+    const AVFrame *f1, *f2;
+} ThreadData;
+
 /**
- * Update histogram when pixels differ from previous frame.
+ * Update the histogram with the lines of a slice of f1, only counting the
+ * pixels which differ from f2 if it is set. Runs of the same color are
+ * accounted at once.
  */
-static int update_histogram_diff(struct hist_node *hist,
-                                 const AVFrame *f1, const AVFrame *f2)
+static int update_histogram_slice(struct hist_node *hist, const AVFrame *f1, const AVFrame *f2,
+                                  int slice_start, int slice_end)
 {
     int x, y, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f1->height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         const uint32_t *p = (const uint32_t *)(f1->data[0] + y*f1->linesize[0]);
-        const uint32_t *q = (const uint32_t *)(f2->data[0] + y*f2->linesize[0]);
+        const uint32_t *q = f2 ? (const uint32_t *)(f2->data[0] + y*f2->linesize[0]) : NULL;
+        uint32_t color = 0;
+        uint64_t run = 0;
 
         for (x = 0; x < f1->width; x++) {
-            if (p[x] == q[x])
+            if (q && p[x] == q[x])
                 continue;
-            ret = color_inc(hist, p[x]);
+            if (run && p[x] == color) {
+                run++;
+                continue;
+            }
+            if (run) {
+                ret = color_add(hist, color, run);
+                if (ret < 0)
+                    return ret;
+                nb_diff_colors += ret;
+            }
+            color = p[x];
+            run   = 1;
+        }
+        if (run) {
+            ret = color_add(hist, color, run);
             if (ret < 0)
                 return ret;
             nb_diff_colors += ret;
@@ -453,21 +487,55 @@ static int update_histogram_diff(struct hist_node *hist,
     return nb_diff_colors;
 }
 
+static int update_histogram_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteGenContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int height = td->f1->height;
+    const int slice_start = (height *  jobnr     ) / nb_jobs;
+    const int slice_end   = (height * (jobnr + 1)) / nb_jobs;
+
+    return update_histogram_slice(nb_jobs > 1 ? s->thread_hist[jobnr] : s->histogram,
+                                  td->f1, td->f2, slice_start, slice_end);
+}
+
 /**
- * Simple histogram of the frame.
+ * Update the histogram with a frame (or its difference with the previous
+ * one). With several threads, each slice fills its own histogram. They are
+ * merged in slice order afterwards, which keeps the colors in the order a
+ * single thread would have seen them.
  */
-static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
+static int update_histogram(AVFilterContext *ctx, const AVFrame *f1, const AVFrame *f2)
 {
-    int x, y, ret, nb_diff_colors = 0;
+    PaletteGenContext *s = ctx->priv;
+    const int nb_jobs = FFMIN(f1->height, s->nb_threads);
+    ThreadData td = { .f1 = f1, .f2 = f2 };
+    int rets[MAX_THREADS];
+    int i, j, k, ret, nb_diff_colors = 0;
 
-    for (y = 0; y < f->height; y++) {
-        const uint32_t *p = (const uint32_t *)(f->data[0] + y*f->linesize[0]);
+    if (nb_jobs <= 1)
+        return update_histogram_slice(s->histogram, f1, f2, 0, f1->height);
 
-        for (x = 0; x < f->width; x++) {
-            ret = color_inc(hist, p[x]);
-            if (ret < 0)
-                return ret;
-            nb_diff_colors += ret;
+    ctx->internal->execute(ctx, update_histogram_job, &td, rets, nb_jobs);
+
+    for (k = 0; k < nb_jobs; k++)
+        if (rets[k] < 0)
+            nb_diff_colors = rets[k];
+
+    for (k = 0; k < nb_jobs; k++) {
+        struct hist_node *hist = s->thread_hist[k];
+
+        for (j = 0; j < HIST_SIZE; j++) {
+            struct hist_node *node = &hist[j];
+
+            for (i = 0; i < node->nb_entries && nb_diff_colors >= 0; i++) {
+                ret = color_add(s->histogram, node->entries[i].color, node->entries[i].count);
+                if (ret < 0)
+                    nb_diff_colors = ret;
+                else
+                    nb_diff_colors += ret;
+            }
+            node->nb_entries = 0;
         }
     }
     return nb_diff_colors;
@@ -480,8 +548,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     PaletteGenContext *s = ctx->priv;
-    int ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in)
-                            : update_histogram_frame(s->histogram, in);
+    int ret = s->prev_frame ? update_histogram(ctx, s->prev_frame, in)
+                            : update_histogram(ctx, in, NULL);
 
     if (ret > 0)
         s->nb_refs += ret;
@@ -530,6 +598,22 @@ static int request_frame(AVFilterLink *outlink)
     return r;
 }
 
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    PaletteGenContext *s = ctx->priv;
+
+    if (!s->thread_hist) {
+        s->nb_threads = FFMIN(ff_filter_get_nb_threads(ctx), MAX_THREADS);
+        if (s->nb_threads > 1) {
+            s->thread_hist = av_calloc(s->nb_threads, sizeof(*s->thread_hist));
+            if (!s->thread_hist)
+                return AVERROR(ENOMEM);
+        }
+    }
+    return 0;
+}
+
 /**
  * The output is one simple 16x16 squared-pixels palette.
  */
@@ -542,11 +626,17 @@ static int config_output(AVFilterLink *outlink)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
+    int i, j;
     PaletteGenContext *s = ctx->priv;
 
     for (i = 0; i < HIST_SIZE; i++)
         av_freep(&s->histogram[i].entries);
+    if (s->thread_hist) {
+        for (j = 0; j < s->nb_threads; j++)
+            for (i = 0; i < HIST_SIZE; i++)
+                av_freep(&s->thread_hist[j][i].entries);
+        av_freep(&s->thread_hist);
+    }
     av_freep(&s->refs);
     av_frame_free(&s->prev_frame);
 }
@@ -555,6 +645,7 @@ static const AVFilterPad palettegen_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
     { NULL }
@@ -579,4 +670,5 @@ AVFilter ff_vf_palettegen = {
     .inputs        = palettegen_inputs,
     .outputs       = palettegen_outputs,
     .priv_class    = &palettegen_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -25,12 +25,15 @@
 
 #include "libavutil/bprint.h"
 #include "libavutil/internal.h"
+#include "libavutil/mem.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
+#include "libavutil/thread.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "framesync.h"
 #include "internal.h"
+#include "vf_paletteusedsp.h"
 
 enum dithering_mode {
     DITHERING_NONE,
@@ -75,17 +78,32 @@ struct cache_node {
     int nb_entries;
 };
 
+/* Error diffusion rows synchronize with the row above every ROW_SYNC_STEP
+ * pixels. */
+#define ROW_SYNC_STEP 32
+
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              AVFrame *out, AVFrame *in,
+                              int x_start, int y_start, int width, int height,
+                              int slice_start, int slice_end);
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node (*cache)[CACHE_SIZE]; /* lookup cache, one per thread */
+    int nb_caches;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
+    uint32_t bf_rgb[AVPALETTE_COUNT];       /* palette without alpha, for the brute-force search */
+    uint32_t bf_keys[AVPALETTE_COUNT];      /* palette index, plus PALETTEUSE_KEY_SKIP for transparent entries */
+    PaletteUseDSPContext dsp;
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
     int trans_thresh;
     int palette_loaded;
@@ -98,6 +116,13 @@ typedef struct PaletteUseContext {
     AVFrame *last_in;
     AVFrame *last_out;
 
+    int *row_progress;  /* number of pixels dithered in each row */
+    int row_sync;       /* error diffusion rows run as a wavefront */
+#if HAVE_THREADS
+    pthread_mutex_t row_mutex;
+    pthread_cond_t row_cond;
+#endif
+
     /* debug options */
     char *dot_filename;
     int color_search_method;
@@ -332,13 +357,47 @@ end:
     search == COLOR_SEARCH_NNS_RECURSIVE ? colormap_nearest_recursive(root, target, trans_thresh) :      \
                                            colormap_nearest_bruteforce(palette, target, trans_thresh)
 
+static unsigned nearest_key_c(const uint32_t *rgb, const uint32_t *keys, uint32_t color)
+{
+    const int r = color >> 16 & 0xff;
+    const int g = color >>  8 & 0xff;
+    const int b = color       & 0xff;
+    unsigned i, min_key = UINT_MAX;
+
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        const int dr = (rgb[i] >> 16 & 0xff) - r;
+        const int dg = (rgb[i] >>  8 & 0xff) - g;
+        const int db = (rgb[i]       & 0xff) - b;
+        const unsigned key = (unsigned)(dr*dr + dg*dg + db*db) << 8 | keys[i];
+        min_key = FFMIN(min_key, key);
+    }
+    return min_key;
+}
+
+av_cold void ff_paletteuse_init(PaletteUseDSPContext *dsp)
+{
+    dsp->nearest_key = nearest_key_c;
+    if (ARCH_X86)
+        ff_paletteuse_init_x86(dsp);
+}
+
+/**
+ * Same result as colormap_nearest_bruteforce() for opaque targets, using the
+ * flat tables prepared in load_colormap().
+ */
+static av_always_inline uint8_t colormap_nearest_bruteforce_fast(const PaletteUseContext *s, uint32_t color)
+{
+    const unsigned key = s->dsp.nearest_key(s->bf_rgb, s->bf_keys, color & 0xffffff);
+    return key < PALETTEUSE_KEY_SKIP ? key & 0xff : -1;
+}
+
 /**
  * Check if the requested color is in the cache already. If not, find it in the
  * color tree and cache it.
  * Note: a, r, g, and b are the components of color, but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache, uint32_t color,
                                       uint8_t a, uint8_t r, uint8_t g, uint8_t b,
                                       const enum color_search_method search_method)
 {
@@ -348,7 +407,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     const uint8_t ghash = g & ((1<<NBITS)-1);
     const uint8_t bhash = b & ((1<<NBITS)-1);
     const unsigned hash = rhash<<(NBITS*2) | ghash<<NBITS | bhash;
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -367,12 +426,15 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     if (!e)
         return AVERROR(ENOMEM);
     e->color = color;
-    e->pal_entry = COLORMAP_NEAREST(search_method, s->palette, s->map, argb_elts, s->trans_thresh);
+    if (search_method == COLOR_SEARCH_BRUTEFORCE && a >= s->trans_thresh)
+        e->pal_entry = colormap_nearest_bruteforce_fast(s, color);
+    else
+        e->pal_entry = COLORMAP_NEAREST(search_method, s->palette, s->map, argb_elts, s->trans_thresh);
 
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb,
                                               const enum color_search_method search_method)
 {
@@ -381,7 +443,7 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
     uint32_t dstc;
-    const int dstx = color_get(s, c, a, r, g, b, search_method);
+    const int dstx = color_get(s, cache, c, a, r, g, b, search_method);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -391,24 +453,68 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
+static void wait_row(PaletteUseContext *s, int y, int progress)
+{
+#if HAVE_THREADS
+    if (!s->row_sync)
+        return;
+
+    pthread_mutex_lock(&s->row_mutex);
+    while (s->row_progress[y] < progress)
+        pthread_cond_wait(&s->row_cond, &s->row_mutex);
+    pthread_mutex_unlock(&s->row_mutex);
+#endif
+}
+
+static void report_row(PaletteUseContext *s, int y, int progress)
+{
+#if HAVE_THREADS
+    if (!s->row_sync)
+        return;
+
+    pthread_mutex_lock(&s->row_mutex);
+    s->row_progress[y] = progress;
+    pthread_cond_broadcast(&s->row_cond);
+    pthread_mutex_unlock(&s->row_mutex);
+#endif
+}
+
+/**
+ * Dither the lines [slice_start, slice_end) of the processing window.
+ *
+ * Error diffusion spreads the error at most two pixels left and right into
+ * the next line, so when the lines run in parallel, a line only dithers a
+ * pixel once the line above is 5 pixels ahead of it. The last pending
+ * contribution from above has then landed and the line above no longer
+ * writes where this one does.
+ */
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
+                                      int slice_start, int slice_end,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
 {
     int x, y;
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
+    uint32_t *src = ((uint32_t *)in ->data[0]) + slice_start*src_linesize;
+    uint8_t  *dst =              out->data[0]  + slice_start*dst_linesize;
 
     w += x_start;
     h += y_start;
 
-    for (y = y_start; y < h; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = x_start; x < w; x++) {
             int er, eg, eb;
 
+            if (dither > DITHERING_BAYER && !((x - x_start) % ROW_SYNC_STEP)) {
+                if (x > x_start)
+                    report_row(s, y, x);
+                if (y > y_start)
+                    wait_row(s, y - 1, FFMIN(x + ROW_SYNC_STEP + 4, w));
+            }
+
             if (dither == DITHERING_BAYER) {
                 const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
                 const uint8_t a8 = src[x] >> 24 & 0xff;
@@ -418,7 +524,8 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = av_clip_uint8(r8 + d);
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
-                const int color = color_get(s, src[x], a8, r, g, b, search_method);
+                const uint32_t dithered = (uint32_t)a8<<24 | r<<16 | g<<8 | b;
+                const int color = color_get(s, cache, dithered, a8, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -426,7 +533,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -438,7 +545,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -452,7 +559,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -471,7 +578,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -486,7 +593,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(s, src[x], a, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -750,6 +857,8 @@ static void load_colormap(PaletteUseContext *s)
 
     for (i = 0; i < AVPALETTE_COUNT; i++) {
         const uint32_t c = s->palette[i];
+        s->bf_rgb[i]  = c & 0xffffff;
+        s->bf_keys[i] = (c >> 24 < s->trans_thresh ? PALETTEUSE_KEY_SKIP : 0) | i;
         if (i != 0 && c == last_color) {
             color_used[i] = 1;
             continue;
@@ -894,6 +1003,61 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    int ret;
+
+    if (s->dither > DITHERING_BAYER) {
+        /* One line per job; the jobs sharing a cache never overlap since a
+         * line starts only once the one using the same cache is done. */
+        const int y = td->y + jobnr;
+        const int nb_rows = nb_jobs == 1 ? td->h : 1;
+
+        if (jobnr >= s->nb_caches)
+            wait_row(s, y - s->nb_caches, td->x + td->w);
+        ret = s->set_frame(s, s->cache[jobnr % s->nb_caches], td->out, td->in,
+                           td->x, td->y, td->w, td->h, y, y + nb_rows);
+        report_row(s, y, td->x + td->w);
+    } else {
+        const int slice_start = td->y + (td->h *  jobnr     ) / nb_jobs;
+        const int slice_end   = td->y + (td->h * (jobnr + 1)) / nb_jobs;
+
+        ret = s->set_frame(s, s->cache[jobnr], td->out, td->in,
+                           td->x, td->y, td->w, td->h, slice_start, slice_end);
+    }
+    return ret;
+}
+
+static int filter_frame_slices(AVFilterContext *ctx, AVFrame *out, AVFrame *in,
+                               int x, int y, int w, int h)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData td = { .in = in, .out = out, .x = x, .y = y, .w = w, .h = h };
+    int *rets, i, nb_jobs, ret = 0;
+
+    if (s->dither > DITHERING_BAYER) {
+        s->row_sync = s->nb_caches > 1;
+        nb_jobs = s->row_sync ? h : 1;
+        memset(s->row_progress, 0, in->height * sizeof(*s->row_progress));
+    } else {
+        nb_jobs = FFMIN(h, s->nb_caches);
+    }
+    if (nb_jobs <= 0)
+        return 0;
+
+    rets = av_malloc_array(nb_jobs, sizeof(*rets));
+    if (!rets)
+        return AVERROR(ENOMEM);
+    ctx->internal->execute(ctx, set_frame_slice, &td, rets, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if (rets[i] < 0)
+            ret = rets[i];
+    av_free(rets);
+    return ret;
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
     int x, y, w, h, ret;
@@ -923,7 +1087,7 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    ret = filter_frame_slices(ctx, out, in, x, y, w, h);
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -952,6 +1116,17 @@ static int config_output(AVFilterLink *outlink)
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
+    if (!s->cache) {
+        s->nb_caches = ff_filter_get_nb_threads(ctx);
+        s->cache = av_calloc(s->nb_caches, sizeof(*s->cache));
+        if (!s->cache)
+            return AVERROR(ENOMEM);
+    }
+    av_freep(&s->row_progress);
+    s->row_progress = av_calloc(outlink->h, sizeof(*s->row_progress));
+    if (!s->row_progress)
+        return AVERROR(ENOMEM);
+
     outlink->time_base = ctx->inputs[0]->time_base;
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
@@ -973,6 +1148,17 @@ static int config_input_palette(AVFilterLink *inlink)
     return 0;
 }
 
+static void free_caches(PaletteUseContext *s)
+{
+    int i, j;
+
+    for (j = 0; j < s->nb_caches; j++) {
+        for (i = 0; i < CACHE_SIZE; i++)
+            av_freep(&s->cache[j][i].entries);
+        memset(s->cache[j], 0, sizeof(s->cache[j]));
+    }
+}
+
 static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
 {
     int i, x, y;
@@ -984,9 +1170,7 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        free_caches(s);
     }
 
     i = 0;
@@ -1034,10 +1218,13 @@ static int load_apply_palette(FFFrameSync *fs)
 }
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            AVFrame *out, AVFrame *in,                          \
+                            int x_start, int y_start, int w, int h,             \
+                            int slice_start, int slice_end)                     \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(s, cache, out, in, x_start, y_start, w, h,                 \
+                     slice_start, slice_end, value, color_search);              \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1078,6 +1265,9 @@ static int dither_value(int p)
 static av_cold int init(AVFilterContext *ctx)
 {
     PaletteUseContext *s = ctx->priv;
+#if HAVE_THREADS
+    int ret;
+#endif
 
     s->last_in  = av_frame_alloc();
     s->last_out = av_frame_alloc();
@@ -1089,6 +1279,17 @@ static av_cold int init(AVFilterContext *ctx)
 
     s->set_frame = set_frame_lut[s->color_search_method][s->dither];
 
+    ff_paletteuse_init(&s->dsp);
+
+#if HAVE_THREADS
+    if ((ret = pthread_mutex_init(&s->row_mutex, NULL)))
+        return AVERROR(ret);
+    if ((ret = pthread_cond_init(&s->row_cond, NULL))) {
+        pthread_mutex_destroy(&s->row_mutex);
+        return AVERROR(ret);
+    }
+#endif
+
     if (s->dither == DITHERING_BAYER) {
         int i;
         const int delta = 1 << (5 - s->bayer_scale); // to avoid too much luma
@@ -1108,14 +1309,19 @@ static int activate(AVFilterContext *ctx)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    if (s->cache)
+        free_caches(s);
+    av_freep(&s->cache);
+    av_freep(&s->row_progress);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
+#if HAVE_THREADS
+    pthread_cond_destroy(&s->row_cond);
+    pthread_mutex_destroy(&s->row_mutex);
+#endif
 }
 
 static const AVFilterPad paletteuse_inputs[] = {
@@ -1150,4 +1356,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -0,0 +1,44 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSEDSP_H
+#define AVFILTER_PALETTEUSEDSP_H
+
+#include <stdint.h>
+
+/* Added to the key of palette entries the search must ignore. */
+#define PALETTEUSE_KEY_SKIP (1U << 30)
+
+typedef struct PaletteUseDSPContext {
+    /**
+     * Brute-force nearest color search over a 256 entry palette.
+     *
+     * @param rgb   palette colors as 0x00RRGGBB
+     * @param keys  palette index of each entry, optionally with
+     *              PALETTEUSE_KEY_SKIP set
+     * @param color target color as 0x00RRGGBB
+     * @return the smallest (squared distance << 8 | keys[i]), so that the
+     *         nearest entry with the lowest index is in the low 8 bits
+     */
+    unsigned (*nearest_key)(const uint32_t *rgb, const uint32_t *keys, uint32_t color);
+} PaletteUseDSPContext;
+
+void ff_paletteuse_init(PaletteUseDSPContext *dsp);
+void ff_paletteuse_init_x86(PaletteUseDSPContext *dsp);
+
+#endif /* AVFILTER_PALETTEUSEDSP_H */
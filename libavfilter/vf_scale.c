@@ -91,6 +91,9 @@ typedef struct ScaleContext {
 
     int eval_mode;              ///< expression evaluation mode
 
+    const AVBuffer *last_buffer; ///< buf[0] of the last input, only compared
+    AVFrame *last_in;           ///< last input frame, held once it came twice in a row
+    AVFrame *last_out;          ///< scaled last_in, sent again for the same picture
 } ScaleContext;
 
 AVFilter ff_vf_scale2ref;
@@ -152,6 +155,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     sws_freeContext(scale->isws[0]);
     sws_freeContext(scale->isws[1]);
     scale->sws = NULL;
+    av_frame_free(&scale->last_in);
+    av_frame_free(&scale->last_out);
     av_dict_free(&scale->opts);
 }
 
@@ -230,6 +235,10 @@ static int config_props(AVFilterLink *outlink)
     int w, h;
     int ret;
 
+    av_frame_free(&scale->last_in);
+    av_frame_free(&scale->last_out);
+    scale->last_buffer = NULL;
+
     if ((ret = ff_scale_eval_dimensions(ctx,
                                         scale->w_expr, scale->h_expr,
                                         inlink, outlink,
@@ -400,6 +409,53 @@ static int scale_slice(AVFilterLink *link, AVFrame *out_buf, AVFrame *cur_pic, s
                          out,out_stride);
 }
 
+static int is_last_input(ScaleContext *scale, const AVFrame *in)
+{
+    const AVFrame *last = scale->last_in;
+
+    return last && in->buf[0] && last->buf[0]->buffer == in->buf[0]->buffer &&
+           !memcmp(last->data,     in->data,     sizeof(in->data))     &&
+           !memcmp(last->linesize, in->linesize, sizeof(in->linesize)) &&
+           last->width            == in->width           &&
+           last->height           == in->height          &&
+           last->format           == in->format          &&
+           last->color_range      == in->color_range     &&
+           last->colorspace       == in->colorspace      &&
+           last->interlaced_frame == in->interlaced_frame;
+}
+
+/**
+ * Make a new output frame with the properties of in and the picture
+ * already scaled for the same input picture.
+ */
+static AVFrame *ref_last_output(ScaleContext *scale, const AVFrame *in)
+{
+    const AVFrame *last = scale->last_out;
+    AVFrame *out = av_frame_alloc();
+    int i;
+
+    if (!out || av_frame_copy_props(out, in) < 0)
+        goto fail;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(last->buf) && last->buf[i]; i++) {
+        out->buf[i] = av_buffer_ref(last->buf[i]);
+        if (!out->buf[i])
+            goto fail;
+    }
+    memcpy(out->data,     last->data,     sizeof(out->data));
+    memcpy(out->linesize, last->linesize, sizeof(out->linesize));
+    out->width               = last->width;
+    out->height              = last->height;
+    out->format              = last->format;
+    out->color_range         = last->color_range;
+    out->sample_aspect_ratio = last->sample_aspect_ratio;
+    return out;
+
+fail:
+    av_frame_free(&out);
+    return NULL;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     ScaleContext *scale = link->dst->priv;
@@ -407,7 +463,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     AVFrame *out;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     char buf[32];
-    int in_range;
+    int in_range, repeated;
 
     if (in->colorspace == AVCOL_SPC_YCGCO)
         av_log(link->dst, AV_LOG_WARNING, "Detected unsupported YCgCo colorspace.\n");
@@ -440,6 +496,16 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     if (!scale->sws)
         return ff_filter_frame(outlink, in);
 
+    /* A still picture sent repeatedly, like a subtitle canvas, is only
+     * scaled once. Holding a reference guarantees it has not changed. */
+    if (is_last_input(scale, in)) {
+        out = ref_last_output(scale, in);
+        av_frame_free(&in);
+        if (!out)
+            return AVERROR(ENOMEM);
+        return ff_filter_frame(outlink, out);
+    }
+
     scale->hsub = desc->log2_chroma_w;
     scale->vsub = desc->log2_chroma_h;
 
@@ -520,7 +586,23 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         scale_slice(link, out, in, scale->sws, 0, link->h, 1, 0);
     }
 
-    av_frame_free(&in);
+    av_frame_free(&scale->last_in);
+    av_frame_free(&scale->last_out);
+    /* Holding the frames makes the output read-only for the next filters,
+     * so only do it for a picture that was already sent just before. That
+     * first repeat is still scaled: without a reference, the buffer may
+     * have been freed and reused for another picture in between. */
+    repeated = in->buf[0] && in->buf[0]->buffer == scale->last_buffer;
+    scale->last_buffer = in->buf[0] ? in->buf[0]->buffer : NULL;
+    if (repeated && !av_frame_is_writable(in)) {
+        scale->last_out = av_frame_clone(out);
+        if (scale->last_out)
+            scale->last_in = in;
+        else
+            av_frame_free(&in);
+    } else {
+        av_frame_free(&in);
+    }
     return ff_filter_frame(outlink, out);
 }
 
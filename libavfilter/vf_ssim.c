@@ -59,13 +59,15 @@ typedef struct SSIMContext {
     uint8_t rgba_map[4];
     int planewidth[4];
     int planeheight[4];
-    int *temp;
+    int **temp;
+    int nb_threads;
+    float *score[4];
     int is_rgb;
-    float (*ssim_plane)(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max);
+    void (*ssim_plane)(SSIMDSPContext *dsp,
+                       uint8_t *main, int main_stride,
+                       uint8_t *ref, int ref_stride,
+                       int width, int height, void *temp,
+                       int max, float *score, int jobnr, int nb_jobs);
     SSIMDSPContext dsp;
 } SSIMContext;
 
@@ -221,21 +223,26 @@ static float ssim_endn_8bit(const int (*sum0)[4], const int (*sum1)[4], int widt
 
 #define SUM_LEN(w) (((w) >> 2) + 3)
 
-static float ssim_plane_16bit(SSIMDSPContext *dsp,
-                              uint8_t *main, int main_stride,
-                              uint8_t *ref, int ref_stride,
-                              int width, int height, void *temp,
-                              int max)
+/* The ssim_plane functions store the score of each row of 4x4 blocks of
+ * the slice in score[], the rows are summed up in order afterwards so the
+ * result does not depend on the number of slices. */
+static void ssim_plane_16bit(SSIMDSPContext *dsp,
+                             uint8_t *main, int main_stride,
+                             uint8_t *ref, int ref_stride,
+                             int width, int height, void *temp,
+                             int max, float *score, int jobnr, int nb_jobs)
 {
-    int z = 0, y;
-    float ssim = 0.0;
+    int z, y, slice_start, slice_end;
     int64_t (*sum0)[4] = temp;
     int64_t (*sum1)[4] = sum0 + SUM_LEN(width);
 
     width >>= 2;
     height >>= 2;
+    slice_start = 1 + ((height - 1) * jobnr) / nb_jobs;
+    slice_end   = 1 + ((height - 1) * (jobnr+1)) / nb_jobs;
 
-    for (y = 1; y < height; y++) {
+    z = slice_start - 1;
+    for (y = slice_start; y < slice_end; y++) {
         for (; z <= y; z++) {
             FFSWAP(void*, sum0, sum1);
             ssim_4x4xn_16bit(&main[4 * z * main_stride], main_stride,
@@ -243,27 +250,27 @@ static float ssim_plane_16bit(SSIMDSPContext *dsp,
                              sum0, width);
         }
 
-        ssim += ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
+        score[y] = ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
     }
-
-    return ssim / ((height - 1) * (width - 1));
 }
 
-static float ssim_plane(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max)
+static void ssim_plane(SSIMDSPContext *dsp,
+                       uint8_t *main, int main_stride,
+                       uint8_t *ref, int ref_stride,
+                       int width, int height, void *temp,
+                       int max, float *score, int jobnr, int nb_jobs)
 {
-    int z = 0, y;
-    float ssim = 0.0;
+    int z, y, slice_start, slice_end;
     int (*sum0)[4] = temp;
     int (*sum1)[4] = sum0 + SUM_LEN(width);
 
     width >>= 2;
     height >>= 2;
+    slice_start = 1 + ((height - 1) * jobnr) / nb_jobs;
+    slice_end   = 1 + ((height - 1) * (jobnr+1)) / nb_jobs;
 
-    for (y = 1; y < height; y++) {
+    z = slice_start - 1;
+    for (y = slice_start; y < slice_end; y++) {
         for (; z <= y; z++) {
             FFSWAP(void*, sum0, sum1);
             dsp->ssim_4x4_line(&main[4 * z * main_stride], main_stride,
@@ -271,10 +278,27 @@ static float ssim_plane(SSIMDSPContext *dsp,
                                sum0, width);
         }
 
-        ssim += dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
+        score[y] = dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
     }
+}
+
+typedef struct ThreadData {
+    AVFrame *main, *ref;
+} ThreadData;
+
+static int ssim_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SSIMContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int i;
+
+    for (i = 0; i < s->nb_components; i++)
+        s->ssim_plane(&s->dsp, td->main->data[i], td->main->linesize[i],
+                      td->ref->data[i], td->ref->linesize[i],
+                      s->planewidth[i], s->planeheight[i], s->temp[jobnr],
+                      s->max, s->score[i], jobnr, nb_jobs);
 
-    return ssim / ((height - 1) * (width - 1));
+    return 0;
 }
 
 static double ssim_db(double ssim, double weight)
@@ -289,7 +313,8 @@ static int do_ssim(FFFrameSync *fs)
     AVFrame *master, *ref;
     AVDictionary **metadata;
     float c[4], ssimv = 0.0;
-    int ret, i;
+    int ret, i, y;
+    ThreadData td;
 
     ret = ff_framesync_dualinput_get(fs, &master, &ref);
     if (ret < 0)
@@ -300,11 +325,19 @@ static int do_ssim(FFFrameSync *fs)
 
     s->nb_frames++;
 
+    td.main = master;
+    td.ref = ref;
+    ctx->internal->execute(ctx, ssim_slice, &td, NULL,
+                           FFMIN(FFMAX(s->planeheight[0] >> 2, 1), ff_filter_get_nb_threads(ctx)));
+
     for (i = 0; i < s->nb_components; i++) {
-        c[i] = s->ssim_plane(&s->dsp, master->data[i], master->linesize[i],
-                             ref->data[i], ref->linesize[i],
-                             s->planewidth[i], s->planeheight[i], s->temp,
-                             s->max);
+        const int width  = s->planewidth[i]  >> 2;
+        const int height = s->planeheight[i] >> 2;
+        float ssim = 0.0;
+
+        for (y = 1; y < height; y++)
+            ssim += s->score[i][y];
+        c[i] = ssim / ((height - 1) * (width - 1));
         ssimv += s->coefs[i] * c[i];
         s->ssim[i] += c[i];
     }
@@ -410,9 +443,20 @@ static int config_input_ref(AVFilterLink *inlink)
     for (i = 0; i < s->nb_components; i++)
         s->coefs[i] = (double) s->planeheight[i] * s->planewidth[i] / sum;
 
-    s->temp = av_mallocz_array(2 * SUM_LEN(inlink->w), (desc->comp[0].depth > 8) ? sizeof(int64_t[4]) : sizeof(int[4]));
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->temp = av_mallocz_array(s->nb_threads, sizeof(*s->temp));
     if (!s->temp)
         return AVERROR(ENOMEM);
+    for (i = 0; i < s->nb_threads; i++) {
+        s->temp[i] = av_mallocz_array(2 * SUM_LEN(inlink->w), (desc->comp[0].depth > 8) ? sizeof(int64_t[4]) : sizeof(int[4]));
+        if (!s->temp[i])
+            return AVERROR(ENOMEM);
+    }
+    for (i = 0; i < s->nb_components; i++) {
+        s->score[i] = av_mallocz_array(s->planeheight[i] >> 2, sizeof(*s->score[i]));
+        if (!s->score[i])
+            return AVERROR(ENOMEM);
+    }
     s->max = (1 << desc->comp[0].depth) - 1;
 
     s->ssim_plane = desc->comp[0].depth > 8 ? ssim_plane_16bit : ssim_plane;
@@ -455,10 +499,10 @@ static int activate(AVFilterContext *ctx)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     SSIMContext *s = ctx->priv;
+    int i;
 
     if (s->nb_frames > 0) {
         char buf[256];
-        int i;
         buf[0] = 0;
         for (i = 0; i < s->nb_components; i++) {
             int c = s->is_rgb ? s->rgba_map[i] : i;
@@ -474,6 +518,12 @@ static av_cold void uninit(AVFilterContext *ctx)
     if (s->stats_file && s->stats_file != stdout)
         fclose(s->stats_file);
 
+    if (s->temp) {
+        for (i = 0; i < s->nb_threads; i++)
+            av_freep(&s->temp[i]);
+    }
+    for (i = 0; i < s->nb_components; i++)
+        av_freep(&s->score[i]);
     av_freep(&s->temp);
 }
 
@@ -510,4 +560,5 @@ AVFilter ff_vf_ssim = {
     .priv_class    = &ssim_class,
     .inputs        = ssim_inputs,
     .outputs       = ssim_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
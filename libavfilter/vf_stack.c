@@ -29,10 +29,18 @@
 #include "framesync.h"
 #include "video.h"
 
+/* maximum number of output frames whose tiles are handed out in advance */
+#define MAX_CANVASES 4
+
+/* alignment of the frames returned by ff_get_video_buffer(), that the
+ * tiles must keep for the SIMD code of the filters writing them */
+#define TILE_ALIGN 32
+
 typedef struct StackItem {
     int x[4], y[4];
     int linesize[4];
     int height[4];
+    int tiled;                  ///< frames of this input are allocated in the output
 } StackItem;
 
 typedef struct StackContext {
@@ -44,10 +52,16 @@ typedef struct StackContext {
     int is_vertical;
     int is_horizontal;
     int nb_planes;
+    int direct;
 
     StackItem *items;
     AVFrame **frames;
     FFFrameSync fs;
+
+    AVFrame *canvases[MAX_CANVASES]; ///< output frames the inputs are allocated in
+    int nb_canvases;
+    int64_t canvas_base;        ///< sequence number of canvases[0]
+    int64_t *next_canvas;       ///< sequence number of the next canvas of each input
 } StackContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -67,6 +81,89 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, pix_fmts);
 }
 
+static void flush_canvases(StackContext *s)
+{
+    int i;
+
+    for (i = 0; i < s->nb_canvases; i++)
+        av_frame_free(&s->canvases[i]);
+    s->nb_canvases = 0;
+}
+
+/**
+ * Allocate the frames of an input in its area of the output frames.
+ *
+ * The n-th frame of every input is allocated in the same output frame, so
+ * that if the inputs are in step, the output does not need any copy.
+ */
+static AVFrame *get_tile_buffer(AVFilterLink *inlink, int w, int h)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
+    StackContext *s = ctx->priv;
+    const int i = FF_INLINK_IDX(inlink);
+    const StackItem *item = &s->items[i];
+    AVFrame *canvas, *tile;
+    int64_t min_seq;
+    int n, p;
+
+    n = s->next_canvas[i] - s->canvas_base;
+    if (!item->tiled || w != inlink->w || h != inlink->h || n >= MAX_CANVASES)
+        return ff_default_get_video_buffer(inlink, w, h);
+
+    if (n == s->nb_canvases) {
+        canvas = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!canvas)
+            return NULL;
+        s->canvases[s->nb_canvases++] = canvas;
+    }
+    canvas = s->canvases[n];
+
+    /* the canvas itself may come from a filter handing out tiles as well */
+    for (p = 0; p < s->nb_planes; p++)
+        if ((canvas->linesize[p] | (intptr_t)canvas->data[p]) & (TILE_ALIGN - 1))
+            break;
+
+    if (p < s->nb_planes) {
+        tile = ff_default_get_video_buffer(inlink, w, h);
+        if (!tile)
+            return NULL;
+    } else {
+        tile = av_frame_alloc();
+        if (!tile)
+            return NULL;
+        for (p = 0; p < FF_ARRAY_ELEMS(canvas->buf) && canvas->buf[p]; p++) {
+            tile->buf[p] = av_buffer_ref(canvas->buf[p]);
+            if (!tile->buf[p]) {
+                av_frame_free(&tile);
+                return NULL;
+            }
+        }
+        for (p = 0; p < s->nb_planes; p++) {
+            tile->data[p]     = canvas->data[p] + item->y[p] * canvas->linesize[p] + item->x[p];
+            tile->linesize[p] = canvas->linesize[p];
+        }
+        tile->width  = w;
+        tile->height = h;
+        tile->format = inlink->format;
+        tile->sample_aspect_ratio = inlink->sample_aspect_ratio;
+    }
+
+    /* the canvases all the tiled inputs are past of are only kept alive by their tiles */
+    s->next_canvas[i]++;
+    min_seq = INT64_MAX;
+    for (n = 0; n < s->nb_inputs; n++)
+        if (s->items[n].tiled)
+            min_seq = FFMIN(min_seq, s->next_canvas[n]);
+    while (s->nb_canvases && s->canvas_base < min_seq) {
+        av_frame_free(&s->canvases[0]);
+        memmove(s->canvases, s->canvases + 1, --s->nb_canvases * sizeof(*s->canvases));
+        s->canvas_base++;
+    }
+
+    return tile;
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     StackContext *s = ctx->priv;
@@ -82,6 +179,16 @@ static av_cold int init(AVFilterContext *ctx)
     if (!s->frames)
         return AVERROR(ENOMEM);
 
+    s->items = av_calloc(s->nb_inputs, sizeof(*s->items));
+    if (!s->items)
+        return AVERROR(ENOMEM);
+
+    if (s->direct) {
+        s->next_canvas = av_calloc(s->nb_inputs, sizeof(*s->next_canvas));
+        if (!s->next_canvas)
+            return AVERROR(ENOMEM);
+    }
+
     if (!strcmp(ctx->filter->name, "xstack")) {
         if (!s->layout) {
             if (s->nb_inputs == 2) {
@@ -93,16 +200,14 @@ static av_cold int init(AVFilterContext *ctx)
                 return AVERROR(EINVAL);
             }
         }
-
-        s->items = av_calloc(s->nb_inputs, sizeof(*s->items));
-        if (!s->items)
-            return AVERROR(ENOMEM);
     }
 
     for (i = 0; i < s->nb_inputs; i++) {
         AVFilterPad pad = { 0 };
 
         pad.type = AVMEDIA_TYPE_VIDEO;
+        if (s->direct)
+            pad.get_video_buffer = get_tile_buffer;
         pad.name = av_asprintf("input%d", i);
         if (!pad.name)
             return AVERROR(ENOMEM);
@@ -116,67 +221,114 @@ static av_cold int init(AVFilterContext *ctx)
     return 0;
 }
 
+static int copy_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    StackContext *s = ctx->priv;
+    AVFrame *out = arg;
+    AVFrame **in = s->frames;
+    int i, p;
+
+    for (i = 0; i < s->nb_inputs; i++) {
+        const StackItem *item = &s->items[i];
+
+        for (p = 0; p < s->nb_planes; p++) {
+            const int start = (item->height[p] *  jobnr     ) / nb_jobs;
+            const int end   = (item->height[p] * (jobnr + 1)) / nb_jobs;
+
+            av_image_copy_plane(out->data[p] + out->linesize[p] * (item->y[p] + start) + item->x[p],
+                                out->linesize[p],
+                                in[i]->data[p] + in[i]->linesize[p] * start,
+                                in[i]->linesize[p],
+                                item->linesize[p], end - start);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Return a frame referencing the output picture if the input frames are
+ * already laid out in it, like the tiles of a same canvas.
+ */
+static AVFrame *get_direct_output(AVFilterContext *ctx)
+{
+    AVFilterLink *outlink = ctx->outputs[0];
+    StackContext *s = ctx->priv;
+    AVFrame **in = s->frames;
+    uint8_t *data[4];
+    AVFrame *out;
+    int i, p;
+
+    for (p = 0; p < s->nb_planes; p++) {
+        const int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(outlink->h, s->desc->log2_chroma_h)
+                                       : outlink->h;
+        const int width = av_image_get_linesize(outlink->format, outlink->w, p);
+        const int linesize = in[0]->linesize[p];
+        AVBufferRef *buf = av_frame_get_plane_buffer(in[0], p);
+
+        if (!buf || linesize < width)
+            return NULL;
+
+        data[p] = in[0]->data[p] - s->items[0].y[p] * linesize - s->items[0].x[p];
+        if (data[p] < buf->data ||
+            data[p] + (h - 1) * linesize + width > buf->data + buf->size)
+            return NULL;
+
+        for (i = 1; i < s->nb_inputs; i++) {
+            if (in[i]->linesize[p] != linesize ||
+                in[i]->data[p] != data[p] + s->items[i].y[p] * linesize + s->items[i].x[p])
+                return NULL;
+        }
+    }
+
+    out = av_frame_alloc();
+    if (!out)
+        return NULL;
+    for (i = 0; i < FF_ARRAY_ELEMS(in[0]->buf) && in[0]->buf[i]; i++) {
+        out->buf[i] = av_buffer_ref(in[0]->buf[i]);
+        if (!out->buf[i]) {
+            av_frame_free(&out);
+            return NULL;
+        }
+    }
+    for (p = 0; p < s->nb_planes; p++) {
+        out->data[p]     = data[p];
+        out->linesize[p] = in[0]->linesize[p];
+    }
+    out->width  = outlink->w;
+    out->height = outlink->h;
+    out->format = outlink->format;
+
+    return out;
+}
+
 static int process_frame(FFFrameSync *fs)
 {
     AVFilterContext *ctx = fs->parent;
     AVFilterLink *outlink = ctx->outputs[0];
     StackContext *s = fs->opaque;
     AVFrame **in = s->frames;
-    AVFrame *out;
-    int i, p, ret, offset[4] = { 0 };
+    AVFrame *out = NULL;
+    int i, ret;
 
     for (i = 0; i < s->nb_inputs; i++) {
         if ((ret = ff_framesync_get_frame(&s->fs, i, &in[i], 0)) < 0)
             return ret;
     }
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
-    if (!out)
-        return AVERROR(ENOMEM);
-    out->pts = av_rescale_q(s->fs.pts, s->fs.time_base, outlink->time_base);
-    out->sample_aspect_ratio = outlink->sample_aspect_ratio;
-
-    for (i = 0; i < s->nb_inputs; i++) {
-        AVFilterLink *inlink = ctx->inputs[i];
-        int linesize[4];
-        int height[4];
-
-        if (s->is_horizontal || s->is_vertical) {
-            if ((ret = av_image_fill_linesizes(linesize, inlink->format, inlink->w)) < 0) {
-                av_frame_free(&out);
-                return ret;
-            }
+    if (s->direct)
+        out = get_direct_output(ctx);
 
-            height[1] = height[2] = AV_CEIL_RSHIFT(inlink->h, s->desc->log2_chroma_h);
-            height[0] = height[3] = inlink->h;
-        }
-
-        for (p = 0; p < s->nb_planes; p++) {
-            if (s->is_vertical) {
-                av_image_copy_plane(out->data[p] + offset[p] * out->linesize[p],
-                                    out->linesize[p],
-                                    in[i]->data[p],
-                                    in[i]->linesize[p],
-                                    linesize[p], height[p]);
-                offset[p] += height[p];
-            } else if (s->is_horizontal) {
-                av_image_copy_plane(out->data[p] + offset[p],
-                                    out->linesize[p],
-                                    in[i]->data[p],
-                                    in[i]->linesize[p],
-                                    linesize[p], height[p]);
-                offset[p] += linesize[p];
-            } else {
-                StackItem *item = &s->items[i];
+    if (!out) {
+        out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!out)
+            return AVERROR(ENOMEM);
 
-                av_image_copy_plane(out->data[p] + out->linesize[p] * item->y[p] + item->x[p],
-                                    out->linesize[p],
-                                    in[i]->data[p],
-                                    in[i]->linesize[p],
-                                    item->linesize[p], item->height[p]);
-            }
-        }
+        ctx->internal->execute(ctx, copy_slice, out, NULL,
+                               FFMIN(outlink->h, ff_filter_get_nb_threads(ctx)));
     }
+    out->pts = av_rescale_q(s->fs.pts, s->fs.time_base, outlink->time_base);
+    out->sample_aspect_ratio = outlink->sample_aspect_ratio;
 
     return ff_filter_frame(outlink, out);
 }
@@ -190,12 +342,37 @@ static int config_output(AVFilterLink *outlink)
     int height = ctx->inputs[0]->h;
     int width = ctx->inputs[0]->w;
     FFFrameSyncIn *in;
-    int i, ret;
+    int i, j, ret;
 
     s->desc = av_pix_fmt_desc_get(outlink->format);
     if (!s->desc)
         return AVERROR_BUG;
 
+    if (s->is_vertical || s->is_horizontal) {
+        int offset[4] = { 0 };
+
+        for (i = 0; i < s->nb_inputs; i++) {
+            AVFilterLink *inlink = ctx->inputs[i];
+            StackItem *item = &s->items[i];
+
+            if ((ret = av_image_fill_linesizes(item->linesize, inlink->format, inlink->w)) < 0)
+                return ret;
+
+            item->height[1] = item->height[2] = AV_CEIL_RSHIFT(inlink->h, s->desc->log2_chroma_h);
+            item->height[0] = item->height[3] = inlink->h;
+
+            for (j = 0; j < 4; j++) {
+                if (s->is_vertical) {
+                    item->y[j] = offset[j];
+                    offset[j] += item->height[j];
+                } else {
+                    item->x[j] = offset[j];
+                    offset[j] += item->linesize[j];
+                }
+            }
+        }
+    }
+
     if (s->is_vertical) {
         for (i = 1; i < s->nb_inputs; i++) {
             if (ctx->inputs[i]->w != width) {
@@ -289,6 +466,22 @@ static int config_output(AVFilterLink *outlink)
 
     s->nb_planes = av_pix_fmt_count_planes(outlink->format);
 
+    /* only hand out tiles starting on aligned addresses */
+    for (i = 0; i < s->nb_inputs; i++) {
+        StackItem *item = &s->items[i];
+        int p;
+
+        item->tiled = s->direct;
+        for (p = 0; p < s->nb_planes; p++)
+            if (item->x[p] & (TILE_ALIGN - 1))
+                item->tiled = 0;
+    }
+
+    flush_canvases(s);
+    if (s->next_canvas)
+        memset(s->next_canvas, 0, s->nb_inputs * sizeof(*s->next_canvas));
+    s->canvas_base = 0;
+
     outlink->w          = width;
     outlink->h          = height;
     outlink->frame_rate = frame_rate;
@@ -322,8 +515,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     int i;
 
     ff_framesync_uninit(&s->fs);
+    flush_canvases(s);
     av_freep(&s->frames);
     av_freep(&s->items);
+    av_freep(&s->next_canvas);
 
     for (i = 0; i < ctx->nb_inputs; i++)
         av_freep(&ctx->input_pads[i].name);
@@ -340,6 +535,7 @@ static int activate(AVFilterContext *ctx)
 static const AVOption stack_options[] = {
     { "inputs", "set number of inputs", OFFSET(nb_inputs), AV_OPT_TYPE_INT, {.i64=2}, 2, INT_MAX, .flags = FLAGS },
     { "shortest", "force termination when the shortest input terminates", OFFSET(shortest), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, .flags = FLAGS },
+    { "direct", "allocate the input frames in the output frames", OFFSET(direct), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, .flags = FLAGS },
     { NULL },
 };
 
@@ -367,7 +563,7 @@ AVFilter ff_vf_hstack = {
     .init          = init,
     .uninit        = uninit,
     .activate      = activate,
-    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
 
 #endif /* CONFIG_HSTACK_FILTER */
@@ -387,7 +583,7 @@ AVFilter ff_vf_vstack = {
     .init          = init,
     .uninit        = uninit,
     .activate      = activate,
-    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
 
 #endif /* CONFIG_VSTACK_FILTER */
@@ -398,6 +594,7 @@ static const AVOption xstack_options[] = {
     { "inputs", "set number of inputs", OFFSET(nb_inputs), AV_OPT_TYPE_INT, {.i64=2}, 2, INT_MAX, .flags = FLAGS },
     { "layout", "set custom layout", OFFSET(layout), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, .flags = FLAGS },
     { "shortest", "force termination when the shortest input terminates", OFFSET(shortest), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, .flags = FLAGS },
+    { "direct", "allocate the input frames in the output frames", OFFSET(direct), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, .flags = FLAGS },
     { NULL },
 };
 
@@ -413,7 +610,7 @@ AVFilter ff_vf_xstack = {
     .init          = init,
     .uninit        = uninit,
     .activate      = activate,
-    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
 
 #endif /* CONFIG_XSTACK_FILTER */
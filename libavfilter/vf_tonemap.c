@@ -37,19 +37,9 @@
 #include "colorspace.h"
 #include "formats.h"
 #include "internal.h"
+#include "tonemap.h"
 #include "video.h"
 
-enum TonemapAlgorithm {
-    TONEMAP_NONE,
-    TONEMAP_LINEAR,
-    TONEMAP_GAMMA,
-    TONEMAP_CLIP,
-    TONEMAP_REINHARD,
-    TONEMAP_HABLE,
-    TONEMAP_MOBIUS,
-    TONEMAP_MAX,
-};
-
 static const struct LumaCoefficients luma_coefficients[AVCOL_SPC_NB] = {
     [AVCOL_SPC_FCC]        = { 0.30,   0.59,   0.11   },
     [AVCOL_SPC_BT470BG]    = { 0.299,  0.587,  0.114  },
@@ -69,6 +59,8 @@ typedef struct TonemapContext {
     double peak;
 
     const struct LumaCoefficients *coeffs;
+    float consts[TONEMAP_NB_CONSTS];
+    TonemapDSPContext dsp;
 } TonemapContext;
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -104,6 +96,8 @@ static av_cold int init(AVFilterContext *ctx)
     if (isnan(s->param))
         s->param = 1.0f;
 
+    ff_tonemap_init_dsp(&s->dsp, s->tonemap);
+
     return 0;
 }
 
@@ -113,88 +107,153 @@ static float hable(float in)
     return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
 }
 
-static float mobius(float in, float j, double peak)
-{
-    float a, b;
-
-    if (in <= j)
-        return in;
-
-    a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
-    b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
-
-    return (b * b + 2.0f * b * j + j * j) / (b - a) * (in + a) / (in + b);
-}
-
-#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
-static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
-                    const AVPixFmtDescriptor *desc, int x, int y, double peak)
+av_cold void ff_tonemap_init_consts(float *c, enum TonemapAlgorithm algo,
+                                    const double *luma, double desat,
+                                    double param, double peak)
 {
-    const float *r_in = (const float *)(in->data[0] + x * desc->comp[0].step + y * in->linesize[0]);
-    const float *b_in = (const float *)(in->data[1] + x * desc->comp[1].step + y * in->linesize[1]);
-    const float *g_in = (const float *)(in->data[2] + x * desc->comp[2].step + y * in->linesize[2]);
-    float *r_out = (float *)(out->data[0] + x * desc->comp[0].step + y * out->linesize[0]);
-    float *b_out = (float *)(out->data[1] + x * desc->comp[1].step + y * out->linesize[1]);
-    float *g_out = (float *)(out->data[2] + x * desc->comp[2].step + y * out->linesize[2]);
-    float sig, sig_orig;
-
-    /* load values */
-    *r_out = *r_in;
-    *b_out = *b_in;
-    *g_out = *g_in;
-
-    /* desaturate to prevent unnatural colors */
-    if (s->desat > 0) {
-        float luma = s->coeffs->cr * *r_in + s->coeffs->cg * *g_in + s->coeffs->cb * *b_in;
-        float overbright = FFMAX(luma - s->desat, 1e-6) / FFMAX(luma, 1e-6);
-        *r_out = MIX(*r_in, luma, overbright);
-        *g_out = MIX(*g_in, luma, overbright);
-        *b_out = MIX(*b_in, luma, overbright);
+    float j, a, b;
+
+    memset(c, 0, TONEMAP_NB_CONSTS * sizeof(*c));
+    if (luma && desat > 0) {
+        c[0] = luma[0];
+        c[1] = luma[1];
+        c[2] = luma[2];
+        c[3] = desat;
     }
 
-    /* pick the brightest component, reducing the value range as necessary
-     * to keep the entire signal in range and preventing discoloration due to
-     * out-of-bounds clipping */
-    sig = FFMAX(FFMAX3(*r_out, *g_out, *b_out), 1e-6);
-    sig_orig = sig;
-
-    switch(s->tonemap) {
-    default:
-    case TONEMAP_NONE:
-        // do nothing
-        break;
+    switch (algo) {
     case TONEMAP_LINEAR:
-        sig = sig * s->param / peak;
+        c[4] = param / peak;
         break;
     case TONEMAP_GAMMA:
-        sig = sig > 0.05f ? pow(sig / peak, 1.0f / s->param)
-                          : sig * pow(0.05f / peak, 1.0f / s->param) / 0.05f;
+        c[4] = peak;
+        c[5] = 1.0f / param;
+        c[6] = pow(0.05f / peak, 1.0f / param) / 0.05f;
         break;
     case TONEMAP_CLIP:
-        sig = av_clipf(sig * s->param, 0, 1.0f);
-        break;
-    case TONEMAP_HABLE:
-        sig = hable(sig) / hable(peak);
+        c[4] = param;
         break;
     case TONEMAP_REINHARD:
-        sig = sig / (sig + s->param) * (peak + s->param) / peak;
+        c[4] = param;
+        c[5] = (peak + param) / peak;
+        break;
+    case TONEMAP_HABLE:
+        /* the terms of hable(), for the SIMD versions */
+        c[4]  = hable(peak);
+        c[5]  = 0.15f;
+        c[6]  = 0.50f * 0.10f;
+        c[7]  = 0.20f * 0.02f;
+        c[8]  = 0.50f;
+        c[9]  = 0.20f * 0.30f;
+        c[10] = 0.02f / 0.30f;
         break;
     case TONEMAP_MOBIUS:
-        sig = mobius(sig, s->param, peak);
+        j = param;
+        a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+        b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
+        c[4] = j;
+        c[5] = a;
+        c[6] = b;
+        c[7] = (b * b + 2.0f * b * j + j * j) / (b - a);
         break;
     }
+}
+
+#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
+static av_always_inline void tonemap(float *const dst[3], const float *const src[3],
+                                     int width, const float *c,
+                                     enum TonemapAlgorithm algo)
+{
+    for (int x = 0; x < width; x++) {
+        float p0 = src[0][x];
+        float p1 = src[1][x];
+        float p2 = src[2][x];
+        float sig, sig_orig;
+
+        /* desaturate to prevent unnatural colors */
+        if (c[3] > 0) {
+            float luma = c[0] * p0 + c[1] * p1 + c[2] * p2;
+            float overbright = FFMAX(luma - c[3], 1e-6f) / FFMAX(luma, 1e-6f);
+            p0 = MIX(p0, luma, overbright);
+            p1 = MIX(p1, luma, overbright);
+            p2 = MIX(p2, luma, overbright);
+        }
+
+        /* pick the brightest component, reducing the value range as necessary
+         * to keep the entire signal in range and preventing discoloration due to
+         * out-of-bounds clipping */
+        sig = FFMAX(FFMAX3(p0, p1, p2), 1e-6f);
+        sig_orig = sig;
+
+        switch(algo) {
+        default:
+        case TONEMAP_NONE:
+            // do nothing
+            break;
+        case TONEMAP_LINEAR:
+            sig = sig * c[4];
+            break;
+        case TONEMAP_GAMMA:
+            sig = sig > 0.05f ? powf(sig / c[4], c[5]) : sig * c[6];
+            break;
+        case TONEMAP_CLIP:
+            sig = av_clipf(sig * c[4], 0, 1.0f);
+            break;
+        case TONEMAP_HABLE:
+            sig = hable(sig) / c[4];
+            break;
+        case TONEMAP_REINHARD:
+            sig = sig / (sig + c[4]) * c[5];
+            break;
+        case TONEMAP_MOBIUS:
+            if (sig > c[4])
+                sig = c[7] * (sig + c[5]) / (sig + c[6]);
+            break;
+        }
+
+        /* apply the computed scale factor to the color,
+         * linearly to prevent discoloration */
+        sig = sig / sig_orig;
+        dst[0][x] = p0 * sig;
+        dst[1][x] = p1 * sig;
+        dst[2][x] = p2 * sig;
+    }
+}
 
-    /* apply the computed scale factor to the color,
-     * linearly to prevent discoloration */
-    *r_out *= sig / sig_orig;
-    *g_out *= sig / sig_orig;
-    *b_out *= sig / sig_orig;
+#define DEFINE_TONEMAP_FUNC(name, algo)                                         \
+static void tonemap_##name##_c(float *const dst[3], const float *const src[3], \
+                               int width, const float *c)                      \
+{                                                                               \
+    tonemap(dst, src, width, c, algo);                                          \
+}
+
+DEFINE_TONEMAP_FUNC(none,     TONEMAP_NONE)
+DEFINE_TONEMAP_FUNC(linear,   TONEMAP_LINEAR)
+DEFINE_TONEMAP_FUNC(gamma,    TONEMAP_GAMMA)
+DEFINE_TONEMAP_FUNC(clip,     TONEMAP_CLIP)
+DEFINE_TONEMAP_FUNC(reinhard, TONEMAP_REINHARD)
+DEFINE_TONEMAP_FUNC(hable,    TONEMAP_HABLE)
+DEFINE_TONEMAP_FUNC(mobius,   TONEMAP_MOBIUS)
+
+av_cold void ff_tonemap_init_dsp(TonemapDSPContext *dsp, enum TonemapAlgorithm algo)
+{
+    switch (algo) {
+    default:
+    case TONEMAP_NONE:     dsp->tonemap = tonemap_none_c;     break;
+    case TONEMAP_LINEAR:   dsp->tonemap = tonemap_linear_c;   break;
+    case TONEMAP_GAMMA:    dsp->tonemap = tonemap_gamma_c;    break;
+    case TONEMAP_CLIP:     dsp->tonemap = tonemap_clip_c;     break;
+    case TONEMAP_REINHARD: dsp->tonemap = tonemap_reinhard_c; break;
+    case TONEMAP_HABLE:    dsp->tonemap = tonemap_hable_c;    break;
+    case TONEMAP_MOBIUS:   dsp->tonemap = tonemap_mobius_c;   break;
+    }
+
+    if (ARCH_X86)
+        ff_tonemap_init_dsp_x86(dsp, algo);
 }
 
 typedef struct ThreadData {
     AVFrame *in, *out;
-    const AVPixFmtDescriptor *desc;
-    double peak;
 } ThreadData;
 
 static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -203,14 +262,22 @@ static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     ThreadData *td = arg;
     AVFrame *in = td->in;
     AVFrame *out = td->out;
-    const AVPixFmtDescriptor *desc = td->desc;
     const int slice_start = (in->height * jobnr) / nb_jobs;
     const int slice_end = (in->height * (jobnr+1)) / nb_jobs;
-    double peak = td->peak;
 
-    for (int y = slice_start; y < slice_end; y++)
-        for (int x = 0; x < out->width; x++)
-            tonemap(s, out, in, desc, x, y, peak);
+    for (int y = slice_start; y < slice_end; y++) {
+        const float *const src[3] = {
+            (const float *)(in->data[0] + y * in->linesize[0]),
+            (const float *)(in->data[1] + y * in->linesize[1]),
+            (const float *)(in->data[2] + y * in->linesize[2]),
+        };
+        float *const dst[3] = {
+            (float *)(out->data[0] + y * out->linesize[0]),
+            (float *)(out->data[1] + y * out->linesize[1]),
+            (float *)(out->data[2] + y * out->linesize[2]),
+        };
+        s->dsp.tonemap(dst, src, out->width, s->consts);
+    }
 
     return 0;
 }
@@ -226,6 +293,7 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
     int ret, x, y;
     double peak = s->peak;
+    double luma[3];
 
     if (!desc || !odesc) {
         av_frame_free(&in);
@@ -270,11 +338,15 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         s->desat = 0;
     }
 
+    /* the coefficients are in the order of the planes */
+    luma[0] = s->coeffs->cr;
+    luma[1] = s->coeffs->cb;
+    luma[2] = s->coeffs->cg;
+    ff_tonemap_init_consts(s->consts, s->tonemap, luma, s->desat, s->param, peak);
+
     /* do the tone map */
     td.out = out;
     td.in = in;
-    td.desc = desc;
-    td.peak = peak;
     ctx->internal->execute(ctx, tonemap_slice, &td, NULL, FFMIN(in->height, ff_filter_get_nb_threads(ctx)));
 
     /* copy/generate alpha if needed */
@@ -28,14 +28,70 @@
 #include "libavutil/hwcontext.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
 
 #include "avfilter.h"
+#include "filters.h"
 #include "internal.h"
 #include "video.h"
 
 #define BUFFER_ALIGN 32
 
 
+static FFFramePool *video_pool_init(AVFilterLink *link, int w, int h)
+{
+    /* share the buffers with the other links of the graph of the same size */
+    if (link->graph)
+        return ff_frame_pool_list_get_video(&link->graph->internal->frame_pools,
+                                            av_buffer_allocz, w, h,
+                                            link->format, BUFFER_ALIGN);
+
+    return ff_frame_pool_video_init(av_buffer_allocz, w, h,
+                                    link->format, BUFFER_ALIGN);
+}
+
+/**
+ * Get the border to reserve around the frames allocated for the link, as
+ * requested by its destination or, when the frames are modified in place,
+ * by the filters after it.
+ *
+ * @return 1 if a border must be reserved, 0 otherwise
+ */
+static int get_reserve_border(AVFilterLink *link, int w, int h, int border[4])
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+    AVFilterLink *l = link;
+    int hsub, vsub;
+
+    if (!desc || w != link->w || h != link->h ||
+        desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM |
+                       AV_PIX_FMT_FLAG_PAL | FF_PSEUDOPAL))
+        return 0;
+
+    while (!ff_inlink_get_reserve_border(l, border)) {
+        AVFilterLink *next;
+
+        if (!l->dstpad->needs_writable ||
+            l->dst->nb_inputs != 1 || l->dst->nb_outputs != 1)
+            return 0;
+        next = l->dst->outputs[0];
+        if (next->type != AVMEDIA_TYPE_VIDEO || next->format != l->format ||
+            next->w != l->w || next->h != l->h)
+            return 0;
+        l = next;
+    }
+
+    hsub = desc->log2_chroma_w;
+    vsub = desc->log2_chroma_h;
+    /* keep the image aligned in every plane */
+    border[0] = FFALIGN(border[0], BUFFER_ALIGN << hsub);
+    border[1] = FFALIGN(border[1], 1 << vsub);
+    border[2] = FFALIGN(border[2], 1 << hsub);
+    border[3] = FFALIGN(border[3], 1 << vsub);
+
+    return 1;
+}
+
 AVFrame *ff_null_get_video_buffer(AVFilterLink *link, int w, int h)
 {
     return ff_get_video_buffer(link->dst->outputs[0], w, h);
@@ -48,6 +104,8 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     int pool_height = 0;
     int pool_align = 0;
     enum AVPixelFormat pool_format = AV_PIX_FMT_NONE;
+    int border[4] = { 0 };
+    int has_border, alloc_w, alloc_h;
 
     if (link->hw_frames_ctx &&
         ((AVHWFramesContext*)link->hw_frames_ctx->data)->format == link->format) {
@@ -64,9 +122,12 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
         return frame;
     }
 
+    has_border = get_reserve_border(link, w, h, border);
+    alloc_w    = w + border[0] + border[2];
+    alloc_h    = h + border[1] + border[3];
+
     if (!link->frame_pool) {
-        link->frame_pool = ff_frame_pool_video_init(av_buffer_allocz, w, h,
-                                                    link->format, BUFFER_ALIGN);
+        link->frame_pool = video_pool_init(link, alloc_w, alloc_h);
         if (!link->frame_pool)
             return NULL;
     } else {
@@ -76,12 +137,11 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
             return NULL;
         }
 
-        if (pool_width != w || pool_height != h ||
+        if (pool_width != alloc_w || pool_height != alloc_h ||
             pool_format != link->format || pool_align != BUFFER_ALIGN) {
 
             ff_frame_pool_uninit((FFFramePool **)&link->frame_pool);
-            link->frame_pool = ff_frame_pool_video_init(av_buffer_allocz, w, h,
-                                                        link->format, BUFFER_ALIGN);
+            link->frame_pool = video_pool_init(link, alloc_w, alloc_h);
             if (!link->frame_pool)
                 return NULL;
         }
@@ -91,6 +151,22 @@ AVFrame *ff_default_get_video_buffer(AVFilterLink *link, int w, int h)
     if (!frame)
         return NULL;
 
+    if (has_border) {
+        const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
+        int max_pixsteps[4], plane;
+
+        av_image_fill_max_pixsteps(max_pixsteps, NULL, desc);
+        for (plane = 0; plane < 4 && frame->data[plane]; plane++) {
+            int hsub = plane == 1 || plane == 2 ? desc->log2_chroma_w : 0;
+            int vsub = plane == 1 || plane == 2 ? desc->log2_chroma_h : 0;
+
+            frame->data[plane] += (border[0] >> hsub) * max_pixsteps[plane] +
+                                  (border[1] >> vsub) * frame->linesize[plane];
+        }
+        frame->width  = w;
+        frame->height = h;
+    }
+
     frame->sample_aspect_ratio = link->sample_aspect_ratio;
 
     return frame;
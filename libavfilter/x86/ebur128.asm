@@ -0,0 +1,91 @@
+;*****************************************************************************
+;* x86-optimized functions for the EBU R128 loudness measurement
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; void filter_lanes(double *dst, const double *src, double *v,
+;                   const double *c, int frames)
+;
+; The 4 channels are in the lanes of the vectors. The products are summed
+; in the order of the C code and without FMA, so the output is identical.
+%if ARCH_X86_64
+INIT_YMM avx
+cglobal ebur128_filter_lanes, 5, 5, 16, dst, src, v, c, frames
+    ; m0-m3: the states v1-v4
+    movu             m0, [vq]
+    movu             m1, [vq + 32]
+    movu             m2, [vq + 64]
+    movu             m3, [vq + 96]
+    ; m4-m8: b0-b4, m9-m12: a1-a4
+    vbroadcastsd     m4, [cq]
+    vbroadcastsd     m5, [cq + 8]
+    vbroadcastsd     m6, [cq + 16]
+    vbroadcastsd     m7, [cq + 24]
+    vbroadcastsd     m8, [cq + 32]
+    vbroadcastsd     m9, [cq + 40]
+    vbroadcastsd    m10, [cq + 48]
+    vbroadcastsd    m11, [cq + 56]
+    vbroadcastsd    m12, [cq + 64]
+
+    movsxdifnidn framesq, framesd
+    shl         framesq, 5
+    add            srcq, framesq
+    add            dstq, framesq
+    neg         framesq
+    jz .end
+
+.loop:
+    ; v0 = src - a1 * v1 - a2 * v2 - a3 * v3 - a4 * v4
+    movu            m13, [srcq + framesq]
+    mulpd           m14, m9, m0
+    subpd           m13, m14
+    mulpd           m14, m10, m1
+    subpd           m13, m14
+    mulpd           m14, m11, m2
+    subpd           m13, m14
+    mulpd           m14, m12, m3
+    subpd           m13, m14
+    ; dst = b0 * v0 + b1 * v1 + b2 * v2 + b3 * v3 + b4 * v4
+    mulpd           m14, m4, m13
+    mulpd           m15, m5, m0
+    addpd           m14, m15
+    mulpd           m15, m6, m1
+    addpd           m14, m15
+    mulpd           m15, m7, m2
+    addpd           m14, m15
+    mulpd           m15, m8, m3
+    addpd           m14, m15
+    movu [dstq + framesq], m14
+    mova             m3, m2
+    mova             m2, m1
+    mova             m1, m0
+    mova             m0, m13
+    add         framesq, 32
+    jl .loop
+
+    movu          [vq], m0
+    movu     [vq + 32], m1
+    movu     [vq + 64], m2
+    movu     [vq + 96], m3
+.end:
+    RET
+%endif
@@ -0,0 +1,107 @@
+;*****************************************************************************
+;* x86-optimized functions for the true peak meter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_abs: times 4 dq 0x7fffffffffffffff
+
+SECTION .text
+
+; accumulate the 4 phases of tap k for the input sample at offset %2 into m%1
+%macro TAP 2
+    vbroadcastsd     m5, [xq + kq * 8 + %2 * 8]
+    mulpd            m5, m4
+    addpd           m%1, m5
+%endmacro
+
+; double interpolate_peak4(const double *coeffs, const double *x,
+;                          int nb_samples, int phase_taps)
+;
+; The 4 phases of an output are in the lanes of a vector, and 4 outputs are
+; computed at once to interleave their sums. Each sum is done in the order
+; of the C code and without FMA, so the peak is identical.
+%if ARCH_X86_64
+INIT_YMM avx
+cglobal truepeak_interpolate_peak4, 4, 6, 10, coeffs, x, len, taps, k, c
+    movsxdifnidn   lenq, lend
+    movsxdifnidn  tapsq, tapsd
+    xorpd            m8, m8
+    mova             m9, [pd_abs]
+    sub            lenq, 4
+    jl .tail
+
+.loop4:
+    xorpd            m0, m0
+    xorpd            m1, m1
+    xorpd            m2, m2
+    xorpd            m3, m3
+    mov              cq, coeffsq
+    xor              kq, kq
+.taps4:
+    movu             m4, [cq]
+    TAP               0, 0
+    TAP               1, 1
+    TAP               2, 2
+    TAP               3, 3
+    add              cq, mmsize
+    inc              kq
+    cmp              kq, tapsq
+    jl .taps4
+    andpd            m0, m9
+    andpd            m1, m9
+    andpd            m2, m9
+    andpd            m3, m9
+    maxpd            m8, m0
+    maxpd            m8, m1
+    maxpd            m8, m2
+    maxpd            m8, m3
+    add              xq, 4 * 8
+    sub            lenq, 4
+    jge .loop4
+
+.tail:
+    add            lenq, 4
+    jz .end
+.loop1:
+    xorpd            m0, m0
+    mov              cq, coeffsq
+    xor              kq, kq
+.taps1:
+    movu             m4, [cq]
+    TAP               0, 0
+    add              cq, mmsize
+    inc              kq
+    cmp              kq, tapsq
+    jl .taps1
+    andpd            m0, m9
+    maxpd            m8, m0
+    add              xq, 8
+    dec            lenq
+    jg .loop1
+
+.end:
+    vextractf128    xm0, m8, 1
+    maxpd           xm0, xm8
+    unpckhpd        xm1, xm0, xm0
+    maxsd           xm0, xm1
+    RET
+%endif
@@ -0,0 +1,140 @@
+;*****************************************************************************
+;* x86-optimized functions for boxblur filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_255: times 8 dd 255
+
+SECTION .text
+
+; void blur_row(type *dst, const type *add, const type *sub, int *sum,
+;               int inv, int w)
+;
+; sum[x] += (add[x] - sub[x]) * inv, dst[x] = sum[x] >> 16
+;
+; The sums wrap around like the ints of the C code, and only the low bits of
+; sum >> 16 are stored, like the conversion to the pixel type does.
+; %1 = 8 or 16 bits per pixel. Each iteration handles 2 vectors of sums.
+%macro BLUR_ROW 1
+%if %1 == 8
+    %define PMOVZX pmovzxbd
+    %define bps 1
+%else
+    %define PMOVZX pmovzxwd
+    %define bps 2
+%endif
+cglobal blur_row%1, 6, 9, 6, dst, add, sub, sum, inv, w, x, end, tmp
+    movd            xm4, invd
+%if cpuflag(avx2)
+    vpbroadcastd     m4, xm4
+%else
+    SPLATD           m4
+%endif
+%if %1 == 8
+    mova             m5, [pd_255]
+%endif
+    movsxdifnidn     wq, wd
+    xor              xq, xq
+    mov            endq, wq
+    and            endq, -(mmsize / 2)
+    jz .tail
+
+.loop:
+    PMOVZX           m0, [addq + xq * bps]
+    PMOVZX           m1, [addq + xq * bps + mmsize / 4 * bps]
+    PMOVZX           m2, [subq + xq * bps]
+    PMOVZX           m3, [subq + xq * bps + mmsize / 4 * bps]
+    psubd            m0, m2
+    psubd            m1, m3
+    pmulld           m0, m4
+    pmulld           m1, m4
+    movu             m2, [sumq + xq * 4]
+    movu             m3, [sumq + xq * 4 + mmsize]
+    paddd            m0, m2
+    paddd            m1, m3
+    movu  [sumq + xq * 4], m0
+    movu  [sumq + xq * 4 + mmsize], m1
+    psrad            m0, 16
+    psrad            m1, 16
+%if %1 == 8
+    pand             m0, m5
+    pand             m1, m5
+%endif
+    packssdw         m0, m1
+%if cpuflag(avx2)
+    vpermq           m0, m0, q3120
+%endif
+%if %1 == 8
+%if cpuflag(avx2)
+    vextracti128    xm1, m0, 1
+    packuswb        xm0, xm1
+    movu  [dstq + xq], xm0
+%else
+    packuswb         m0, m0
+    movq  [dstq + xq], m0
+%endif
+%else
+    movu  [dstq + xq * 2], m0
+%endif
+    add              xq, mmsize / 2
+    cmp              xq, endq
+    jl .loop
+
+.tail:
+    cmp              xq, wq
+    jge .end
+.tail_loop:
+%if %1 == 8
+    movzx          tmpd, byte [addq + xq]
+    movzx          endd, byte [subq + xq]
+%else
+    movzx          tmpd, word [addq + xq * 2]
+    movzx          endd, word [subq + xq * 2]
+%endif
+    sub            tmpd, endd
+    imul           tmpd, invd
+    add            tmpd, [sumq + xq * 4]
+    mov [sumq + xq * 4], tmpd
+    sar            tmpd, 16
+%if %1 == 8
+    mov     [dstq + xq], tmpb
+%else
+    mov [dstq + xq * 2], tmpw
+%endif
+    inc              xq
+    cmp              xq, wq
+    jl .tail_loop
+.end:
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse4
+BLUR_ROW 8
+BLUR_ROW 16
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+BLUR_ROW 8
+BLUR_ROW 16
+%endif
+%endif
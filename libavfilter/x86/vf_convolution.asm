@@ -0,0 +1,288 @@
+;*****************************************************************************
+;* x86-optimized functions for convolution filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+pf_half: dd 0.5
+
+SECTION .text
+
+; all functions share the prototype of the C row filters:
+; void filter(uint8_t *dst, int width,
+;             float rdiv, float bias, const int *const matrix,
+;             const uint8_t *c[], int peak, int radius,
+;             int dstride, int stride)
+; the sums are computed on 32-bit integers and converted to float in the
+; same order of operations as the C code, so the output is bitexact
+
+; load mmsize / 4 pixels at column x of %2 into m%1, %3 = bit depth
+%macro LOAD_PIXELS 4
+%if %3 == 8
+    pmovzxbd         m%1, [%2q + xq]
+%else
+    pmovzxwd         m%1, [%2q + xq * 2]
+%endif
+%endmacro
+
+; load the single pixel at column x of %2 into m%1 using %4 as temporary
+%macro LOAD_PIXEL 4
+%if %3 == 8
+    movzx            %4d, byte [%2q + xq]
+%else
+    movzx            %4d, word [%2q + xq * 2]
+%endif
+    movd            xm%1, %4d
+%endmacro
+
+; clip and pack the dwords of m%1 into the low half of xm%1, %2 = bit depth,
+; m%3 is clobbered and xm2 holds the peak for more than 8 bits
+%macro PACK_PIXELS 3
+    vextracti128    xm%3, m%1, 1
+%if %2 == 8
+    packssdw        xm%1, xm%3
+    packuswb        xm%1, xm%1
+%else
+    packusdw        xm%1, xm%3
+    pminuw          xm%1, xm2
+%endif
+%endmacro
+
+%macro STORE_PIXELS 2
+%if %2 == 8
+    movq   [dstq + xq], xm%1
+%else
+    movu   [dstq + xq * 2], xm%1
+%endif
+%endmacro
+
+%macro STORE_PIXEL 2
+%if %2 == 8
+    pextrb [dstq + xq], xm%1, 0
+%else
+    pextrw [dstq + xq * 2], xm%1, 0
+%endif
+%endmacro
+
+; %1 = load macro, %2 = bit depth
+%macro MATRIX_SUM 2
+    pxor              m4, m4
+    xor               iq, iq
+%%taps:
+    mov               cq, [ptrq + iq * gprsize]
+    %1                 5, c, %2, c
+    vpbroadcastd      m6, [matrixq + iq * 4]
+    pmulld            m5, m6
+    paddd             m4, m5
+    inc               iq
+    cmp               iq, tapq
+    jl %%taps
+    cvtdq2ps          m4, m4
+    mulps             m4, m0                    ; sum * rdiv
+    addps             m4, m1                    ; + bias
+    addps             m4, m3                    ; + 0.5
+    cvttps2dq         m4, m4
+    PACK_PIXELS        4, %2, 5
+%endmacro
+
+; %1 = function prefix, %2 = name, %3 = number of taps (0: 2 * radius + 1),
+; %4 = bit depth
+%macro FILTER_MATRIX 4
+%if UNIX64
+cglobal %1_%2, 4, 11, 7, dst, width, matrix, ptr, peak, radius, x, i, tap, c, vec
+%else
+cglobal %1_%2, 4, 11, 7, dst, width, rdiv, bias, matrix, ptr, peak, radius
+%endif
+%if WIN64
+    SWAP               0, 2
+    SWAP               1, 3
+    mov              r2q, matrixmp
+    mov              r3q, ptrmp
+    movd             xm2, peakm
+    mov              r5d, radiusm
+    DEFINE_ARGS dst, width, matrix, ptr, peak, radius, x, i, tap, c, vec
+%else
+    movd             xm2, peakd
+%endif
+    VBROADCASTSS      m0, xm0
+    VBROADCASTSS      m1, xm1
+    VBROADCASTSS      m3, [pf_half]
+%if %4 > 8
+    vpbroadcastw     xm2, xm2
+%endif
+%if %3
+    mov             tapd, %3
+%else
+    lea             tapd, [radiusq * 2 + 1]
+%endif
+    movsxdifnidn  widthq, widthd
+    mov             vecq, widthq
+    and             vecq, ~(mmsize / 4 - 1)
+    xor               xq, xq
+    cmp               xq, vecq
+    jge .tail
+.loop:
+    MATRIX_SUM LOAD_PIXELS, %4
+    STORE_PIXELS       4, %4
+    add               xq, mmsize / 4
+    cmp               xq, vecq
+    jl .loop
+.tail:
+    cmp               xq, widthq
+    jge .end
+    MATRIX_SUM LOAD_PIXEL, %4
+    STORE_PIXEL        4, %4
+    inc               xq
+    jmp .tail
+.end:
+    RET
+%endmacro
+
+; %1 = load macro, %2 = bit depth, %3 = weight of the middle taps (1 or 2)
+%macro PREWITT_SOBEL_SUMS 3
+    %1                 3, c0, %2, tmp
+    %1                 4, c2, %2, tmp
+    %1                 5, c6, %2, tmp
+    %1                 6, c8, %2, tmp
+    psubd             m7, m5, m3                ; c6 - c0
+    psubd             m8, m6, m4                ; c8 - c2
+    paddd             m7, m8
+    psubd             m8, m4, m3                ; c2 - c0
+    psubd             m6, m5                    ; c8 - c6
+    paddd             m8, m6
+    %1                 3, c1, %2, tmp
+    %1                 4, c7, %2, tmp
+    psubd             m4, m3                    ; c7 - c1
+%if %3 == 2
+    paddd             m4, m4
+%endif
+    paddd             m7, m4
+    %1                 3, c3, %2, tmp
+    %1                 4, c5, %2, tmp
+    psubd             m4, m3                    ; c5 - c3
+%if %3 == 2
+    paddd             m4, m4
+%endif
+    paddd             m8, m4
+%endmacro
+
+%macro PREWITT_SUMS 2
+    PREWITT_SOBEL_SUMS %1, %2, 1
+%endmacro
+
+%macro SOBEL_SUMS 2
+    PREWITT_SOBEL_SUMS %1, %2, 2
+%endmacro
+
+%macro ROBERTS_SUMS 2
+    %1                 3, c0, %2, tmp
+    %1                 4, c1, %2, tmp
+    psubd             m7, m3, m4                ; c0 - c1
+    %1                 3, c4, %2, tmp
+    %1                 4, c3, %2, tmp
+    psubd             m8, m3, m4                ; c4 - c3
+%endmacro
+
+; %1 = sums macro, %2 = load macro, %3 = bit depth
+%macro EDGE_SUM 3
+    %1                %2, %3
+    pmulld            m7, m7
+    pmulld            m8, m8
+    paddd             m7, m8
+    cvtdq2ps          m7, m7
+    sqrtps            m7, m7
+    mulps             m7, m0                    ; * scale
+    addps             m7, m1                    ; + delta
+    cvttps2dq         m7, m7
+    PACK_PIXELS        7, %3, 8
+%endmacro
+
+; %1 = function prefix, %2 = operator, %3 = sums macro, %4 = bit depth
+%macro FILTER_EDGE 4
+%if UNIX64
+cglobal %1_%2, 4, 15, 9, dst, width, matrix, ptr, peak
+%else
+cglobal %1_%2, 4, 15, 9, dst, width, scale, delta, matrix, ptr, peak
+%endif
+%if WIN64
+    SWAP               0, 2
+    SWAP               1, 3
+    mov              r3q, ptrmp
+    movd             xm2, peakm
+%else
+    movd             xm2, peakd
+%endif
+    DEFINE_ARGS dst, width, vec, ptr, tmp, x, c0, c1, c2, c3, c4, c5, c6, c7, c8
+    VBROADCASTSS      m0, xm0
+    VBROADCASTSS      m1, xm1
+%if %4 > 8
+    vpbroadcastw     xm2, xm2
+%endif
+    mov              c0q, [ptrq + 0 * gprsize]
+    mov              c1q, [ptrq + 1 * gprsize]
+    mov              c2q, [ptrq + 2 * gprsize]
+    mov              c3q, [ptrq + 3 * gprsize]
+    mov              c4q, [ptrq + 4 * gprsize]
+    mov              c5q, [ptrq + 5 * gprsize]
+    mov              c6q, [ptrq + 6 * gprsize]
+    mov              c7q, [ptrq + 7 * gprsize]
+    mov              c8q, [ptrq + 8 * gprsize]
+    movsxdifnidn  widthq, widthd
+    mov             vecq, widthq
+    and             vecq, ~(mmsize / 4 - 1)
+    xor               xq, xq
+    cmp               xq, vecq
+    jge .tail
+.loop:
+    EDGE_SUM          %3, LOAD_PIXELS, %4
+    STORE_PIXELS       7, %4
+    add               xq, mmsize / 4
+    cmp               xq, vecq
+    jl .loop
+.tail:
+    cmp               xq, widthq
+    jge .end
+    EDGE_SUM          %3, LOAD_PIXEL, %4
+    STORE_PIXEL        7, %4
+    inc               xq
+    jmp .tail
+.end:
+    RET
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+FILTER_MATRIX filter,   3x3,  9,  8
+FILTER_MATRIX filter,   5x5, 25,  8
+FILTER_MATRIX filter,   7x7, 49,  8
+FILTER_MATRIX filter,   row,  0,  8
+FILTER_MATRIX filter16, 3x3,  9, 16
+FILTER_MATRIX filter16, 5x5, 25, 16
+FILTER_MATRIX filter16, 7x7, 49, 16
+FILTER_MATRIX filter16, row,  0, 16
+
+FILTER_EDGE filter,   prewitt, PREWITT_SUMS,  8
+FILTER_EDGE filter,   roberts, ROBERTS_SUMS,  8
+FILTER_EDGE filter,   sobel,   SOBEL_SUMS,    8
+FILTER_EDGE filter16, prewitt, PREWITT_SUMS, 16
+FILTER_EDGE filter16, roberts, ROBERTS_SUMS, 16
+FILTER_EDGE filter16, sobel,   SOBEL_SUMS,   16
+%endif
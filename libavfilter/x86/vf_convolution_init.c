@@ -0,0 +1,83 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/convolution.h"
+
+#define DECLARE_FILTER(name)                                            \
+void ff_##name##_avx2(uint8_t *dst, int width,                          \
+                      float rdiv, float bias, const int *const matrix,  \
+                      const uint8_t *c[], int peak, int radius,         \
+                      int dstride, int stride);
+
+DECLARE_FILTER(filter_3x3)
+DECLARE_FILTER(filter_5x5)
+DECLARE_FILTER(filter_7x7)
+DECLARE_FILTER(filter_row)
+DECLARE_FILTER(filter16_3x3)
+DECLARE_FILTER(filter16_5x5)
+DECLARE_FILTER(filter16_7x7)
+DECLARE_FILTER(filter16_row)
+DECLARE_FILTER(filter_prewitt)
+DECLARE_FILTER(filter_roberts)
+DECLARE_FILTER(filter_sobel)
+DECLARE_FILTER(filter16_prewitt)
+DECLARE_FILTER(filter16_roberts)
+DECLARE_FILTER(filter16_sobel)
+
+av_cold void ff_convolution_init_x86(ConvolutionContext *s, enum ConvolutionType type, int depth)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+    int p;
+
+    if (!EXTERNAL_AVX2_FAST(cpu_flags))
+        return;
+
+    for (p = 0; p < 4; p++) {
+        if (s->copy[p])
+            continue;
+
+        switch (type) {
+        case CONVOLUTION_MATRIX:
+            if (s->mode[p] == MATRIX_ROW)
+                s->filter[p] = depth > 8 ? ff_filter16_row_avx2 : ff_filter_row_avx2;
+            else if (s->mode[p] == MATRIX_COLUMN)
+                break;
+            else if (s->size[p] == 3)
+                s->filter[p] = depth > 8 ? ff_filter16_3x3_avx2 : ff_filter_3x3_avx2;
+            else if (s->size[p] == 5)
+                s->filter[p] = depth > 8 ? ff_filter16_5x5_avx2 : ff_filter_5x5_avx2;
+            else if (s->size[p] == 7)
+                s->filter[p] = depth > 8 ? ff_filter16_7x7_avx2 : ff_filter_7x7_avx2;
+            break;
+        case CONVOLUTION_PREWITT:
+            s->filter[p] = depth > 8 ? ff_filter16_prewitt_avx2 : ff_filter_prewitt_avx2;
+            break;
+        case CONVOLUTION_ROBERTS:
+            s->filter[p] = depth > 8 ? ff_filter16_roberts_avx2 : ff_filter_roberts_avx2;
+            break;
+        case CONVOLUTION_SOBEL:
+            s->filter[p] = depth > 8 ? ff_filter16_sobel_avx2   : ff_filter_sobel_avx2;
+            break;
+        }
+    }
+#endif
+}
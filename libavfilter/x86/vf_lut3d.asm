@@ -0,0 +1,256 @@
+;*****************************************************************************
+;* x86-optimized functions for lut3d filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_1: times 8 dd 1
+pf_1: times 8 dd 1.0
+
+SECTION .text
+
+; void interp_row(uint8_t *const dst[3], const uint8_t *const src[3], int width,
+;                 const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL], int lutsize,
+;                 const float *scale)
+;
+; the lut entries are 3 floats and MAX_LEVEL is 128, so the lut[r][g][b]
+; entry starts at float index 3 * ((r << 14) + (g << 7) + b)
+;
+; the floating point operations are done in the same order as the C code,
+; so the output is bitexact
+
+; load 8 samples at column x of %2 into m%1 as floats, %3 = bit depth
+%macro LOAD_SAMPLES 3
+%if %3 == 8
+    pmovzxbd        m%1, [%2q + xq]
+%else
+    pmovzxwd        m%1, [%2q + xq * 2]
+%endif
+    cvtdq2ps        m%1, m%1
+%endmacro
+
+; turn the prev coordinate in m%1 into the lut offset of the next point
+; along the same axis, %2 = log2 of the axis stride
+%macro STEP 2
+    paddd            m6, m%1, [pd_1]
+    pminsd           m6, m12                ; next = FFMIN(prev + 1, lutsize - 1)
+    psubd            m6, m%1
+    paddd            m7, m6, m6
+    paddd            m6, m7
+%if %2
+    pslld           m%1, m6, %2
+%else
+    mova            m%1, m6
+%endif
+%endmacro
+
+; compute the fractional parts in m0-m2, the offset of the prev point in m8
+; and the offsets to the next point along r, g and b in m3-m5
+%macro COORDS 1
+    LOAD_SAMPLES      0, srcr, %1
+    LOAD_SAMPLES      1, srcg, %1
+    LOAD_SAMPLES      2, srcb, %1
+    VBROADCASTSS     m6, [scaleq]
+    mulps            m0, m6
+    VBROADCASTSS     m6, [scaleq + 4]
+    mulps            m1, m6
+    VBROADCASTSS     m6, [scaleq + 8]
+    mulps            m2, m6
+    cvttps2dq        m3, m0                 ; prev
+    cvttps2dq        m4, m1
+    cvttps2dq        m5, m2
+    cvtdq2ps         m6, m3
+    subps            m0, m6                 ; d = s - prev
+    cvtdq2ps         m6, m4
+    subps            m1, m6
+    cvtdq2ps         m6, m5
+    subps            m2, m6
+    pslld            m8, m3, 14
+    pslld            m6, m4, 7
+    paddd            m8, m6
+    paddd            m8, m5
+    paddd            m6, m8, m8
+    paddd            m8, m6
+    STEP              3, 14
+    STEP              4, 7
+    STEP              5, 0
+%endmacro
+
+; gather component %4 of the lut entries at the offsets in m%2 into m%1,
+; m%3 is clobbered
+%macro GATHER 4
+    pcmpeqd         m%3, m%3
+    vgatherdps      m%1, [lutq + m%2 * 4 + %4 * 4], m%3
+%endmacro
+
+; m%1 = m%1 + (m%2 - m%1) * m%3, m%2 is clobbered
+%macro LERP 3
+    subps           m%2, m%1
+    mulps           m%2, m%3
+    addps           m%1, m%2
+%endmacro
+
+; scale, clip and store the component in m%1 to column x of %2,
+; %3 = bit depth, m9 is clobbered
+%macro STORE 3
+    mulps           m%1, m13
+    cvttps2dq       m%1, m%1
+    pxor             m9, m9
+    pmaxsd          m%1, m9
+    pminsd          m%1, m14
+    vextracti128    xm9, m%1, 1
+    packusdw       xm%1, xm9
+%if %3 == 8
+    packuswb       xm%1, xm%1
+    movq    [%2q + xq], xm%1
+%else
+    movu    [%2q + xq * 2], xm%1
+%endif
+%endmacro
+
+; %1 = component, %2 = destination, %3 = bit depth
+%macro TRILINEAR 3
+    GATHER           10, 8, 9, %1           ; c000
+    paddd            m7, m8, m3
+    GATHER           11, 7, 9, %1           ; c100
+    LERP             10, 11, 0              ; c00
+    paddd            m7, m8, m4
+    GATHER           11, 7, 9, %1           ; c010
+    paddd            m7, m3
+    GATHER            6, 7, 9, %1           ; c110
+    LERP             11, 6, 0               ; c10
+    LERP             10, 11, 1              ; c0
+    paddd            m7, m8, m5
+    GATHER           11, 7, 9, %1           ; c001
+    paddd            m7, m3
+    GATHER            6, 7, 9, %1           ; c101
+    LERP             11, 6, 0               ; c01
+    paddd            m7, m8, m5
+    paddd            m7, m4
+    GATHER            6, 7, 9, %1           ; c011
+    paddd            m7, m3
+    GATHER           15, 7, 9, %1           ; c111
+    LERP              6, 15, 0              ; c11
+    LERP             11, 6, 1               ; c1
+    LERP             10, 11, 2              ; c
+    STORE            10, %2, %3
+%endmacro
+
+; The C code picks one of 6 tetrahedra by comparing the fractional parts,
+; the weights are then always the differences between the sorted fractional
+; parts x1 >= x2 >= x3, and the inner vertices are reached by stepping along
+; the axis of x1 first and then along the axis of x2. On ties the vertex
+; choice may differ from the C code, but then its weight is zero.
+; The weights are left in m0, m1, m2 and m7, the offsets of the vertices in
+; m8, m4, m5 and m3.
+%macro TETRAHEDRAL_WEIGHTS 0
+    maxps            m6, m1, m2
+    maxps            m6, m0                 ; x1
+    minps            m7, m1, m2
+    minps            m7, m0                 ; x3
+    minps            m9, m0, m1
+    maxps           m10, m0, m1
+    minps           m10, m2
+    maxps            m9, m10                ; x2
+    cmpps           m10, m0, m1, 5          ; r >= g
+    cmpps           m11, m0, m2, 5          ; r >= b
+    andps           m10, m11
+    cmpps           m11, m1, m2, 5          ; g >= b
+    vblendvps       m11, m5, m4, m11
+    vblendvps       m10, m11, m3, m10       ; step along the axis of x1
+    cmpps           m11, m0, m1, 2          ; r <= g
+    cmpps           m15, m0, m2, 2          ; r <= b
+    andps           m11, m15
+    cmpps           m15, m1, m2, 2          ; g <= b
+    vblendvps       m15, m5, m4, m15
+    vblendvps       m11, m15, m3, m11       ; step along the axis of x3
+    mova             m0, [pf_1]
+    subps            m0, m6                 ; 1 - x1
+    subps            m1, m6, m9             ; x1 - x2
+    subps            m2, m9, m7             ; x2 - x3
+    paddd            m3, m4
+    paddd            m3, m5
+    paddd            m3, m8                 ; c111
+    paddd            m4, m8, m10            ; first inner vertex
+    psubd            m5, m3, m11            ; second inner vertex
+%endmacro
+
+; %1 = component, %2 = destination, %3 = bit depth
+%macro TETRAHEDRAL 3
+    GATHER            6, 8, 9, %1
+    mulps            m6, m0
+    GATHER           10, 4, 9, %1
+    mulps           m10, m1
+    addps            m6, m10
+    GATHER           10, 5, 9, %1
+    mulps           m10, m2
+    addps            m6, m10
+    GATHER           10, 3, 9, %1
+    mulps           m10, m7
+    addps            m6, m10
+    STORE             6, %2, %3
+%endmacro
+
+; %1 = interpolation, %2 = bit depth
+%macro INTERP_ROW 2
+cglobal interp_row_%1_%2, 6, 11, 16, dst, src, width, lut, lutsize, scale, dstg, dstb, srcg, srcb, x
+    mov           dstgq, [dstq + gprsize]
+    mov           dstbq, [dstq + 2 * gprsize]
+    mov            dstq, [dstq]
+    mov           srcgq, [srcq + gprsize]
+    mov           srcbq, [srcq + 2 * gprsize]
+    mov            srcq, [srcq]
+    DEFINE_ARGS dstr, srcr, width, lut, lutmax, scale, dstg, dstb, srcg, srcb, x
+    dec         lutmaxd
+    movd           xm12, lutmaxd
+    vpbroadcastd    m12, xm12
+    VBROADCASTSS    m13, [scaleq + 12]
+    cvttps2dq       m14, m13
+    movsxdifnidn  widthq, widthd
+    xor              xq, xq
+    test         widthq, widthq
+    jz .end
+.loop:
+    COORDS           %2
+%ifidn %1, tetrahedral
+    TETRAHEDRAL_WEIGHTS
+    TETRAHEDRAL       0, dstr, %2
+    TETRAHEDRAL       1, dstg, %2
+    TETRAHEDRAL       2, dstb, %2
+%else
+    TRILINEAR         0, dstr, %2
+    TRILINEAR         1, dstg, %2
+    TRILINEAR         2, dstb, %2
+%endif
+    add              xq, 8
+    cmp              xq, widthq
+    jl .loop
+.end:
+    RET
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+INTERP_ROW trilinear,    8
+INTERP_ROW trilinear,   16
+INTERP_ROW tetrahedral,  8
+INTERP_ROW tetrahedral, 16
+%endif
@@ -0,0 +1,57 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/lut3d.h"
+
+#define DECLARE_INTERP_ROW(name)                                                        \
+void ff_interp_row_##name##_avx2(uint8_t *const dst[3], const uint8_t *const src[3],    \
+                                 int width,                                             \
+                                 const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL],      \
+                                 int lutsize, const float *scale);
+
+DECLARE_INTERP_ROW(trilinear_8)
+DECLARE_INTERP_ROW(trilinear_16)
+DECLARE_INTERP_ROW(tetrahedral_8)
+DECLARE_INTERP_ROW(tetrahedral_16)
+
+av_cold void ff_lut3d_init_dsp_x86(LUT3DDSPContext *dsp, int interpolation, int nbits)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (!EXTERNAL_AVX2_FAST(cpu_flags))
+        return;
+
+    switch (interpolation) {
+    case INTERPOLATE_TRILINEAR:
+        dsp->interp_row = nbits > 8 ? ff_interp_row_trilinear_16_avx2
+                                    : ff_interp_row_trilinear_8_avx2;
+        break;
+    case INTERPOLATE_TETRAHEDRAL:
+        dsp->interp_row = nbits > 8 ? ff_interp_row_tetrahedral_16_avx2
+                                    : ff_interp_row_tetrahedral_8_avx2;
+        break;
+    default:
+        return;
+    }
+    dsp->deinterleave_packed = 1;
+#endif
+}
@@ -0,0 +1,142 @@
+;*****************************************************************************
+;* x86-optimized functions for nnedi filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or modify
+;* it under the terms of the GNU General Public License as published by
+;* the Free Software Foundation; either version 2 of the License, or
+;* (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;* GNU General Public License for more details.
+;*
+;* You should have received a copy of the GNU General Public License along
+;* with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+;* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_dot_prod(const float *data, const float *weights, float *vals,
+;                        int n, int len, const float *scale)
+;
+; Four neurons are evaluated per iteration so that every input vector is
+; loaded once for all of them.
+;------------------------------------------------------------------------------
+
+INIT_YMM fma3
+cglobal nnedi_dot_prod, 6, 11, 6, data, weights, vals, n, len, scale, bias, w1, w2, w3, off
+    vbroadcastss   xm5, [scaleq]
+    movsxdifnidn     nq, nd
+    movsxdifnidn   lenq, lend
+    mov          biasq, nq
+    imul         biasq, lenq
+    lea          biasq, [weightsq + biasq * 4]
+    shl           lenq, 2
+    add          dataq, lenq
+    add       weightsq, lenq
+
+.loop_n:
+    lea            w1q, [weightsq + lenq]
+    lea            w2q, [weightsq + lenq * 2]
+    lea            w3q, [w1q + lenq * 2]
+    mov           offq, lenq
+    neg           offq
+    xorps            m0, m0, m0
+    xorps            m1, m1, m1
+    xorps            m2, m2, m2
+    xorps            m3, m3, m3
+
+.loop_len:
+    movu             m4, [dataq + offq]
+    fmaddps          m0, m4, [weightsq + offq], m0
+    fmaddps          m1, m4, [w1q + offq], m1
+    fmaddps          m2, m4, [w2q + offq], m2
+    fmaddps          m3, m4, [w3q + offq], m3
+    add            offq, mmsize
+    jl .loop_len
+
+    haddps           m0, m0, m1
+    haddps           m2, m2, m3
+    haddps           m0, m0, m2
+    vextractf128    xm1, m0, 1
+    addps           xm0, xm0, xm1
+    mulps           xm0, xm0, xm5
+    addps           xm0, xm0, [biasq]
+    movups      [valsq], xm0
+
+    lea        weightsq, [w3q + lenq]
+    add            biasq, 16
+    add            valsq, 16
+    sub               nd, 4
+    jg .loop_n
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_dot_prods(const int16_t *data, const int16_t *weights, float *vals,
+;                         int n, int len, const float *scale)
+;------------------------------------------------------------------------------
+
+INIT_YMM avx2
+cglobal nnedi_dot_prods, 6, 11, 7, data, weights, vals, n, len, scale, wf, w1, w2, w3, off
+    vbroadcastss   xm5, [scaleq]
+    movsxdifnidn     nq, nd
+    movsxdifnidn   lenq, lend
+    mov            wfq, nq
+    imul           wfq, lenq
+    lea            wfq, [weightsq + wfq * 2]
+    add           lenq, lenq
+    add          dataq, lenq
+    add       weightsq, lenq
+
+.loop_n:
+    lea            w1q, [weightsq + lenq]
+    lea            w2q, [weightsq + lenq * 2]
+    lea            w3q, [w1q + lenq * 2]
+    mov           offq, lenq
+    neg           offq
+    pxor             m0, m0, m0
+    pxor             m1, m1, m1
+    pxor             m2, m2, m2
+    pxor             m3, m3, m3
+
+.loop_len:
+    movu             m4, [dataq + offq]
+    pmaddwd          m6, m4, [weightsq + offq]
+    paddd            m0, m0, m6
+    pmaddwd          m6, m4, [w1q + offq]
+    paddd            m1, m1, m6
+    pmaddwd          m6, m4, [w2q + offq]
+    paddd            m2, m2, m6
+    pmaddwd          m6, m4, [w3q + offq]
+    paddd            m3, m3, m6
+    add            offq, mmsize
+    jl .loop_len
+
+    phaddd           m0, m0, m1
+    phaddd           m2, m2, m3
+    phaddd           m0, m0, m2
+    vextracti128    xm1, m0, 1
+    paddd           xm0, xm0, xm1
+    cvtdq2ps        xm0, xm0
+    mulps           xm0, xm0, [wfq]
+    mulps           xm0, xm0, xm5
+    addps           xm0, xm0, [wfq + 16]
+    movups      [valsq], xm0
+
+    lea        weightsq, [w3q + lenq]
+    add              wfq, 32
+    add            valsq, 16
+    sub               nd, 4
+    jg .loop_n
+    RET
+
+%endif
@@ -0,0 +1,79 @@
+;*****************************************************************************
+;* x86-optimized functions for paletteuse filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; unsigned ff_paletteuse_nearest_key(const uint32_t *rgb, const uint32_t *keys,
+;                                    uint32_t color)
+;------------------------------------------------------------------------------
+
+%macro NEAREST_KEY 0
+cglobal paletteuse_nearest_key, 3, 4, 6, rgb, keys, color, i
+    movd            xm0, colord
+%if cpuflag(avx2)
+    vpbroadcastd     m0, xm0
+%else
+    pshufd           m0, m0, 0
+%endif
+    pxor             m5, m5
+    punpcklbw        m0, m5                 ; target as words, alpha is 0
+    pcmpeqd          m1, m1                 ; running minimum key
+    add            rgbq, 256 * 4
+    add           keysq, 256 * 4
+    mov              iq, -256 * 4
+
+.loop:
+    movu             m2, [rgbq + iq]
+    movu             m4, [keysq + iq]
+    punpckhbw        m3, m2, m5
+    punpcklbw        m2, m5
+    psubw            m2, m0
+    psubw            m3, m0
+    pmaddwd          m2, m2                 ; db*db + dg*dg, dr*dr
+    pmaddwd          m3, m3
+    phaddd           m2, m3                 ; squared distance, in entry order
+    pslld            m2, 8
+    paddd            m2, m4
+    pminud           m1, m2
+    add              iq, mmsize
+    jl .loop
+
+%if mmsize == 32
+    vextracti128    xm2, m1, 1
+    pminud          xm1, xm2
+%endif
+    pshufd          xm2, xm1, q1032
+    pminud          xm1, xm2
+    pshufd          xm2, xm1, q2301
+    pminud          xm1, xm2
+    movd            eax, xm1
+    RET
+%endmacro
+
+INIT_XMM sse4
+NEAREST_KEY
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+NEAREST_KEY
+%endif
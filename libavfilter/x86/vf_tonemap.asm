@@ -0,0 +1,205 @@
+;*****************************************************************************
+;* x86-optimized functions for tonemap filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pf_1:   times 8 dd 1.0
+pf_eps: times 8 dd 1.0e-6
+
+SECTION .text
+
+; void tonemap(float *const dst[3], const float *const src[3], int width,
+;              const float *c)
+;
+; c holds the luma coefficients, the desaturation strength and the curve
+; parameters, see ff_tonemap_init_consts(). The operations are done in the
+; same order as the C code.
+
+; load the pixels at column x of %2 into m%1, %3 = 1 for a full vector,
+; 0 for a single pixel
+%macro LOAD 3
+%if %3
+    movu            m%1, [%2q + xq * 4]
+%else
+    movss          xm%1, [%2q + xq * 4]
+%endif
+%endmacro
+
+%macro STORE 3
+%if %3
+    movu  [%2q + xq * 4], m%1
+%else
+    movss [%2q + xq * 4], xm%1
+%endif
+%endmacro
+
+; m%1 = m%1 * (1 - overbright) + luma * overbright, with m5 = 1 - overbright
+; and m3 = luma * overbright
+%macro MIX 1
+    mulps           m%1, m5
+    addps           m%1, m3
+%endmacro
+
+; compute the new signal level in m4 from the signal level in m3
+%macro CURVE_NONE 0
+    mova             m4, m3
+%endmacro
+
+%macro CURVE_LINEAR 0
+    mulps            m4, m3, m14
+%endmacro
+
+%macro CURVE_CLIP 0
+    mulps            m4, m3, m14
+    xorps            m5, m5
+    maxps            m4, m5, m4
+    minps            m4, m12, m4
+%endmacro
+
+%macro CURVE_REINHARD 0
+    addps            m4, m3, m14
+    divps            m4, m3, m4
+    mulps            m4, m15
+%endmacro
+
+%macro CURVE_HABLE 0
+    mulps            m4, m3, m15            ; in * a
+    VBROADCASTSS     m6, [cq + 32]
+    addps            m5, m4, m6             ; in * a + b
+    VBROADCASTSS     m6, [cq + 24]
+    addps            m4, m6                 ; in * a + b * c
+    mulps            m4, m3
+    VBROADCASTSS     m6, [cq + 28]
+    addps            m4, m6                 ; + d * e
+    mulps            m5, m3
+    VBROADCASTSS     m6, [cq + 36]
+    addps            m5, m6                 ; + d * f
+    divps            m4, m5
+    VBROADCASTSS     m6, [cq + 40]
+    subps            m4, m6                 ; - e / f
+    divps            m4, m14                ; / hable(peak)
+%endmacro
+
+%macro CURVE_MOBIUS 0
+    addps            m4, m3, m15            ; in + a
+    VBROADCASTSS     m6, [cq + 28]
+    mulps            m4, m6
+    VBROADCASTSS     m6, [cq + 24]
+    addps            m5, m3, m6             ; in + b
+    divps            m4, m5
+    cmpps            m5, m3, m14, 2         ; in <= j
+    vblendvps        m4, m4, m3, m5
+%endmacro
+
+; %1 = curve, %2 = 1 for a full vector, 0 for a single pixel,
+; %3 = 1 to desaturate
+%macro TONEMAP_PIXELS 3
+    LOAD              0, src0, %2
+    LOAD              1, src1, %2
+    LOAD              2, src2, %2
+%if %3
+    mulps            m3, m0, m8
+    mulps            m4, m1, m9
+    addps            m3, m4
+    mulps            m4, m2, m10
+    addps            m3, m4                 ; luma
+    subps            m4, m3, m11
+    maxps            m4, m13
+    maxps            m5, m3, m13
+    divps            m4, m5                 ; overbright
+    subps            m5, m12, m4
+    mulps            m3, m4
+    MIX               0
+    MIX               1
+    MIX               2
+%endif
+    maxps            m3, m0, m1
+    maxps            m3, m2
+    maxps            m3, m13                ; sig
+    CURVE_%1
+    divps            m4, m3
+    mulps            m0, m4
+    mulps            m1, m4
+    mulps            m2, m4
+    STORE             0, dst0, %2
+    STORE             1, dst1, %2
+    STORE             2, dst2, %2
+%endmacro
+
+; %1 = curve, %2 = 1 to desaturate
+%macro TONEMAP_LOOP 2
+    cmp              xq, vecq
+    jge %%tail
+%%loop:
+    TONEMAP_PIXELS   %1, 1, %2
+    add              xq, mmsize / 4
+    cmp              xq, vecq
+    jl %%loop
+%%tail:
+    cmp              xq, widthq
+    jge %%end
+    TONEMAP_PIXELS   %1, 0, %2
+    inc              xq
+    jmp %%tail
+%%end:
+    RET
+%endmacro
+
+; %1 = function name, %2 = curve
+%macro TONEMAP 2
+cglobal tonemap_%1, 4, 10, 16, dst, src, width, c, dst1, dst2, src1, src2, x, vec
+    mov           dst1q, [dstq + gprsize]
+    mov           dst2q, [dstq + 2 * gprsize]
+    mov            dstq, [dstq]
+    mov           src1q, [srcq + gprsize]
+    mov           src2q, [srcq + 2 * gprsize]
+    mov            srcq, [srcq]
+    DEFINE_ARGS dst0, src0, width, c, dst1, dst2, src1, src2, x, vec
+    VBROADCASTSS     m8, [cq]               ; luma coefficients
+    VBROADCASTSS     m9, [cq + 4]
+    VBROADCASTSS    m10, [cq + 8]
+    VBROADCASTSS    m11, [cq + 12]          ; desat
+    mova            m12, [pf_1]
+    mova            m13, [pf_eps]
+    VBROADCASTSS    m14, [cq + 16]          ; curve parameters
+    VBROADCASTSS    m15, [cq + 20]
+    movsxdifnidn  widthq, widthd
+    mov            vecq, widthq
+    and            vecq, ~(mmsize / 4 - 1)
+    xor              xq, xq
+    xorps           xm0, xm0
+    comiss         xm11, xm0
+    ja .desat
+    TONEMAP_LOOP     %2, 0
+.desat:
+    TONEMAP_LOOP     %2, 1
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX_EXTERNAL
+INIT_YMM avx
+TONEMAP none,     NONE
+TONEMAP linear,   LINEAR
+TONEMAP clip,     CLIP
+TONEMAP reinhard, REINHARD
+TONEMAP hable,    HABLE
+TONEMAP mobius,   MOBIUS
+%endif
@@ -0,0 +1,52 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/tonemap.h"
+
+#define DECLARE_TONEMAP(name)                                                   \
+void ff_tonemap_##name##_avx(float *const dst[3], const float *const src[3],    \
+                             int width, const float *c);
+
+DECLARE_TONEMAP(none)
+DECLARE_TONEMAP(linear)
+DECLARE_TONEMAP(clip)
+DECLARE_TONEMAP(reinhard)
+DECLARE_TONEMAP(hable)
+DECLARE_TONEMAP(mobius)
+
+av_cold void ff_tonemap_init_dsp_x86(TonemapDSPContext *dsp, enum TonemapAlgorithm algo)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (!EXTERNAL_AVX_FAST(cpu_flags))
+        return;
+
+    switch (algo) {
+    case TONEMAP_NONE:     dsp->tonemap = ff_tonemap_none_avx;     break;
+    case TONEMAP_LINEAR:   dsp->tonemap = ff_tonemap_linear_avx;   break;
+    case TONEMAP_CLIP:     dsp->tonemap = ff_tonemap_clip_avx;     break;
+    case TONEMAP_REINHARD: dsp->tonemap = ff_tonemap_reinhard_avx; break;
+    case TONEMAP_HABLE:    dsp->tonemap = ff_tonemap_hable_avx;    break;
+    case TONEMAP_MOBIUS:   dsp->tonemap = ff_tonemap_mobius_avx;   break;
+    }
+#endif
+}
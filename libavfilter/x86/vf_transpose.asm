@@ -0,0 +1,314 @@
+;*****************************************************************************
+;* x86-optimized functions for transpose filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA
+
+; pack 4 pixels of 3 bytes out of 4 dwords, the second variant is used for
+; the last column where the dwords were loaded one byte earlier so that no
+; byte past the 8x8 block is read
+pb_pack24:      db 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+pb_pack24_last: db 1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1
+; pack 2 pixels of 6 bytes out of 2 qwords, same scheme as above
+pb_pack48:      db 0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1
+pb_pack48_last: db 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1
+
+SECTION .text
+
+; all functions transpose one 8x8 block of pixels:
+; dst[y * dst_linesize + x * step] = src[x * src_linesize + y * step]
+; both linesizes may be negative
+
+INIT_XMM sse2
+cglobal transpose_8x8_8, 4, 5, 8, src, src_linesize, dst, dst_linesize, linesize3
+    lea          linesize3q, [src_linesizeq * 3]
+    movq                 m0, [srcq]
+    movq                 m1, [srcq + src_linesizeq]
+    movq                 m2, [srcq + src_linesizeq * 2]
+    movq                 m3, [srcq + linesize3q]
+    lea                srcq, [srcq + src_linesizeq * 4]
+    movq                 m4, [srcq]
+    movq                 m5, [srcq + src_linesizeq]
+    movq                 m6, [srcq + src_linesizeq * 2]
+    movq                 m7, [srcq + linesize3q]
+    punpcklbw            m0, m1
+    punpcklbw            m2, m3
+    punpcklbw            m4, m5
+    punpcklbw            m6, m7
+    punpckhwd            m1, m0, m2             ; columns 4-7 of rows 0-3
+    punpcklwd            m0, m2                 ; columns 0-3 of rows 0-3
+    punpckhwd            m3, m4, m6             ; columns 4-7 of rows 4-7
+    punpcklwd            m4, m6                 ; columns 0-3 of rows 4-7
+    punpckhdq            m2, m0, m4             ; output rows 2-3
+    punpckldq            m0, m4                 ; output rows 0-1
+    punpckhdq            m5, m1, m3             ; output rows 6-7
+    punpckldq            m1, m3                 ; output rows 4-5
+    lea          linesize3q, [dst_linesizeq * 3]
+    movq             [dstq], m0
+    movhps [dstq + dst_linesizeq], m0
+    movq   [dstq + dst_linesizeq * 2], m2
+    movhps [dstq + linesize3q], m2
+    lea                dstq, [dstq + dst_linesizeq * 4]
+    movq             [dstq], m1
+    movhps [dstq + dst_linesizeq], m1
+    movq   [dstq + dst_linesizeq * 2], m5
+    movhps [dstq + linesize3q], m5
+    RET
+
+; transpose 4 rows of 8 words starting at srcq and store them as the left
+; (%1 = 0) or right (%1 = 8) half of the 8 output rows
+%macro TRANSPOSE_4x8W 1
+    movu                 m0, [srcq]
+    movu                 m1, [srcq + src_linesizeq]
+    movu                 m2, [srcq + src_linesizeq * 2]
+    movu                 m3, [srcq + linesize3q]
+    punpckhwd            m4, m0, m1
+    punpcklwd            m0, m1
+    punpckhwd            m5, m2, m3
+    punpcklwd            m2, m3
+    punpckhdq            m1, m0, m2             ; output rows 2-3
+    punpckldq            m0, m2                 ; output rows 0-1
+    punpckhdq            m3, m4, m5             ; output rows 6-7
+    punpckldq            m4, m5                 ; output rows 4-5
+    movq   [dstq + %1], m0
+    movhps [dstq + dst_linesizeq + %1], m0
+    movq   [dstq + dst_linesizeq * 2 + %1], m1
+    movhps [dstq + dst_linesize3q + %1], m1
+    movq   [dst4q + %1], m4
+    movhps [dst4q + dst_linesizeq + %1], m4
+    movq   [dst4q + dst_linesizeq * 2 + %1], m3
+    movhps [dst4q + dst_linesize3q + %1], m3
+%endmacro
+
+cglobal transpose_8x8_16, 4, 7, 6, src, src_linesize, dst, dst_linesize, linesize3, dst_linesize3, dst4
+    lea          linesize3q, [src_linesizeq * 3]
+    lea      dst_linesize3q, [dst_linesizeq * 3]
+    lea               dst4q, [dstq + dst_linesizeq * 4]
+    TRANSPOSE_4x8W 0
+    lea                srcq, [srcq + src_linesizeq * 4]
+    TRANSPOSE_4x8W 8
+    RET
+
+; transpose the 4x4 block of dwords at srcq + %1 and store it at %2 + %3
+%macro TRANSPOSE_4x4D 3
+    movu                 m0, [srcq + %1]
+    movu                 m1, [srcq + src_linesizeq + %1]
+    movu                 m2, [srcq + src_linesizeq * 2 + %1]
+    movu                 m3, [srcq + linesize3q + %1]
+    punpckhdq            m4, m0, m1
+    punpckldq            m0, m1
+    punpckhdq            m5, m2, m3
+    punpckldq            m2, m3
+    punpckhqdq           m1, m0, m2
+    punpcklqdq           m0, m2
+    punpckhqdq           m3, m4, m5
+    punpcklqdq           m4, m5
+    movu  [%2 + %3], m0
+    movu  [%2 + dst_linesizeq + %3], m1
+    movu  [%2 + dst_linesizeq * 2 + %3], m4
+    movu  [%2 + dst_linesize3q + %3], m3
+%endmacro
+
+cglobal transpose_8x8_32, 4, 7, 6, src, src_linesize, dst, dst_linesize, linesize3, dst_linesize3, dst4
+    lea          linesize3q, [src_linesizeq * 3]
+    lea      dst_linesize3q, [dst_linesizeq * 3]
+    lea               dst4q, [dstq + dst_linesizeq * 4]
+    TRANSPOSE_4x4D  0, dstq,   0
+    TRANSPOSE_4x4D 16, dst4q,  0
+    lea                srcq, [srcq + src_linesizeq * 4]
+    TRANSPOSE_4x4D  0, dstq,  16
+    TRANSPOSE_4x4D 16, dst4q, 16
+    RET
+
+; transpose the 2x2 block of qwords at srcq + %1 and store it at %2 and %3
+%macro TRANSPOSE_2x2Q 3
+    movu                 m0, [srcq + %1]
+    movu                 m1, [srcq + src_linesizeq + %1]
+    punpckhqdq           m2, m0, m1
+    punpcklqdq           m0, m1
+    movu               [%2], m0
+    movu               [%3], m2
+%endmacro
+
+cglobal transpose_8x8_64, 4, 7, 3, src, src_linesize, dst, dst_linesize, dst_linesize3, dst4, cnt
+    lea      dst_linesize3q, [dst_linesizeq * 3]
+    lea               dst4q, [dstq + dst_linesizeq * 4]
+    mov                cntd, 4
+.loop:
+    TRANSPOSE_2x2Q  0, dstq,                     dstq  + dst_linesizeq
+    TRANSPOSE_2x2Q 16, dstq  + dst_linesizeq * 2, dstq  + dst_linesize3q
+    TRANSPOSE_2x2Q 32, dst4q,                    dst4q + dst_linesizeq
+    TRANSPOSE_2x2Q 48, dst4q + dst_linesizeq * 2, dst4q + dst_linesize3q
+    lea                srcq, [srcq + src_linesizeq * 2]
+    add                dstq, 16
+    add               dst4q, 16
+    dec                cntd
+    jg .loop
+    RET
+
+; gather the 3-byte pixels of one output row out of the 8 input rows,
+; %1 = byte offset of the pixel column, %2 = packing shuffle
+%macro TRANSPOSE_ROW24 2
+    movd                 m0, [srcq + %1]
+    movd                 m1, [srcq + src_linesizeq + %1]
+    movd                 m2, [srcq + src_linesizeq * 2 + %1]
+    movd                 m3, [srcq + linesize3q + %1]
+    punpckldq            m0, m1
+    punpckldq            m2, m3
+    punpcklqdq           m0, m2
+    movd                 m1, [src4q + %1]
+    movd                 m2, [src4q + src_linesizeq + %1]
+    movd                 m3, [src4q + src_linesizeq * 2 + %1]
+    movd                 m4, [src4q + linesize3q + %1]
+    punpckldq            m1, m2
+    punpckldq            m3, m4
+    punpcklqdq           m1, m3
+    pshufb               m0, %2
+    pshufb               m1, %2
+    pslldq               m2, m1, 12
+    psrldq               m1, 4
+    por                  m0, m2
+    movu             [dstq], m0
+    movq        [dstq + 16], m1
+    add                dstq, dst_linesizeq
+%endmacro
+
+; gather the 6-byte pixels of one output row out of the 8 input rows,
+; %1 = byte offset of the pixel column, %2 = packing shuffle
+%macro TRANSPOSE_ROW48 2
+    movq                 m0, [srcq + %1]
+    movq                 m4, [srcq + src_linesizeq + %1]
+    movq                 m1, [srcq + src_linesizeq * 2 + %1]
+    movq                 m5, [srcq + linesize3q + %1]
+    punpcklqdq           m0, m4
+    punpcklqdq           m1, m5
+    movq                 m2, [src4q + %1]
+    movq                 m4, [src4q + src_linesizeq + %1]
+    movq                 m3, [src4q + src_linesizeq * 2 + %1]
+    movq                 m5, [src4q + linesize3q + %1]
+    punpcklqdq           m2, m4
+    punpcklqdq           m3, m5
+    pshufb               m0, %2
+    pshufb               m1, %2
+    pshufb               m2, %2
+    pshufb               m3, %2
+    pslldq               m4, m1, 12
+    psrldq               m1, 4
+    pslldq               m5, m2, 8
+    psrldq               m2, 8
+    pslldq               m3, 4
+    por                  m0, m4
+    por                  m1, m5
+    por                  m2, m3
+    movu             [dstq], m0
+    movu        [dstq + 16], m1
+    movu        [dstq + 32], m2
+    add                dstq, dst_linesizeq
+%endmacro
+
+; %1 = pixel size in bits
+%macro TRANSPOSE_8x8_PACKED 1
+cglobal transpose_8x8_%1, 4, 6, 8, src, src_linesize, dst, dst_linesize, linesize3, src4
+    lea          linesize3q, [src_linesizeq * 3]
+    lea               src4q, [srcq + src_linesizeq * 4]
+    mova                 m6, [pb_pack%1]
+    mova                 m7, [pb_pack%1_last]
+%assign i 0
+%rep 7
+    TRANSPOSE_ROW%1 i * %1 / 8, m6
+%assign i i+1
+%endrep
+    ; the last column is loaded early so that the loads stay in the block
+    TRANSPOSE_ROW%1 7 * %1 / 8 - %1 / 24, m7
+    RET
+%endmacro
+
+INIT_XMM ssse3
+TRANSPOSE_8x8_PACKED 24
+TRANSPOSE_8x8_PACKED 48
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+; transpose 4 rows of 8 dwords starting at srcq and store them as the left
+; (%1 = 0) or right (%1 = 16) half of the 8 output rows
+%macro TRANSPOSE_4x8D 1
+    movu                 m0, [srcq]
+    movu                 m1, [srcq + src_linesizeq]
+    movu                 m2, [srcq + src_linesizeq * 2]
+    movu                 m3, [srcq + linesize3q]
+    punpckhdq            m4, m0, m1
+    punpckldq            m0, m1
+    punpckhdq            m5, m2, m3
+    punpckldq            m2, m3
+    punpckhqdq           m1, m0, m2             ; output rows 1 and 5
+    punpcklqdq           m0, m2                 ; output rows 0 and 4
+    punpckhqdq           m3, m4, m5             ; output rows 3 and 7
+    punpcklqdq           m4, m5                 ; output rows 2 and 6
+    movu   [dstq + %1], xm0
+    movu   [dstq + dst_linesizeq + %1], xm1
+    movu   [dstq + dst_linesizeq * 2 + %1], xm4
+    movu   [dstq + dst_linesize3q + %1], xm3
+    vextracti128 [dst4q + %1], m0, 1
+    vextracti128 [dst4q + dst_linesizeq + %1], m1, 1
+    vextracti128 [dst4q + dst_linesizeq * 2 + %1], m4, 1
+    vextracti128 [dst4q + dst_linesize3q + %1], m3, 1
+%endmacro
+
+cglobal transpose_8x8_32, 4, 7, 6, src, src_linesize, dst, dst_linesize, linesize3, dst_linesize3, dst4
+    lea          linesize3q, [src_linesizeq * 3]
+    lea      dst_linesize3q, [dst_linesizeq * 3]
+    lea               dst4q, [dstq + dst_linesizeq * 4]
+    TRANSPOSE_4x8D 0
+    lea                srcq, [srcq + src_linesizeq * 4]
+    TRANSPOSE_4x8D 16
+    RET
+
+; transpose the 4x4 block of qwords at srcq + %1 and store it at %2 + %3
+%macro TRANSPOSE_4x4Q 3
+    movu                 m0, [srcq + %1]
+    movu                 m1, [srcq + src_linesizeq + %1]
+    movu                 m2, [srcq + src_linesizeq * 2 + %1]
+    movu                 m3, [srcq + linesize3q + %1]
+    punpckhqdq           m4, m0, m1
+    punpcklqdq           m0, m1
+    punpckhqdq           m5, m2, m3
+    punpcklqdq           m2, m3
+    vperm2i128           m1, m0, m2, 0x31
+    vperm2i128           m0, m0, m2, 0x20
+    vperm2i128           m3, m4, m5, 0x31
+    vperm2i128           m4, m4, m5, 0x20
+    movu  [%2 + %3], m0
+    movu  [%2 + dst_linesizeq + %3], m4
+    movu  [%2 + dst_linesizeq * 2 + %3], m1
+    movu  [%2 + dst_linesize3q + %3], m3
+%endmacro
+
+cglobal transpose_8x8_64, 4, 7, 6, src, src_linesize, dst, dst_linesize, linesize3, dst_linesize3, dst4
+    lea          linesize3q, [src_linesizeq * 3]
+    lea      dst_linesize3q, [dst_linesizeq * 3]
+    lea               dst4q, [dstq + dst_linesizeq * 4]
+    TRANSPOSE_4x4Q  0, dstq,   0
+    TRANSPOSE_4x4Q 32, dst4q,  0
+    lea                srcq, [srcq + src_linesizeq * 4]
+    TRANSPOSE_4x4Q  0, dstq,  32
+    TRANSPOSE_4x4Q 32, dst4q, 32
+    RET
+%endif
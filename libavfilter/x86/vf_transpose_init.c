@@ -0,0 +1,71 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/transpose.h"
+
+#define DECLARE_TRANSPOSE_8x8(bits, opt)                                    \
+void ff_transpose_8x8_##bits##_##opt(uint8_t *src, ptrdiff_t src_linesize, \
+                                     uint8_t *dst, ptrdiff_t dst_linesize);
+
+DECLARE_TRANSPOSE_8x8(8,  sse2)
+DECLARE_TRANSPOSE_8x8(16, sse2)
+DECLARE_TRANSPOSE_8x8(24, ssse3)
+DECLARE_TRANSPOSE_8x8(32, sse2)
+DECLARE_TRANSPOSE_8x8(32, avx2)
+DECLARE_TRANSPOSE_8x8(48, ssse3)
+DECLARE_TRANSPOSE_8x8(64, sse2)
+DECLARE_TRANSPOSE_8x8(64, avx2)
+
+av_cold void ff_transpose_init_x86(TransVtable *v, int pixstep)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    switch (pixstep) {
+    case 1:
+        if (EXTERNAL_SSE2(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_8_sse2;
+        break;
+    case 2:
+        if (EXTERNAL_SSE2(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_16_sse2;
+        break;
+    case 3:
+        if (EXTERNAL_SSSE3(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_24_ssse3;
+        break;
+    case 4:
+        if (EXTERNAL_SSE2(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_32_sse2;
+        if (EXTERNAL_AVX2_FAST(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_32_avx2;
+        break;
+    case 6:
+        if (EXTERNAL_SSSE3(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_48_ssse3;
+        break;
+    case 8:
+        if (EXTERNAL_SSE2(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_64_sse2;
+        if (EXTERNAL_AVX2_FAST(cpu_flags))
+            v->transpose_8x8 = ff_transpose_8x8_64_avx2;
+        break;
+    }
+}
@@ -40,7 +40,7 @@
 ERROR
 #endif
 
-void RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count){
+int RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end){
     int pos = s->dither.ns_pos;
     int i, j, ch;
     int taps  = s->dither.ns_taps;
@@ -50,7 +50,7 @@ void RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData
     av_assert2((taps&3) != 2);
     av_assert2((taps&3) != 3 || s->dither.ns_coeffs[taps] == 0);
 
-    for (ch=0; ch<srcs->ch_count; ch++) {
+    for (ch=ch_start; ch<ch_end; ch++) {
         const float *noise = ((const float *)noises->ch[ch]) + s->dither.noise_pos;
         const DELEM *src = (const DELEM*)srcs->ch[ch];
         DELEM *dst = (DELEM*)dsts->ch[ch];
@@ -76,7 +76,7 @@ void RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData
         }
     }
 
-    s->dither.ns_pos = pos;
+    return pos;
 }
 
 #undef RENAME
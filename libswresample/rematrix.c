@@ -422,6 +422,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
             s->mix_2_1_f = (mix_2_1_func_type*)sum2_clip_s16;
             s->mix_any_f = (mix_any_func_type*)get_mix_any_func_clip_s16(s);
         }
+        s->mix_n_1_f = (mix_n_1_func_type*)sumn_clip_s16;
     }else if(s->midbuf.fmt == AV_SAMPLE_FMT_FLTP){
         s->native_matrix = av_calloc(nb_in * nb_out, sizeof(float));
         s->native_one    = av_mallocz(sizeof(float));
@@ -434,6 +435,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->mix_1_1_f = (mix_1_1_func_type*)copy_float;
         s->mix_2_1_f = (mix_2_1_func_type*)sum2_float;
         s->mix_any_f = (mix_any_func_type*)get_mix_any_func_float(s);
+        s->mix_n_1_f = (mix_n_1_func_type*)sumn_float;
     }else if(s->midbuf.fmt == AV_SAMPLE_FMT_DBLP){
         s->native_matrix = av_calloc(nb_in * nb_out, sizeof(double));
         s->native_one    = av_mallocz(sizeof(double));
@@ -446,6 +448,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->mix_1_1_f = (mix_1_1_func_type*)copy_double;
         s->mix_2_1_f = (mix_2_1_func_type*)sum2_double;
         s->mix_any_f = (mix_any_func_type*)get_mix_any_func_double(s);
+        s->mix_n_1_f = (mix_n_1_func_type*)sumn_double;
     }else if(s->midbuf.fmt == AV_SAMPLE_FMT_S32P){
         s->native_one    = av_mallocz(sizeof(int));
         if (!s->native_one)
@@ -468,6 +471,7 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->mix_1_1_f = (mix_1_1_func_type*)copy_s32;
         s->mix_2_1_f = (mix_2_1_func_type*)sum2_s32;
         s->mix_any_f = (mix_any_func_type*)get_mix_any_func_s32(s);
+        s->mix_n_1_f = (mix_n_1_func_type*)sumn_s32;
     }else
         av_assert0(0);
     //FIXME quantize for integeres
@@ -481,6 +485,27 @@ av_cold int swri_rematrix_init(SwrContext *s){
         s->matrix_ch[i][0]= ch_in;
     }
 
+    /* compact rows of the nonzero coefficients for the mixes of 3 or more
+     * inputs, in the order of matrix_ch */
+    s->native_n_stride = nb_in * (s->midbuf.fmt == AV_SAMPLE_FMT_DBLP ? sizeof(double) : sizeof(int));
+    s->native_n_matrix = av_calloc(nb_out, s->native_n_stride);
+    if (!s->native_n_matrix)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < nb_out; i++) {
+        uint8_t *row = s->native_n_matrix + i * s->native_n_stride;
+
+        for (j = 0; j < s->matrix_ch[i][0]; j++) {
+            int in_i = s->matrix_ch[i][1 + j];
+
+            if (s->midbuf.fmt == AV_SAMPLE_FMT_FLTP)
+                ((float  *)row)[j] = s->matrix_flt[i][in_i];
+            else if (s->midbuf.fmt == AV_SAMPLE_FMT_DBLP)
+                ((double *)row)[j] = s->matrix[i][in_i];
+            else
+                ((int    *)row)[j] = s->matrix32[i][in_i];
+        }
+    }
+
     if(HAVE_X86ASM && HAVE_MMX)
         return swri_rematrix_init_x86(s);
 
@@ -492,27 +517,23 @@ av_cold void swri_rematrix_free(SwrContext *s){
     av_freep(&s->native_one);
     av_freep(&s->native_simd_matrix);
     av_freep(&s->native_simd_one);
+    av_freep(&s->native_n_matrix);
 }
 
-int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mustcopy){
-    int out_i, in_i, i, j;
-    int len1 = 0;
-    int off = 0;
+typedef struct RematrixThreadData {
+    AudioData *out, *in;
+    int len, len1, off;
+    int mustcopy;
+} RematrixThreadData;
 
-    if(s->mix_any_f) {
-        s->mix_any_f(out->ch, (const uint8_t **)in->ch, s->native_matrix, len);
-        return 0;
-    }
+static void rematrix_channels(SwrContext *s, void *arg, int jobnr, int ch_start, int ch_end){
+    RematrixThreadData *td = arg;
+    AudioData *out = td->out, *in = td->in;
+    int len = td->len, len1 = td->len1, off = td->off;
+    int mustcopy = td->mustcopy;
+    int out_i, in_i, j;
 
-    if(s->mix_2_1_simd || s->mix_1_1_simd){
-        len1= len&~15;
-        off = len1 * out->bps;
-    }
-
-    av_assert0(!s->out_ch_layout || out->ch_count == av_get_channel_layout_nb_channels(s->out_ch_layout));
-    av_assert0(!s-> in_ch_layout || in ->ch_count == av_get_channel_layout_nb_channels(s-> in_ch_layout));
-
-    for(out_i=0; out_i<out->ch_count; out_i++){
+    for(out_i=ch_start; out_i<ch_end; out_i++){
         switch(s->matrix_ch[out_i][0]){
         case 0:
             if(mustcopy)
@@ -541,36 +562,43 @@ int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mus
             if(len != len1)
                 s->mix_2_1_f   (out->ch[out_i]+off, in->ch[in_i1]+off, in->ch[in_i2]+off, s->native_matrix, in->ch_count*out_i + in_i1, in->ch_count*out_i + in_i2, len-len1);
             break;}
-        default:
-            if(s->int_sample_fmt == AV_SAMPLE_FMT_FLTP){
-                for(i=0; i<len; i++){
-                    float v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((float*)in->ch[in_i])[i] * s->matrix_flt[out_i][in_i];
-                    }
-                    ((float*)out->ch[out_i])[i]= v;
-                }
-            }else if(s->int_sample_fmt == AV_SAMPLE_FMT_DBLP){
-                for(i=0; i<len; i++){
-                    double v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((double*)in->ch[in_i])[i] * s->matrix[out_i][in_i];
-                    }
-                    ((double*)out->ch[out_i])[i]= v;
-                }
-            }else{
-                for(i=0; i<len; i++){
-                    int v=0;
-                    for(j=0; j<s->matrix_ch[out_i][0]; j++){
-                        in_i= s->matrix_ch[out_i][1+j];
-                        v+= ((int16_t*)in->ch[in_i])[i] * s->matrix32[out_i][in_i];
-                    }
-                    ((int16_t*)out->ch[out_i])[i]= (v + 16384)>>15;
-                }
+        default: {
+            const uint8_t *ins[SWR_CH_MAX];
+            uint8_t *coeffp = s->native_n_matrix + out_i * s->native_n_stride;
+            int n = s->matrix_ch[out_i][0];
+
+            for(j=0; j<n; j++)
+                ins[j]= in->ch[s->matrix_ch[out_i][1+j]];
+            if(s->mix_n_1_simd && len1)
+                s->mix_n_1_simd(out->ch[out_i]    , (const void **)ins, coeffp, n, len1);
+            else
+                s->mix_n_1_f   (out->ch[out_i]    , (const void **)ins, coeffp, n, len1);
+            if(len != len1){
+                for(j=0; j<n; j++)
+                    ins[j] += off;
+                s->mix_n_1_f   (out->ch[out_i]+off, (const void **)ins, coeffp, n, len-len1);
             }
+            break;}
         }
     }
+}
+
+int swri_rematrix(SwrContext *s, AudioData *out, AudioData *in, int len, int mustcopy){
+    RematrixThreadData td = { out, in, len, 0, 0, mustcopy };
+
+    if(s->mix_any_f) {
+        s->mix_any_f(out->ch, (const uint8_t **)in->ch, s->native_matrix, len);
+        return 0;
+    }
+
+    if(s->mix_2_1_simd || s->mix_1_1_simd || s->mix_n_1_simd){
+        td.len1= len&~15;
+        td.off = td.len1 * out->bps;
+    }
+
+    av_assert0(!s->out_ch_layout || out->ch_count == av_get_channel_layout_nb_channels(s->out_ch_layout));
+    av_assert0(!s-> in_ch_layout || in ->ch_count == av_get_channel_layout_nb_channels(s-> in_ch_layout));
+
+    swri_execute_channels(s, rematrix_channels, &td, out->ch_count);
     return 0;
 }
@@ -60,6 +60,20 @@ static void RENAME(sum2)(SAMPLE *out, const SAMPLE *in1, const SAMPLE *in2, COEF
         out[i] = R(coeff1*in1[i] + coeff2*in2[i]);
 }
 
+/* only the clipping variant of s16 is used for mixing n channels */
+#if !defined(TEMPLATE_REMATRIX_S16) || defined(TEMPLATE_CLIP)
+static void RENAME(sumn)(SAMPLE *out, const SAMPLE **in, COEFF *coeffp, integer n, integer len){
+    int i, j;
+
+    for(i=0; i<len; i++){
+        INTER v = 0;
+        for(j=0; j<n; j++)
+            v += in[j][i] * (INTER)coeffp[j];
+        out[i] = R(v);
+    }
+}
+#endif
+
 static void RENAME(copy)(SAMPLE *out, const SAMPLE *in, COEFF *coeffp, integer index, integer len){
     int i;
     INTER coeff = coeffp[index];
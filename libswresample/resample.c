@@ -344,7 +344,9 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
         c->linear        = linear;
         c->factor        = factor;
         c->filter_length = filter_length;
-        c->filter_alloc  = FFALIGN(c->filter_length, 8);
+        /* the SIMD loops read whole vectors of coefficients, 16 at a time
+         * for AVX2 int16, so the zero padding must cover them */
+        c->filter_alloc  = FFALIGN(c->filter_length, format == AV_SAMPLE_FMT_S16P ? 16 : 8);
         c->filter_bank   = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
         c->filter_type   = filter_type;
         c->kaiser_beta   = kaiser_beta;
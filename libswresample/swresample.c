@@ -21,6 +21,7 @@
 #include "libavutil/opt.h"
 #include "swresample_internal.h"
 #include "audioconvert.h"
+#include "resample.h"
 #include "libavutil/avassert.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/internal.h"
@@ -129,6 +130,9 @@ static void clear_context(SwrContext *s){
     swri_audio_convert_free(&s->out_convert);
     swri_audio_convert_free(&s->full_convert);
     swri_rematrix_free(s);
+    avpriv_slicethread_free(&s->slicethread);
+    av_freep(&s->resample_jobs);
+    s->nb_threads = 1;
 
     s->delayed_samples_fixup = 0;
     s->flushed = 0;
@@ -149,6 +153,62 @@ av_cold void swr_close(SwrContext *s){
     clear_context(s);
 }
 
+static void channel_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    SwrContext *s = priv;
+    int ch_start = s->channel_count *  jobnr      / nb_jobs;
+    int ch_end   = s->channel_count * (jobnr + 1) / nb_jobs;
+
+    s->channel_func(s, s->channel_arg, jobnr, ch_start, ch_end);
+}
+
+void swri_execute_channels(SwrContext *s, swri_channel_func *func, void *arg, int nb_channels)
+{
+    int nb_jobs = FFMIN(s->nb_threads, nb_channels);
+
+    if (nb_jobs < 2) {
+        func(s, arg, 0, 0, nb_channels);
+        return;
+    }
+
+    s->channel_func  = func;
+    s->channel_arg   = arg;
+    s->channel_count = nb_channels;
+    avpriv_slicethread_execute(s->slicethread, nb_jobs, 0);
+}
+
+static av_cold int init_threads(SwrContext *s)
+{
+    int nb_channels = FFMAX(s->used_ch_count, s->out.ch_count);
+    int ret;
+
+    if (s->threads == 1 || nb_channels < 2)
+        return 0;
+
+    ret = avpriv_slicethread_create(&s->slicethread, s, channel_worker, NULL, s->threads);
+    if (ret == AVERROR(ENOSYS)) {
+        av_log(s, AV_LOG_VERBOSE, "Threading is not supported, processing the channels serially\n");
+        return 0;
+    } else if (ret < 0) {
+        return ret;
+    } else if (ret < 2) {
+        avpriv_slicethread_free(&s->slicethread);
+        return 0;
+    }
+    s->nb_threads = FFMIN(ret, nb_channels);
+
+    /* the state of the swr resampler is shared by all the channels, so each
+     * job advances its own copy of it */
+    if (s->resample && s->resampler == &swri_resampler) {
+        s->resample_jobs = av_malloc_array(s->nb_threads, sizeof(*s->resample_jobs));
+        if (!s->resample_jobs)
+            return AVERROR(ENOMEM);
+    }
+
+    av_log(s, AV_LOG_DEBUG, "Using %d threads for %d channels\n", s->nb_threads, nb_channels);
+    return 0;
+}
+
 av_cold int swr_init(struct SwrContext *s){
     int ret;
     char l1[1024], l2[1024];
@@ -390,6 +450,9 @@ av_assert0(s->out.ch_count);
             goto fail;
     }
 
+    if ((ret = init_threads(s)) < 0)
+        goto fail;
+
     return 0;
 fail:
     swr_close(s);
@@ -480,6 +543,50 @@ static void buf_set(AudioData *out, AudioData *in, int count){
     }
 }
 
+typedef struct ResampleThreadData {
+    AudioData *out, *in;
+    int out_count, in_count;
+    int ret, consumed;
+} ResampleThreadData;
+
+static void channel_subset(AudioData *out, const AudioData *in, int ch_start, int ch_end){
+    int ch;
+
+    *out = *in;
+    out->ch_count = ch_end - ch_start;
+    for(ch=ch_start; ch<ch_end; ch++)
+        out->ch[ch - ch_start]= in->ch[ch];
+}
+
+static void resample_channels(SwrContext *s, void *arg, int jobnr, int ch_start, int ch_end){
+    ResampleThreadData *td = arg;
+    ResampleContext *c = &s->resample_jobs[jobnr];
+    AudioData out, in;
+    int ret, consumed;
+
+    *c = *s->resample;
+    channel_subset(&out, td->out, ch_start, ch_end);
+    channel_subset(&in , td->in , ch_start, ch_end);
+    ret = s->resampler->multiple_resample(c, &out, td->out_count, &in, td->in_count, &consumed);
+    if (!jobnr) {
+        td->ret      = ret;
+        td->consumed = consumed;
+    }
+}
+
+static int multiple_resample(SwrContext *s, AudioData *out, int out_count, AudioData *in, int in_count, int *consumed){
+    ResampleThreadData td = { out, in, out_count, in_count };
+
+    if (!s->resample_jobs)
+        return s->resampler->multiple_resample(s->resample, out, out_count, in, in_count, consumed);
+
+    swri_execute_channels(s, resample_channels, &td, out->ch_count);
+    /* all the copies advanced identically, keep the first one */
+    *s->resample = s->resample_jobs[0];
+    *consumed = td.consumed;
+    return td.ret;
+}
+
 /**
  *
  * @return number of samples output per channel
@@ -514,7 +621,7 @@ static int resample(SwrContext *s, AudioData *out_param, int out_count,
         int ret, size, consumed;
         if(!s->resample_in_constraint && s->in_buffer_count){
             buf_set(&tmp, &s->in_buffer, s->in_buffer_index);
-            ret= s->resampler->multiple_resample(s->resample, &out, out_count, &tmp, s->in_buffer_count, &consumed);
+            ret= multiple_resample(s, &out, out_count, &tmp, s->in_buffer_count, &consumed);
             out_count -= ret;
             ret_sum += ret;
             buf_set(&out, &out, ret);
@@ -534,7 +641,7 @@ static int resample(SwrContext *s, AudioData *out_param, int out_count,
 
         if((s->flushed || in_count > padless) && !s->in_buffer_count){
             s->in_buffer_index=0;
-            ret= s->resampler->multiple_resample(s->resample, &out, out_count, &in, FFMAX(in_count-padless, 0), &consumed);
+            ret= multiple_resample(s, &out, out_count, &in, FFMAX(in_count-padless, 0), &consumed);
             out_count -= ret;
             ret_sum += ret;
             buf_set(&out, &out, ret);
@@ -579,6 +686,46 @@ static int resample(SwrContext *s, AudioData *out_param, int out_count,
     return ret_sum;
 }
 
+typedef struct DitherThreadData {
+    AudioData *out, *in;
+    int count;
+    int ns_pos;
+} DitherThreadData;
+
+static void dither_channels(SwrContext *s, void *arg, int jobnr, int ch_start, int ch_end){
+    DitherThreadData *td = arg;
+    AudioData *out = td->out, *in = td->in;
+    const AudioData *noise = &s->dither.noise;
+    int count = td->count;
+    int ch, ns_pos;
+
+    if (s->dither.method < SWR_DITHER_NS){
+        int len1= s->mix_2_1_simd ? count&~15 : 0;
+        int off = len1 * in->bps;
+
+        for(ch=ch_start; ch<ch_end; ch++){
+            uint8_t *noise_ch = noise->ch[ch] + noise->bps * s->dither.noise_pos;
+
+            if(len1)
+                s->mix_2_1_simd(out->ch[ch], in->ch[ch], noise_ch, s->native_simd_one, 0, 0, len1);
+            if(count != len1)
+                s->mix_2_1_f(out->ch[ch] + off, in->ch[ch] + off, noise_ch + off, s->native_one, 0, 0, count - len1);
+        }
+        return;
+    }
+
+    switch(s->int_sample_fmt) {
+    case AV_SAMPLE_FMT_S16P :ns_pos = swri_noise_shaping_int16(s, out, in, noise, count, ch_start, ch_end); break;
+    case AV_SAMPLE_FMT_S32P :ns_pos = swri_noise_shaping_int32(s, out, in, noise, count, ch_start, ch_end); break;
+    case AV_SAMPLE_FMT_FLTP :ns_pos = swri_noise_shaping_float(s, out, in, noise, count, ch_start, ch_end); break;
+    case AV_SAMPLE_FMT_DBLP :ns_pos = swri_noise_shaping_double(s,out, in, noise, count, ch_start, ch_end); break;
+    default: return;
+    }
+    /* every channel ends at the same position, the first job reports it */
+    if (!jobnr)
+        td->ns_pos = ns_pos;
+}
+
 static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_count,
                                                       AudioData *in , int  in_count){
     AudioData *postin, *midbuf, *preout;
@@ -656,6 +803,7 @@ static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_co
     if(preout != out && out_count){
         AudioData *conv_src = preout;
         if(s->dither.method){
+            DitherThreadData td;
             int ch;
             int dither_count= FFMAX(out_count, 1<<16);
 
@@ -676,29 +824,12 @@ static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_co
             if(s->dither.noise_pos + out_count > s->dither.noise.count)
                 s->dither.noise_pos = 0;
 
-            if (s->dither.method < SWR_DITHER_NS){
-                if (s->mix_2_1_simd) {
-                    int len1= out_count&~15;
-                    int off = len1 * preout->bps;
-
-                    if(len1)
-                        for(ch=0; ch<preout->ch_count; ch++)
-                            s->mix_2_1_simd(conv_src->ch[ch], preout->ch[ch], s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos, s->native_simd_one, 0, 0, len1);
-                    if(out_count != len1)
-                        for(ch=0; ch<preout->ch_count; ch++)
-                            s->mix_2_1_f(conv_src->ch[ch] + off, preout->ch[ch] + off, s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos + off, s->native_one, 0, 0, out_count - len1);
-                } else {
-                    for(ch=0; ch<preout->ch_count; ch++)
-                        s->mix_2_1_f(conv_src->ch[ch], preout->ch[ch], s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos, s->native_one, 0, 0, out_count);
-                }
-            } else {
-                switch(s->int_sample_fmt) {
-                case AV_SAMPLE_FMT_S16P :swri_noise_shaping_int16(s, conv_src, preout, &s->dither.noise, out_count); break;
-                case AV_SAMPLE_FMT_S32P :swri_noise_shaping_int32(s, conv_src, preout, &s->dither.noise, out_count); break;
-                case AV_SAMPLE_FMT_FLTP :swri_noise_shaping_float(s, conv_src, preout, &s->dither.noise, out_count); break;
-                case AV_SAMPLE_FMT_DBLP :swri_noise_shaping_double(s,conv_src, preout, &s->dither.noise, out_count); break;
-                }
-            }
+            td.out   = conv_src;
+            td.in    = preout;
+            td.count = out_count;
+            td.ns_pos= s->dither.ns_pos;
+            swri_execute_channels(s, dither_channels, &td, preout->ch_count);
+            s->dither.ns_pos = td.ns_pos;
             s->dither.noise_pos += out_count;
         }
 //FIXME packed doesn't need more than 1 chan here!
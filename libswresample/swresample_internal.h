@@ -23,6 +23,7 @@
 
 #include "swresample.h"
 #include "libavutil/channel_layout.h"
+#include "libavutil/slicethread.h"
 #include "config.h"
 
 #define SWR_CH_MAX 64
@@ -41,6 +42,7 @@ typedef void (mix_1_1_func_type)(void *out, const void *in, void *coeffp, intege
 typedef void (mix_2_1_func_type)(void *out, const void *in1, const void *in2, void *coeffp, integer index1, integer index2, integer len);
 
 typedef void (mix_any_func_type)(uint8_t **out, const uint8_t **in1, void *coeffp, integer len);
+typedef void (mix_n_1_func_type)(void *out, const void **in, void *coeffp, integer n, integer len);
 
 typedef struct AudioData{
     uint8_t *ch[SWR_CH_MAX];    ///< samples buffer per channel
@@ -92,6 +94,11 @@ struct Resampler {
 extern struct Resampler const swri_resampler;
 extern struct Resampler const swri_soxr_resampler;
 
+/**
+ * Process the channels [ch_start, ch_end) of a job, see swri_execute_channels().
+ */
+typedef void (swri_channel_func)(struct SwrContext *s, void *arg, int jobnr, int ch_start, int ch_end);
+
 struct SwrContext {
     const AVClass *av_class;                        ///< AVClass used for AVOption and av_log()
     int log_level_offset;                           ///< logging level offset
@@ -184,16 +191,40 @@ struct SwrContext {
 
     mix_any_func_type *mix_any_f;
 
+    mix_n_1_func_type *mix_n_1_f;
+    mix_n_1_func_type *mix_n_1_simd;
+    uint8_t *native_n_matrix;                       ///< per output channel, the coefficients of the inputs listed in matrix_ch
+    int native_n_stride;                            ///< size in bytes of a native_n_matrix row
+
+    int threads;                                    ///< number of threads the channels are distributed to, 0 for automatic
+    AVSliceThread *slicethread;                     ///< channel threading context, NULL when processing serially
+    int nb_threads;                                 ///< number of threads of slicethread
+    swri_channel_func *channel_func;                ///< function executed by the channel jobs
+    void *channel_arg;                              ///< argument of channel_func
+    int channel_count;                              ///< number of channels split among the jobs
+    struct ResampleContext *resample_jobs;          ///< per job copies of the resampling context
+
     /* TODO: callbacks for ASM optimizations */
 };
 
 av_warn_unused_result
 int swri_realloc_audio(AudioData *a, int count);
 
-void swri_noise_shaping_int16 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
-void swri_noise_shaping_int32 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
-void swri_noise_shaping_float (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
-void swri_noise_shaping_double(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
+/**
+ * Run func over all the channels, split in contiguous ranges processed in
+ * parallel when the context has threads, or in a single call otherwise.
+ */
+void swri_execute_channels(SwrContext *s, swri_channel_func *func, void *arg, int nb_channels);
+
+/**
+ * Apply noise shaping dither to the channels [ch_start, ch_end).
+ * @return the noise shaping position after count samples, to be stored in
+ *         s->dither.ns_pos once all the channels are processed
+ */
+int swri_noise_shaping_int16 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
+int swri_noise_shaping_int32 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
+int swri_noise_shaping_float (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
+int swri_noise_shaping_double(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
 
 av_warn_unused_result
 int swri_rematrix_init(SwrContext *s);
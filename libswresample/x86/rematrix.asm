@@ -24,6 +24,7 @@
 SECTION_RODATA 32
 dw1: times 8  dd 1
 w1 : times 16 dw 1
+dw16384: times 8 dd 16384
 
 SECTION .text
 
@@ -222,6 +223,106 @@ mix_2_1_int16_u_int %+ SUFFIX:
 %endif
 %endmacro
 
+%if ARCH_X86_64
+; void mix_n_1_float(float *out, const float **in, const float *coeffp,
+;                    integer n, integer len)
+; out = sum of in[j] * coeffp[j] for j < n, accumulated in the order of j
+%macro MIXN_FLT 0
+cglobal mix_n_1_float, 5, 8, 4, out, in, coeffp, n, len, j, src, pos
+    shl        lenq, 2
+    xor        posq, posq
+.next:
+    xorps        m0, m0
+    xorps        m1, m1
+    xor          jq, jq
+.tap:
+    mov        srcq, [inq + jq*gprsize]
+    VBROADCASTSS m3, [coeffpq + 4*jq]
+    movu         m2, [srcq + posq         ]
+    mulps        m2, m3
+    addps        m0, m2
+    movu         m2, [srcq + posq + mmsize]
+    mulps        m2, m3
+    addps        m1, m2
+    inc          jq
+    cmp          jq, nq
+        jl .tap
+    movu  [outq + posq         ], m0
+    movu  [outq + posq + mmsize], m1
+    add        posq, mmsize*2
+    cmp        posq, lenq
+        jl .next
+    REP_RET
+%endmacro
+
+; void mix_n_1_int16(int16_t *out, const int16_t **in, const int *coeffp,
+;                    integer n, integer len)
+; 32 bit products and sums like the C version, saturated to 16 bits
+%macro MIXN_INT16 0
+cglobal mix_n_1_int16, 5, 8, 7, out, in, coeffp, n, len, j, src, pos
+    add        lenq, lenq
+    xor        posq, posq
+    mova         m6, [dw16384]
+.next:
+    pxor         m0, m0
+    pxor         m1, m1
+%if mmsize == 16
+    pxor         m2, m2
+    pxor         m3, m3
+%endif
+    xor          jq, jq
+.tap:
+    mov        srcq, [inq + jq*gprsize]
+%if cpuflag(avx2)
+    vpbroadcastd m5, [coeffpq + 4*jq]
+    pmovsxwd     m4, [srcq + posq     ]
+    pmulld       m4, m5
+    paddd        m0, m4
+    pmovsxwd     m4, [srcq + posq + 16]
+    pmulld       m4, m5
+    paddd        m1, m4
+%else
+    movd         m5, [coeffpq + 4*jq]
+    pshufd       m5, m5, 0
+    pmovsxwd     m4, [srcq + posq     ]
+    pmulld       m4, m5
+    paddd        m0, m4
+    pmovsxwd     m4, [srcq + posq +  8]
+    pmulld       m4, m5
+    paddd        m1, m4
+    pmovsxwd     m4, [srcq + posq + 16]
+    pmulld       m4, m5
+    paddd        m2, m4
+    pmovsxwd     m4, [srcq + posq + 24]
+    pmulld       m4, m5
+    paddd        m3, m4
+%endif
+    inc          jq
+    cmp          jq, nq
+        jl .tap
+    paddd        m0, m6
+    paddd        m1, m6
+    psrad        m0, 15
+    psrad        m1, 15
+    packssdw     m0, m1
+%if mmsize == 32
+    vpermq       m0, m0, q3120
+    movu  [outq + posq     ], m0
+%else
+    paddd        m2, m6
+    paddd        m3, m6
+    psrad        m2, 15
+    psrad        m3, 15
+    packssdw     m2, m3
+    movu  [outq + posq     ], m0
+    movu  [outq + posq + 16], m2
+%endif
+    add        posq, 32
+    cmp        posq, lenq
+        jl .next
+    REP_RET
+%endmacro
+%endif ; ARCH_X86_64
 
 INIT_MMX mmx
 MIX1_INT16 u
@@ -248,3 +349,18 @@ MIX2_FLT a
 MIX1_FLT u
 MIX1_FLT a
 %endif
+
+%if ARCH_X86_64
+INIT_XMM sse
+MIXN_FLT
+INIT_XMM sse4
+MIXN_INT16
+%if HAVE_AVX_EXTERNAL
+INIT_YMM avx
+MIXN_FLT
+%endif
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+MIXN_INT16
+%endif
+%endif
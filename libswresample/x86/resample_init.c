@@ -37,6 +37,8 @@ int ff_resample_linear_##type##_##opt(ResampleContext *c, void *dst, \
 RESAMPLE_FUNCS(int16,  mmxext);
 RESAMPLE_FUNCS(int16,  sse2);
 RESAMPLE_FUNCS(int16,  xop);
+RESAMPLE_FUNCS(int16,  avx2);
+RESAMPLE_FUNCS(int32,  avx2);
 RESAMPLE_FUNCS(float,  sse);
 RESAMPLE_FUNCS(float,  avx);
 RESAMPLE_FUNCS(float,  fma3);
@@ -63,6 +65,16 @@ av_cold void swri_resample_dsp_x86_init(ResampleContext *c)
             c->dsp.resample_linear = ff_resample_linear_int16_xop;
             c->dsp.resample_common = ff_resample_common_int16_xop;
         }
+        if (EXTERNAL_AVX2_FAST(mm_flags)) {
+            c->dsp.resample_linear = ff_resample_linear_int16_avx2;
+            c->dsp.resample_common = ff_resample_common_int16_avx2;
+        }
+        break;
+    case AV_SAMPLE_FMT_S32P:
+        if (ARCH_X86_64 && EXTERNAL_AVX2_FAST(mm_flags)) {
+            c->dsp.resample_linear = ff_resample_linear_int32_avx2;
+            c->dsp.resample_common = ff_resample_common_int32_avx2;
+        }
         break;
     case AV_SAMPLE_FMT_FLTP:
         if (EXTERNAL_SSE(mm_flags)) {
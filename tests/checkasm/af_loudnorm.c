@@ -0,0 +1,96 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/ebur128.h"
+#include "libavutil/mem.h"
+
+#define LANES  FF_EBUR128_LANES
+#define FRAMES 64
+
+/* the K-weighting filter of ebur128.c, for the lanes of interleaved samples */
+static void filter_lanes_c(double *dst, const double *src, double *v,
+                           const double *c, int frames)
+{
+    int i, l;
+
+    for (i = 0; i < frames; i++) {
+        for (l = 0; l < LANES; l++) {
+            double *s = v + l;
+            double v0 = src[i * LANES + l]
+                      - c[5] * s[0]
+                      - c[6] * s[LANES]
+                      - c[7] * s[2 * LANES]
+                      - c[8] * s[3 * LANES];
+            dst[i * LANES + l] = c[0] * v0
+                               + c[1] * s[0]
+                               + c[2] * s[LANES]
+                               + c[3] * s[2 * LANES]
+                               + c[4] * s[3 * LANES];
+            s[3 * LANES] = s[2 * LANES];
+            s[2 * LANES] = s[LANES];
+            s[LANES]     = s[0];
+            s[0]         = v0;
+        }
+    }
+}
+
+void checkasm_check_af_loudnorm(void)
+{
+    LOCAL_ALIGNED_32(double, src,  [FRAMES * LANES]);
+    LOCAL_ALIGNED_32(double, dst0, [FRAMES * LANES]);
+    LOCAL_ALIGNED_32(double, dst1, [FRAMES * LANES]);
+    LOCAL_ALIGNED_32(double, v0,   [4 * LANES]);
+    LOCAL_ALIGNED_32(double, v1,   [4 * LANES]);
+    /* the pre-filter and the RLB filter combined at 48kHz */
+    static const double c[9] = {
+         1.53512485958697, -5.76194590858032, 8.11691004925258,
+        -5.08848181111208,  1.19839281085285,
+        -3.68070674801639,  5.08704524797113, -3.13154635144673,
+         0.72520888847787,
+    };
+    FFEBUR128DSPContext dsp = { filter_lanes_c };
+    int i, frames;
+
+    declare_func(void, double *dst, const double *src, double *v,
+                       const double *c, int frames);
+
+    if (ARCH_X86)
+        ff_ebur128_init_dsp_x86(&dsp);
+
+    if (check_func(dsp.filter_lanes, "ebur128_filter_lanes")) {
+        for (frames = 0; frames <= FRAMES; frames += frames < 4 ? 1 : 20) {
+            for (i = 0; i < FRAMES * LANES; i++)
+                src[i] = (rnd() % 65536 - 32768) / 32768.0;
+            for (i = 0; i < 4 * LANES; i++)
+                v0[i] = v1[i] = (rnd() % 65536 - 32768) / 4096.0;
+            memset(dst0, 0, FRAMES * LANES * sizeof(*dst0));
+            memset(dst1, 0, FRAMES * LANES * sizeof(*dst1));
+
+            call_ref(dst0, src, v0, c, frames);
+            call_new(dst1, src, v1, c, frames);
+            /* the same operations are done in the same order */
+            if (memcmp(dst0, dst1, FRAMES * LANES * sizeof(*dst0)) ||
+                memcmp(v0, v1, 4 * LANES * sizeof(*v0)))
+                fail();
+        }
+        bench_new(dst1, src, v1, c, FRAMES);
+    }
+    report("filter_lanes");
+}
@@ -156,24 +156,55 @@ static const struct {
     #if CONFIG_AFIR_FILTER
         { "af_afir", checkasm_check_afir },
     #endif
+    #if CONFIG_LOUDNORM_FILTER
+        { "af_loudnorm", checkasm_check_af_loudnorm },
+    #endif
     #if CONFIG_BLEND_FILTER
         { "vf_blend", checkasm_check_blend },
     #endif
+    #if CONFIG_BOXBLUR_FILTER
+        { "vf_boxblur", checkasm_check_vf_boxblur },
+    #endif
     #if CONFIG_COLORSPACE_FILTER
         { "vf_colorspace", checkasm_check_colorspace },
     #endif
+    #if CONFIG_CONVOLUTION_FILTER
+        { "vf_convolution", checkasm_check_vf_convolution },
+    #endif
+    #if CONFIG_EBUR128_FILTER
+        { "f_ebur128", checkasm_check_f_ebur128 },
+    #endif
     #if CONFIG_GBLUR_FILTER
         { "vf_gblur", checkasm_check_vf_gblur },
     #endif
     #if CONFIG_HFLIP_FILTER
         { "vf_hflip", checkasm_check_vf_hflip },
     #endif
+    #if CONFIG_LUT3D_FILTER
+        { "vf_lut3d", checkasm_check_vf_lut3d },
+    #endif
     #if CONFIG_NLMEANS_FILTER
         { "vf_nlmeans", checkasm_check_nlmeans },
     #endif
+    #if CONFIG_NNEDI_FILTER
+        { "vf_nnedi", checkasm_check_vf_nnedi },
+    #endif
+    #if CONFIG_PALETTEUSE_FILTER
+        { "vf_paletteuse", checkasm_check_vf_paletteuse },
+    #endif
     #if CONFIG_THRESHOLD_FILTER
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
+    #if CONFIG_TONEMAP_FILTER
+        { "vf_tonemap", checkasm_check_vf_tonemap },
+    #endif
+    #if CONFIG_TRANSPOSE_FILTER
+        { "vf_transpose", checkasm_check_vf_transpose },
+    #endif
+#endif
+#if CONFIG_SWRESAMPLE
+    { "sw_rematrix", checkasm_check_sw_rematrix },
+    { "sw_resample", checkasm_check_sw_resample },
 #endif
 #if CONFIG_SWSCALE
     { "sw_rgb", checkasm_check_sw_rgb },
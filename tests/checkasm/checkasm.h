@@ -41,6 +41,7 @@
 
 void checkasm_check_aacpsdsp(void);
 void checkasm_check_afir(void);
+void checkasm_check_af_loudnorm(void);
 void checkasm_check_alacdsp(void);
 void checkasm_check_audiodsp(void);
 void checkasm_check_blend(void);
@@ -48,6 +49,7 @@ void checkasm_check_blockdsp(void);
 void checkasm_check_bswapdsp(void);
 void checkasm_check_colorspace(void);
 void checkasm_check_exrdsp(void);
+void checkasm_check_f_ebur128(void);
 void checkasm_check_fixed_dsp(void);
 void checkasm_check_flacdsp(void);
 void checkasm_check_float_dsp(void);
@@ -67,13 +69,22 @@ void checkasm_check_nlmeans(void);
 void checkasm_check_pixblockdsp(void);
 void checkasm_check_sbrdsp(void);
 void checkasm_check_synth_filter(void);
+void checkasm_check_sw_rematrix(void);
+void checkasm_check_sw_resample(void);
 void checkasm_check_sw_rgb(void);
 void checkasm_check_utvideodsp(void);
 void checkasm_check_v210dec(void);
 void checkasm_check_v210enc(void);
+void checkasm_check_vf_boxblur(void);
+void checkasm_check_vf_convolution(void);
 void checkasm_check_vf_gblur(void);
 void checkasm_check_vf_hflip(void);
+void checkasm_check_vf_lut3d(void);
+void checkasm_check_vf_nnedi(void);
+void checkasm_check_vf_paletteuse(void);
 void checkasm_check_vf_threshold(void);
+void checkasm_check_vf_tonemap(void);
+void checkasm_check_vf_transpose(void);
 void checkasm_check_vp8dsp(void);
 void checkasm_check_vp9dsp(void);
 void checkasm_check_videodsp(void);
@@ -0,0 +1,57 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/truepeak.h"
+#include "libavutil/mem.h"
+
+/* the taps of each phase of the 4 times oversampling interpolator */
+#define PHASE_TAPS 13
+#define MAX_LEN    67
+
+void checkasm_check_f_ebur128(void)
+{
+    LOCAL_ALIGNED_32(double, coeffs, [PHASE_TAPS * 4]);
+    LOCAL_ALIGNED_32(double, x,      [MAX_LEN + PHASE_TAPS - 1]);
+    FFTruePeakDSPContext dsp;
+    int i, len;
+
+    declare_func_float(double, const double *coeffs, const double *x,
+                       int nb_samples, int phase_taps);
+
+    ff_truepeak_init_dsp(&dsp);
+
+    if (check_func(dsp.interpolate_peak4, "truepeak_interpolate_peak4")) {
+        for (len = 1; len <= MAX_LEN; len += len < 8 ? 1 : 59) {
+            double peak_ref, peak_new;
+
+            for (i = 0; i < PHASE_TAPS * 4; i++)
+                coeffs[i] = (rnd() % 2000) / 1000.0 - 1.0;
+            for (i = 0; i < len + PHASE_TAPS - 1; i++)
+                x[i] = (rnd() % 65536 - 32768) / 32768.0;
+
+            peak_ref = call_ref(coeffs, x, len, PHASE_TAPS);
+            peak_new = call_new(coeffs, x, len, PHASE_TAPS);
+            /* the sums are done in the same order */
+            if (peak_ref != peak_new)
+                fail();
+        }
+        bench_new(coeffs, x, MAX_LEN, PHASE_TAPS);
+    }
+    report("interpolate_peak4");
+}
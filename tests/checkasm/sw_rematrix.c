@@ -0,0 +1,134 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+
+#include "libswresample/swresample_internal.h"
+
+#include "checkasm.h"
+
+#define LEN 256
+
+static const struct {
+    uint64_t in, out;
+    const char *name;
+} layouts[] = {
+    { AV_CH_LAYOUT_7POINT1,      AV_CH_LAYOUT_STEREO, "7.1_stereo"      },
+    { AV_CH_LAYOUT_7POINT1_WIDE, AV_CH_LAYOUT_STEREO, "7.1wide_stereo"  },
+    { AV_CH_LAYOUT_6POINT1,      AV_CH_LAYOUT_STEREO, "6.1_stereo"      },
+    { AV_CH_LAYOUT_5POINT1,      AV_CH_LAYOUT_STEREO, "5.1_stereo"      },
+    { AV_CH_LAYOUT_5POINT1,      AV_CH_LAYOUT_MONO,   "5.1_mono"        },
+    { AV_CH_LAYOUT_7POINT1,      AV_CH_LAYOUT_MONO,   "7.1_mono"        },
+    { AV_CH_LAYOUT_7POINT1,      AV_CH_LAYOUT_QUAD,   "7.1_quad_custom" },
+};
+
+/* a sparse matrix with zero coefficients in between the used inputs */
+static const double custom_matrix[4 * 8] = {
+    0.5, 0.0, 0.25, 0.0, 0.25, 0.0,  0.0,  0.0,
+    0.0, 0.5, 0.25, 0.0, 0.0,  0.25, 0.0,  0.0,
+    0.3, 0.0, 0.0,  0.2, 0.0,  0.0,  0.5,  0.0,
+    0.0, 0.3, 0.0,  0.2, 0.0,  0.0,  0.0,  0.5,
+};
+
+static void randomize_buffer(uint8_t *buf, enum AVSampleFormat fmt)
+{
+    int i;
+
+    /* keep the 32 bit sums of the int16 path from overflowing */
+    if (fmt == AV_SAMPLE_FMT_S16P) {
+        for (i = 0; i < LEN; i++)
+            AV_WN16A(buf + 2 * i, (int16_t)rnd() >> 3);
+    } else {
+        for (i = 0; i < LEN; i++)
+            ((float *)buf)[i] = (int32_t)rnd() / (float)INT32_MAX;
+    }
+}
+
+static void check_mix_n_1(enum AVSampleFormat fmt, const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [8], [LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [LEN * 4]);
+    int bps = av_get_bytes_per_sample(fmt);
+    int i, j, out_i;
+
+    declare_func(void, void *out, const void **in, void *coeffp, integer n, integer len);
+
+    for (i = 0; i < 8; i++)
+        randomize_buffer(src[i], fmt);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(layouts); i++) {
+        struct SwrContext *s = swr_alloc_set_opts(NULL, layouts[i].out, fmt, 48000,
+                                                  layouts[i].in, fmt, 48000, 0, NULL);
+
+        if (!s) {
+            fail();
+            continue;
+        }
+        av_opt_set_sample_fmt(s, "internal_sample_fmt", fmt, 0);
+        if (layouts[i].out == AV_CH_LAYOUT_QUAD &&
+            swr_set_matrix(s, custom_matrix, 8) < 0) {
+            fail();
+            swr_free(&s);
+            continue;
+        }
+        if (swr_init(s) < 0) {
+            fail();
+            swr_free(&s);
+            continue;
+        }
+
+        for (out_i = 0; out_i < s->out.ch_count; out_i++) {
+            const uint8_t *ins[SWR_CH_MAX];
+            uint8_t *coeffp = s->native_n_matrix + out_i * s->native_n_stride;
+            int n = s->matrix_ch[out_i][0];
+
+            if (n < 3)
+                continue;
+            for (j = 0; j < n; j++)
+                ins[j] = src[s->matrix_ch[out_i][1 + j]];
+
+            if (check_func(s->mix_n_1_simd ? s->mix_n_1_simd : s->mix_n_1_f,
+                           "mix_n_1_%s_%s_%d", name, layouts[i].name, out_i)) {
+                memset(dst0, 0, LEN * bps);
+                memset(dst1, 0, LEN * bps);
+                call_ref(dst0, (const void **)ins, coeffp, n, LEN);
+                call_new(dst1, (const void **)ins, coeffp, n, LEN);
+                if (memcmp(dst0, dst1, LEN * bps))
+                    fail();
+                bench_new(dst1, (const void **)ins, coeffp, n, LEN);
+            }
+        }
+        swr_free(&s);
+    }
+}
+
+void checkasm_check_sw_rematrix(void)
+{
+    check_mix_n_1(AV_SAMPLE_FMT_FLTP, "float");
+    report("mix_n_1_float");
+
+    check_mix_n_1(AV_SAMPLE_FMT_S16P, "int16");
+    report("mix_n_1_int16");
+}
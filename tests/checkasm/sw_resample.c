@@ -0,0 +1,106 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#include "libswresample/resample.h"
+
+#include "checkasm.h"
+
+#define SRC_LEN 2048
+#define DST_LEN 256
+
+static const struct { int in, out; } rates[] = {
+    { 44100, 48000 }, { 48000, 44100 }, { 48000, 16000 },
+};
+
+static void randomize_buffer(uint8_t *buf, enum AVSampleFormat fmt)
+{
+    int i;
+
+    /* keep some headroom so that the clipping is exercised but not saturated */
+    if (fmt == AV_SAMPLE_FMT_S16P) {
+        for (i = 0; i < SRC_LEN; i++)
+            AV_WN16A(buf + 2 * i, (int16_t)rnd() >> 1);
+    } else {
+        for (i = 0; i < SRC_LEN; i++)
+            AV_WN32A(buf + 4 * i, (int32_t)rnd() >> 1);
+    }
+}
+
+static void check_resample(enum AVSampleFormat fmt, const char *name, int linear)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [SRC_LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_LEN * 4]);
+    int bps = av_get_bytes_per_sample(fmt);
+    int i;
+
+    declare_func(int, ResampleContext *c, void *dst, const void *src, int n, int update_ctx);
+
+    randomize_buffer(src, fmt);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(rates); i++) {
+        ResampleContext *c = swri_resampler.init(NULL, rates[i].out, rates[i].in, 32, 10, linear,
+                                                 0.97, fmt, SWR_FILTER_TYPE_KAISER, 9, 20, 0, 1);
+        void *func;
+        int index, frac, ret0, ret1;
+
+        if (!c) {
+            fail();
+            continue;
+        }
+        func = linear ? (void *)c->dsp.resample_linear : (void *)c->dsp.resample_common;
+
+        if (check_func(func, "resample_%s_%s_%d_%d", linear ? "linear" : "common",
+                       name, rates[i].in, rates[i].out)) {
+            memset(dst0, 0, DST_LEN * bps);
+            memset(dst1, 0, DST_LEN * bps);
+
+            /* the initial index of the context is negative, which only
+             * multiple_resample() copes with */
+            index = c->index = rnd() % c->phase_count;
+            frac  = c->frac  = rnd() % c->src_incr;
+            ret0  = call_ref(c, dst0, src, DST_LEN, 1);
+            FFSWAP(int, index, c->index);
+            FFSWAP(int, frac,  c->frac);
+            ret1  = call_new(c, dst1, src, DST_LEN, 1);
+            if (ret0 != ret1 || index != c->index || frac != c->frac ||
+                memcmp(dst0, dst1, DST_LEN * bps))
+                fail();
+
+            bench_new(c, dst1, src, DST_LEN, 0);
+        }
+        swri_resampler.free(&c);
+    }
+}
+
+void checkasm_check_sw_resample(void)
+{
+    check_resample(AV_SAMPLE_FMT_S16P, "int16", 0);
+    check_resample(AV_SAMPLE_FMT_S16P, "int16", 1);
+    report("int16");
+
+    check_resample(AV_SAMPLE_FMT_S32P, "int32", 0);
+    check_resample(AV_SAMPLE_FMT_S32P, "int32", 1);
+    report("int32");
+}
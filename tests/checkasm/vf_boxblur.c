@@ -0,0 +1,78 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/boxblur.h"
+#include "libavutil/mem.h"
+
+/* at most the width of a column tile, not a multiple of the vector size
+ * to cover the scalar tail */
+#define WIDTH 61
+
+/* the pixels and the sums are kept small enough for the sums not to
+ * overflow in the C code */
+#define CHECK_BLUR_ROW(type, depth, mask)                                       \
+    do {                                                                        \
+        LOCAL_ALIGNED_32(type, add,     [WIDTH]);                               \
+        LOCAL_ALIGNED_32(type, sub,     [WIDTH]);                               \
+        LOCAL_ALIGNED_32(type, dst_ref, [WIDTH]);                               \
+        LOCAL_ALIGNED_32(type, dst_new, [WIDTH]);                               \
+        LOCAL_ALIGNED_32(int,  sum_ref, [WIDTH]);                               \
+        LOCAL_ALIGNED_32(int,  sum_new, [WIDTH]);                               \
+        const int radius = 1 + rnd() % 20;                                      \
+        const int length = radius * 2 + 1;                                      \
+        const int inv = ((1 << 16) + length / 2) / length;                      \
+        int w, x;                                                               \
+                                                                                \
+        declare_func(void, type *dst, const type *add, const type *sub,        \
+                     int *sum, int inv, int w);                                 \
+                                                                                \
+        if (check_func(dsp.blur_row ## depth, "blur_row%d", depth)) {          \
+            for (w = 1; w <= WIDTH; w += w < 16 ? 1 : 15) {                     \
+                for (x = 0; x < WIDTH; x++) {                                   \
+                    add[x] = rnd() & mask;                                      \
+                    sub[x] = rnd() & mask;                                      \
+                    sum_ref[x] = ((rnd() & mask) << 16) + (1 << 15);            \
+                }                                                               \
+                memcpy(sum_new, sum_ref, WIDTH * sizeof(*sum_ref));             \
+                memset(dst_ref, 0, WIDTH * sizeof(*dst_ref));                   \
+                memset(dst_new, 0, WIDTH * sizeof(*dst_new));                   \
+                                                                                \
+                call_ref(dst_ref, add, sub, sum_ref, inv, w);                   \
+                call_new(dst_new, add, sub, sum_new, inv, w);                   \
+                if (memcmp(dst_ref, dst_new, WIDTH * sizeof(*dst_ref)) ||       \
+                    memcmp(sum_ref, sum_new, WIDTH * sizeof(*sum_ref)))         \
+                    fail();                                                     \
+            }                                                                   \
+            bench_new(dst_new, add, sub, sum_new, inv, WIDTH);                  \
+        }                                                                       \
+    } while (0)
+
+void checkasm_check_vf_boxblur(void)
+{
+    BoxBlurDSPContext dsp;
+
+    ff_boxblur_init_dsp(&dsp);
+
+    CHECK_BLUR_ROW(uint8_t,   8, 0xff);
+    report("blur_row8");
+
+    CHECK_BLUR_ROW(uint16_t, 16, 0x3fff);
+    report("blur_row16");
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/convolution.h"
+#include "libavutil/intreadwrite.h"
+
+#define WIDTH (64 + 5)
+#define LINESIZE (WIDTH * 2 + 32)
+#define NB_TAPS 49
+
+static void check_filter(enum ConvolutionType type, int mode, int size, int depth,
+                         const char *report_name)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [NB_TAPS * LINESIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [LINESIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [LINESIZE]);
+    const int peak = (1 << depth) - 1;
+    const int radius = size / 2;
+    const uint8_t *c[NB_TAPS];
+    ConvolutionContext s = { 0 };
+    float rdiv, bias;
+    int i, sum = 0;
+
+    declare_func(void, uint8_t *dst, int width,
+                       float rdiv, float bias, const int *const matrix,
+                       const uint8_t *c[], int peak, int radius,
+                       int dstride, int stride);
+
+    for (i = 0; i < NB_TAPS * LINESIZE / 2; i++) {
+        if (depth > 8)
+            AV_WN16A(src + 2 * i, rnd() & peak);
+        else
+            AV_WN16A(src + 2 * i, rnd());
+    }
+    for (i = 0; i < NB_TAPS; i++) {
+        s.matrix[0][i] = (int)(rnd() % 17) - 8;
+        sum += s.matrix[0][i];
+        c[i] = src + i * LINESIZE;
+    }
+    rdiv = type == CONVOLUTION_MATRIX ? 1.f / (sum ? sum : 1) : 0.5f + (rnd() & 7) / 4.f;
+    bias = rnd() & 15;
+
+    s.mode[0] = mode;
+    s.size[0] = size;
+    ff_convolution_init(&s, type, depth);
+
+    if (check_func(s.filter[0], "%s_%d", report_name, depth)) {
+        for (i = 1; i <= WIDTH; i++) {
+            memset(dst_ref, 0, LINESIZE);
+            memset(dst_new, 0, LINESIZE);
+            call_ref(dst_ref, i, rdiv, bias, s.matrix[0], c, peak, radius, 0, LINESIZE);
+            call_new(dst_new, i, rdiv, bias, s.matrix[0], c, peak, radius, 0, LINESIZE);
+            if (memcmp(dst_ref, dst_new, LINESIZE))
+                fail();
+        }
+        bench_new(dst_new, WIDTH, rdiv, bias, s.matrix[0], c, peak, radius, 0, LINESIZE);
+    }
+}
+
+void checkasm_check_vf_convolution(void)
+{
+    static const int depths[] = { 8, 10, 16 };
+    /* the 16-bit edge operators overflow the sum of squares */
+    static const int edge_depths[] = { 8, 10, 12 };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(depths); i++) {
+        check_filter(CONVOLUTION_MATRIX, MATRIX_SQUARE, 3, depths[i], "filter_3x3");
+        check_filter(CONVOLUTION_MATRIX, MATRIX_SQUARE, 5, depths[i], "filter_5x5");
+        check_filter(CONVOLUTION_MATRIX, MATRIX_SQUARE, 7, depths[i], "filter_7x7");
+        check_filter(CONVOLUTION_MATRIX, MATRIX_ROW,    9, depths[i], "filter_row");
+    }
+    report("convolution");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(edge_depths); i++) {
+        check_filter(CONVOLUTION_PREWITT, MATRIX_SQUARE, 3, edge_depths[i], "filter_prewitt");
+        check_filter(CONVOLUTION_ROBERTS, MATRIX_SQUARE, 3, edge_depths[i], "filter_roberts");
+        check_filter(CONVOLUTION_SOBEL,   MATRIX_SQUARE, 3, edge_depths[i], "filter_sobel");
+    }
+    report("edge");
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/lut3d.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#define WIDTH    128
+#define LUTSIZE  33
+
+static void check_interp_row(const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL],
+                             int interpolation, const char *name, int depth)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,     [3], [WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [3], [WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [3], [WIDTH]);
+    uint8_t *const dst0[3] = { (uint8_t *)dst_ref[0], (uint8_t *)dst_ref[1], (uint8_t *)dst_ref[2] };
+    uint8_t *const dst1[3] = { (uint8_t *)dst_new[0], (uint8_t *)dst_new[1], (uint8_t *)dst_new[2] };
+    const uint8_t *const srcp[3] = { (uint8_t *)src[0], (uint8_t *)src[1], (uint8_t *)src[2] };
+    const int nbits = depth > 8 ? 16 : 8;
+    const int max = (1 << depth) - 1;
+    const float scale[4] = { (1.f / max) * (LUTSIZE - 1),
+                             (1.f / max) * (LUTSIZE - 1),
+                             (1.f / max) * (LUTSIZE - 1),
+                             max };
+    LUT3DDSPContext dsp;
+    int c, x;
+
+    declare_func(void, uint8_t *const dst[3], const uint8_t *const src[3], int width,
+                       const struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL], int lutsize,
+                       const float *scale);
+
+    ff_lut3d_init_dsp(&dsp, interpolation, nbits);
+
+    if (check_func(dsp.interp_row, "interp_row_%s_%d", name, depth)) {
+        for (x = 0; x < WIDTH; x++) {
+            int v[3];
+            v[0] = rnd() & max;
+            /* exercise the ties between the fractional parts too */
+            v[1] = x & 1 ? v[0] : rnd() & max;
+            v[2] = rnd() & max;
+            /* the maximum values hit the last point of the lut */
+            if (x == WIDTH - 1)
+                v[0] = v[1] = v[2] = max;
+            for (c = 0; c < 3; c++) {
+                if (nbits == 8)
+                    ((uint8_t *)src[c])[x] = v[c];
+                else
+                    AV_WN16A(&src[c][x], v[c]);
+            }
+        }
+
+        memset(dst_ref, 0, 3 * WIDTH * sizeof(uint16_t));
+        memset(dst_new, 0, 3 * WIDTH * sizeof(uint16_t));
+        call_ref(dst0, srcp, WIDTH, lut, LUTSIZE, scale);
+        call_new(dst1, srcp, WIDTH, lut, LUTSIZE, scale);
+        if (memcmp(dst_ref, dst_new, 3 * WIDTH * sizeof(uint16_t)))
+            fail();
+        bench_new(dst1, srcp, WIDTH, lut, LUTSIZE, scale);
+    }
+}
+
+void checkasm_check_vf_lut3d(void)
+{
+    static const int depths[] = { 8, 10, 16 };
+    struct rgbvec (*lut)[MAX_LEVEL][MAX_LEVEL];
+    int i, r, g, b;
+
+    lut = av_malloc_array(LUTSIZE, sizeof(*lut));
+    if (!lut) {
+        fail();
+        return;
+    }
+
+    for (r = 0; r < LUTSIZE; r++) {
+        for (g = 0; g < LUTSIZE; g++) {
+            for (b = 0; b < LUTSIZE; b++) {
+                /* slightly out of the [0,1] range to cover the clipping */
+                lut[r][g][b].r = (rnd() % 12000) / 10000.f - 0.1f;
+                lut[r][g][b].g = (rnd() % 12000) / 10000.f - 0.1f;
+                lut[r][g][b].b = (rnd() % 12000) / 10000.f - 0.1f;
+            }
+        }
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(depths); i++)
+        check_interp_row((const void *)lut, INTERPOLATE_TRILINEAR, "trilinear", depths[i]);
+    report("interp_trilinear");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(depths); i++)
+        check_interp_row((const void *)lut, INTERPOLATE_TETRAHEDRAL, "tetrahedral", depths[i]);
+    report("interp_tetrahedral");
+
+    av_free(lut);
+}
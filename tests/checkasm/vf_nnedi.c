@@ -0,0 +1,111 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/vf_nnedidsp.h"
+#include "libavutil/mem.h"
+
+#define MAX_N   64
+#define MAX_LEN 768
+
+/* the filter only uses these functions when len is a multiple of 16 */
+static const struct { int n, len; } sizes[] = {
+    { 4, 48 }, { 16, 48 }, { 32, 96 }, { 64, 768 },
+};
+
+static void check_dot_prod(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, data,    [MAX_LEN]);
+    LOCAL_ALIGNED_32(float, weights, [MAX_N * (MAX_LEN + 1)]);
+    LOCAL_ALIGNED_32(float, vals0,   [MAX_N]);
+    LOCAL_ALIGNED_32(float, vals1,   [MAX_N]);
+    const float scale = 0.75f;
+    int i, k;
+
+    declare_func(void, const float *data, const float *weights, float *vals,
+                       int n, int len, const float *scale);
+
+    for (k = 0; k < FF_ARRAY_ELEMS(sizes); k++) {
+        const int n = sizes[k].n, len = sizes[k].len;
+
+        if (!check_func(dsp->dot_prod, "nnedi_dot_prod_%dx%d", n, len))
+            continue;
+
+        for (i = 0; i < len; i++)
+            data[i] = (rnd() % 2000) / 1000.f - 1.f;
+        for (i = 0; i < n * (len + 1); i++)
+            weights[i] = (rnd() % 2000) / 1000.f - 1.f;
+
+        call_ref(data, weights, vals0, n, len, &scale);
+        call_new(data, weights, vals1, n, len, &scale);
+        /* the simd versions sum in a different order */
+        if (!float_near_abs_eps_array(vals0, vals1, 1e-3f, n))
+            fail();
+        bench_new(data, weights, vals1, n, len, &scale);
+    }
+}
+
+static void check_dot_prods(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(int16_t, data,    [MAX_LEN]);
+    LOCAL_ALIGNED_32(int16_t, weights, [MAX_N * (MAX_LEN + 4)]);
+    LOCAL_ALIGNED_32(float,   vals0,   [MAX_N]);
+    LOCAL_ALIGNED_32(float,   vals1,   [MAX_N]);
+    const float scale = 0.75f;
+    int i, k;
+
+    declare_func(void, const int16_t *data, const int16_t *weights, float *vals,
+                       int n, int len, const float *scale);
+
+    for (k = 0; k < FF_ARRAY_ELEMS(sizes); k++) {
+        const int n = sizes[k].n, len = sizes[k].len;
+        float *wf = (float *)&weights[n * len];
+
+        if (!check_func(dsp->dot_prods, "nnedi_dot_prods_%dx%d", n, len))
+            continue;
+
+        /* keep the 32 bit sums of the longest rows from overflowing */
+        for (i = 0; i < len; i++)
+            data[i] = (int16_t)(rnd() % 511) - 255;
+        for (i = 0; i < n * len; i++)
+            weights[i] = (int16_t)rnd() >> 4;
+        for (i = 0; i < 2 * n; i++)
+            wf[i] = (rnd() % 2000) / 1000.f - 1.f;
+
+        call_ref(data, weights, vals0, n, len, &scale);
+        call_new(data, weights, vals1, n, len, &scale);
+        /* the integer sums are exact, the scaling is done in the same order */
+        if (memcmp(vals0, vals1, n * sizeof(*vals0)))
+            fail();
+        bench_new(data, weights, vals1, n, len, &scale);
+    }
+}
+
+void checkasm_check_vf_nnedi(void)
+{
+    NNEDIDSPContext dsp;
+
+    ff_nnedi_init(&dsp);
+
+    check_dot_prod(&dsp);
+    report("dot_prod");
+
+    check_dot_prods(&dsp);
+    report("dot_prods");
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/vf_paletteusedsp.h"
+#include "libavutil/mem.h"
+
+#define PALETTE_SIZE 256
+
+static void fill_palette(uint32_t *rgb, uint32_t *keys, int skip)
+{
+    int i;
+
+    for (i = 0; i < PALETTE_SIZE; i++) {
+        rgb[i]  = rnd() & 0xffffff;
+        keys[i] = i;
+        if (skip && !(rnd() & 7))
+            keys[i] |= PALETTEUSE_KEY_SKIP;
+    }
+}
+
+/* place entries at the same distance around the target, in shuffled slots,
+ * so the search has to settle ties on the lowest index */
+static void add_equidistant(uint32_t *rgb, uint32_t color)
+{
+    static const int offsets[][3] = {
+        { 3, 0, 0 }, { -3, 0, 0 }, { 0, 3, 0 }, { 0, -3, 0 },
+        { 0, 0, 3 }, { 0, 0, -3 }, { 0, 0, 0 }, { 0, 0, 0 },
+    };
+    const int r = color >> 16 & 0xff, g = color >> 8 & 0xff, b = color & 0xff;
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(offsets); i++)
+        rgb[rnd() % PALETTE_SIZE] = av_clip_uint8(r + offsets[i][0]) << 16 |
+                                    av_clip_uint8(g + offsets[i][1]) <<  8 |
+                                    av_clip_uint8(b + offsets[i][2]);
+}
+
+static void check_nearest_key(const PaletteUseDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint32_t, rgb,  [PALETTE_SIZE]);
+    LOCAL_ALIGNED_32(uint32_t, keys, [PALETTE_SIZE]);
+    int i, k;
+
+    declare_func(unsigned, const uint32_t *rgb, const uint32_t *keys, uint32_t color);
+
+    if (!check_func(dsp->nearest_key, "paletteuse_nearest_key"))
+        return;
+
+    for (k = 0; k < 4; k++) {
+        fill_palette(rgb, keys, k & 1);
+
+        for (i = 0; i < 64; i++) {
+            const uint32_t color = rnd() & 0xffffff;
+
+            if (k & 2)
+                add_equidistant(rgb, color);
+            if (call_ref(rgb, keys, color) != call_new(rgb, keys, color))
+                fail();
+        }
+    }
+
+    /* every entry skipped */
+    for (i = 0; i < PALETTE_SIZE; i++)
+        keys[i] = PALETTEUSE_KEY_SKIP | i;
+    if (call_ref(rgb, keys, 0x808080) != call_new(rgb, keys, 0x808080))
+        fail();
+
+    bench_new(rgb, keys, rnd() & 0xffffff);
+}
+
+void checkasm_check_vf_paletteuse(void)
+{
+    PaletteUseDSPContext dsp;
+
+    ff_paletteuse_init(&dsp);
+
+    check_nearest_key(&dsp);
+    report("nearest_key");
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/tonemap.h"
+#include "libavutil/mem.h"
+
+/* not a multiple of the vector size, to cover the scalar tail */
+#define WIDTH 67
+
+static void check_tonemap(enum TonemapAlgorithm algo, const char *name,
+                          double param, int desat)
+{
+    LOCAL_ALIGNED_32(float, src,     [3], [WIDTH]);
+    LOCAL_ALIGNED_32(float, dst_ref, [3], [WIDTH]);
+    LOCAL_ALIGNED_32(float, dst_new, [3], [WIDTH]);
+    float *const dst0[3] = { dst_ref[0], dst_ref[1], dst_ref[2] };
+    float *const dst1[3] = { dst_new[0], dst_new[1], dst_new[2] };
+    const float *const srcp[3] = { src[0], src[1], src[2] };
+    static const double luma[3] = { 0.2126, 0.0722, 0.7152 };
+    const double peak = 10.0;
+    float c[TONEMAP_NB_CONSTS];
+    TonemapDSPContext dsp;
+    int i, x;
+
+    declare_func(void, float *const dst[3], const float *const src[3], int width,
+                       const float *c);
+
+    ff_tonemap_init_dsp(&dsp, algo);
+    ff_tonemap_init_consts(c, algo, luma, desat ? 0.5 : 0, param, peak);
+
+    if (check_func(dsp.tonemap, "tonemap_%s%s", name, desat ? "_desat" : "")) {
+        for (i = 0; i < 3; i++)
+            for (x = 0; x < WIDTH; x++)
+                src[i][x] = (rnd() % 100000) / 100000.f * peak;
+        /* black pixels hit the lower bound of the signal level */
+        src[0][0] = src[1][0] = src[2][0] = 0.f;
+
+        memset(dst_ref, 0, 3 * WIDTH * sizeof(float));
+        memset(dst_new, 0, 3 * WIDTH * sizeof(float));
+        call_ref(dst0, srcp, WIDTH, c);
+        call_new(dst1, srcp, WIDTH, c);
+        for (i = 0; i < 3; i++)
+            if (!float_near_ulp_array(dst_ref[i], dst_new[i], 1, WIDTH))
+                fail();
+        bench_new(dst1, srcp, WIDTH, c);
+    }
+}
+
+void checkasm_check_vf_tonemap(void)
+{
+    static const struct {
+        enum TonemapAlgorithm algo;
+        const char *name;
+        double param;
+    } tests[] = {
+        { TONEMAP_NONE,     "none",     1.0 },
+        { TONEMAP_LINEAR,   "linear",   1.0 },
+        { TONEMAP_GAMMA,    "gamma",    1.8 },
+        { TONEMAP_CLIP,     "clip",     1.0 },
+        { TONEMAP_REINHARD, "reinhard", 0.5 },
+        { TONEMAP_HABLE,    "hable",    1.0 },
+        { TONEMAP_MOBIUS,   "mobius",   0.3 },
+    };
+    int i, desat;
+
+    for (desat = 0; desat < 2; desat++)
+        for (i = 0; i < FF_ARRAY_ELEMS(tests); i++)
+            check_tonemap(tests[i].algo, tests[i].name, tests[i].param, desat);
+    report("tonemap");
+}
@@ -0,0 +1,78 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/transpose.h"
+
+#define LINESIZE (8 * 8 + 32)
+#define BUF_SIZE (8 * LINESIZE)
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        uint8_t *tmp_buf = (uint8_t *)buf;\
+        for (j = 0; j < size; j++)        \
+            tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+static void check_transpose(int step)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [BUF_SIZE]);
+    TransVtable v;
+    int flip;
+
+    declare_func(void, uint8_t *src, ptrdiff_t src_linesize,
+                       uint8_t *dst, ptrdiff_t dst_linesize);
+
+    ff_transpose_init(&v, step);
+
+    if (check_func(v.transpose_8x8, "transpose_8x8_%d", step * 8)) {
+        /* exercise all combinations of positive and negative linesizes,
+         * as used by the different transposition directions */
+        for (flip = 0; flip < 4; flip++) {
+            ptrdiff_t src_linesize = flip & 1 ? -LINESIZE : LINESIZE;
+            ptrdiff_t dst_linesize = flip & 2 ? -LINESIZE : LINESIZE;
+            uint8_t *s  = flip & 1 ? src     + 7 * LINESIZE : src;
+            uint8_t *d0 = flip & 2 ? dst_ref + 7 * LINESIZE : dst_ref;
+            uint8_t *d1 = flip & 2 ? dst_new + 7 * LINESIZE : dst_new;
+
+            randomize_buffers(src, BUF_SIZE);
+            memset(dst_ref, 0, BUF_SIZE);
+            memset(dst_new, 0, BUF_SIZE);
+
+            call_ref(s, src_linesize, d0, dst_linesize);
+            call_new(s, src_linesize, d1, dst_linesize);
+            if (memcmp(dst_ref, dst_new, BUF_SIZE))
+                fail();
+        }
+        bench_new(src, LINESIZE, dst_new, LINESIZE);
+    }
+}
+
+void checkasm_check_vf_transpose(void)
+{
+    static const int steps[] = { 1, 2, 3, 4, 6, 8 };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(steps); i++)
+        check_transpose(steps[i]);
+    report("transpose_8x8");
+}
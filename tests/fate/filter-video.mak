@@ -83,6 +83,12 @@ fate-filter-testsrc2-rgb24: CMD = framecrc -lavfi testsrc2=r=7:d=10 -pix_fmt rgb
 FATE_FILTER-$(call ALLYES, LAVFI_INDEV TESTSRC2_FILTER) += fate-filter-testsrc2-rgba
 fate-filter-testsrc2-rgba: CMD = framecrc -lavfi testsrc2=r=7:d=10 -pix_fmt rgba
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER REVERSE_FILTER) += fate-filter-reverse-max-memory
+fate-filter-reverse-max-memory: CMD = framecrc -lavfi testsrc2=r=7:d=2,reverse=max_memory=100000 -pix_fmt yuv420p
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER LOOP_FILTER) += fate-filter-loop-max-memory
+fate-filter-loop-max-memory: CMD = framecrc -lavfi testsrc2=r=7:d=2,loop=loop=2:size=5:start=3:max_memory=100000 -pix_fmt yuv420p
+
 FATE_FILTER-$(call ALLYES, LAVFI_INDEV ALLRGB_FILTER) += fate-filter-allrgb
 fate-filter-allrgb: CMD = framecrc -lavfi allrgb=rate=5:duration=1 -pix_fmt rgb24
 
@@ -122,6 +128,16 @@ FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER FORMAT_FILTER) += fa
 fate-filter-framerate-12bit-up: CMD = framecrc -lavfi testsrc2=r=50:d=1,format=pix_fmts=yuv422p12le,framerate=fps=60 -t 1 -pix_fmt yuv422p12le
 fate-filter-framerate-12bit-down: CMD = framecrc -lavfi testsrc2=r=60:d=1,format=pix_fmts=yuv422p12le,framerate=fps=50 -t 1 -pix_fmt yuv422p12le
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER PALETTEGEN_FILTER PALETTEUSE_FILTER) += fate-filter-paletteuse-bayer0
+fate-filter-paletteuse-bayer0: CMD = framecrc -lavfi "testsrc2=s=320x240:d=1,split[a][b];[a]palettegen[p];[b][p]paletteuse=bayer:bayer_scale=0" -pix_fmt bgra
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER PALETTEGEN_FILTER PALETTEUSE_FILTER) += fate-filter-paletteuse-bruteforce
+fate-filter-paletteuse-bruteforce: CMD = framecrc -lavfi "testsrc2=s=320x240:d=1,split[a][b];[a]palettegen=max_colors=64[p];[b][p]paletteuse=sierra2_4a:color_search=bruteforce" -pix_fmt bgra
+
+FATE_FILTER-$(call ALLYES, MINTERPOLATE_FILTER TESTSRC2_FILTER) += fate-filter-minterpolate-up fate-filter-minterpolate-down
+fate-filter-minterpolate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=10 -t 1
+fate-filter-minterpolate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=1 -t 1
+
 FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
@@ -752,6 +768,11 @@ FATE_METADATA_FILTER-$(call ALLYES, $(EBUR128_METADATA_DEPS)) += fate-filter-met
 fate-filter-metadata-ebur128: SRC = $(TARGET_SAMPLES)/filter/seq-3341-7_seq-3342-5-24bit.flac
 fate-filter-metadata-ebur128: CMD = run $(FILTER_METADATA_COMMAND) "amovie='$(SRC)',ebur128=metadata=1"
 
+# tones peaking between the samples, so that the true peaks exceed the sample peaks
+EBUR128_TRUEPEAK_DEPS = FFPROBE AVDEVICE LAVFI_INDEV AEVALSRC_FILTER EBUR128_FILTER
+FATE_METADATA_FILTER_NOSAMPLES-$(call ALLYES, $(EBUR128_TRUEPEAK_DEPS)) += fate-filter-metadata-ebur128-truepeak
+fate-filter-metadata-ebur128-truepeak: CMD = run $(FILTER_METADATA_COMMAND) "aevalsrc=0.5*sin(2*PI*12000*t+PI/4)|0.25*sin(2*PI*1000*t)+0.2*sin(2*PI*11025*t):s=48000:d=1,ebur128=metadata=1:peak=sample+true"
+
 READVITC_METADATA_DEPS = FFPROBE LAVFI_INDEV MOVIE_FILTER AVCODEC AVDEVICE \
                          AVI_DEMUXER FFVHUFF_DECODER READVITC_FILTER
 FATE_METADATA_FILTER-$(call ALLYES, $(READVITC_METADATA_DEPS)) += fate-filter-metadata-readvitc-def
@@ -793,10 +814,27 @@ fate-filter-refcmp-ssim-rgb: CMD = refcmp_metadata ssim rgb24 0.015
 FATE_FILTER_SAMPLES-$(call ALLYES, $(REFCMP_DEPS) SSIM_FILTER) += fate-filter-refcmp-ssim-yuv
 fate-filter-refcmp-ssim-yuv: CMD = refcmp_metadata ssim yuv422p 0.015
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER ALIASFORMAT_FILTER) += fate-filter-aliasformat
+fate-filter-aliasformat: CMD = framecrc -lavfi testsrc2=r=7:d=2,format=nv12,aliasformat=src=nv12:dst=gray
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER ALIASFORMAT_FILTER SCALE_FILTER) += fate-filter-alias-formats
+fate-filter-alias-formats: libavfilter/tests/aliasformat$(EXESUF)
+fate-filter-alias-formats: CMD = run libavfilter/tests/aliasformat$(EXESUF)
+
+FATE_FILTER-yes += fate-filter-batchframes
+fate-filter-batchframes: libavfilter/tests/batchframes$(EXESUF)
+fate-filter-batchframes: CMD = run libavfilter/tests/batchframes$(EXESUF)
+
+FATE_FILTER-$(CONFIG_DNN) += fate-filter-dnn-native
+fate-filter-dnn-native: libavfilter/tests/dnn_native$(EXESUF)
+fate-filter-dnn-native: CMD = run libavfilter/tests/dnn_native$(EXESUF)
+fate-filter-dnn-native: CMP = null
+
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
+FATE_FFPROBE += $(FATE_METADATA_FILTER_NOSAMPLES-yes)
 FATE_SAMPLES_FFMPEG += $(FATE_FILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_FILTER-yes)
 
 fate-vfilter: $(FATE_FILTER-yes) $(FATE_FILTER_SAMPLES-yes) $(FATE_FILTER_VSYNTH-yes)
 
-fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes)
+fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes) $(FATE_METADATA_FILTER_NOSAMPLES-yes)
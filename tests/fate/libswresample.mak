@@ -1094,5 +1094,12 @@ fate-swr-audioconvert: CMP = stddev
 fate-swr-audioconvert: FUZZ = 0
 
 FATE_SWR += $(FATE_SWR_AUDIOCONVERT-yes)
+
+# the output must not depend on the number of threads
+FATE_SWR_THREADS-$(call FILTERDEMDECENCMUX, ARESAMPLE AFORMAT, WAV, PCM_S16LE, PCM_S16LE, FRAMECRC) += fate-swr-threads
+fate-swr-threads: tests/data/asynth-44100-2.wav
+fate-swr-threads: CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af "aresample=48000:ocl=5.1:internal_sample_fmt=fltp:dither_method=shibata:threads=4,aformat=s16" -c:a pcm_s16le
+
+FATE_SWR += $(FATE_SWR_THREADS-yes)
 FATE_FFMPEG += $(FATE_SWR)
 fate-swr: $(FATE_SWR)
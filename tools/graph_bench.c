@@ -0,0 +1,215 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Benchmark the configuration of large synthetic filter graphs: a mosaic
+ * of video inputs, each going through a chain of filters, stacked with
+ * xstack, and as many audio inputs mixed with amix.
+ */
+
+#include "config.h"
+#if HAVE_UNISTD_H
+#include <unistd.h>             /* getopt */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/bprint.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+static void usage(void)
+{
+    printf("Benchmark the configuration of large filter graphs.\n");
+    printf("Usage: graph_bench [OPTIONS]\n");
+    printf("\n"
+           "Options:\n"
+           "-n INPUTS         number of inputs of the mosaic, 64 if omitted\n"
+           "-c LENGTH         number of filters on each input, 8 if omitted\n"
+           "-r RUNS           number of times the graph is configured, 10 if omitted\n"
+           "-s                declare the filters of the chains from the sinks to the sources\n"
+           "-p                print the graph description and exit\n"
+           "-h                print this help\n");
+}
+
+static const char *const chain_filters[] = {
+    "format=yuv420p|yuv422p|yuv444p|nv12",
+    "hflip",
+    "setpts=PTS-STARTPTS",
+    "scale=160:90",
+    "format=yuv420p|yuv420p10le|gray",
+    "vflip",
+    "null",
+    "setsar=1",
+};
+
+static const char *const audio_filters[] = {
+    "aformat=sample_fmts=fltp|s16",
+    "volume=0.5",
+    "anull",
+    "aresample=44100",
+};
+
+static void print_chain(AVBPrint *bp, const char *src, const char *const *filters,
+                        int nb_filters, int chain_length, char type, int idx,
+                        int reverse)
+{
+    int j;
+
+    if (!reverse) {
+        av_bprintf(bp, "%s", src);
+        for (j = 0; j < chain_length; j++)
+            av_bprintf(bp, ",%s", filters[j % nb_filters]);
+        av_bprintf(bp, "[%c%d];", type, idx);
+        return;
+    }
+
+    /* one labeled segment per filter, the last one first */
+    for (j = chain_length - 1; j >= 0; j--) {
+        av_bprintf(bp, "[%c%d_%d]%s", type, idx, j, filters[j % nb_filters]);
+        if (j == chain_length - 1)
+            av_bprintf(bp, "[%c%d];", type, idx);
+        else
+            av_bprintf(bp, "[%c%d_%d];", type, idx, j + 1);
+    }
+    if (chain_length)
+        av_bprintf(bp, "%s[%c%d_0];", src, type, idx);
+    else
+        av_bprintf(bp, "%s[%c%d];", src, type, idx);
+}
+
+static void print_graph(AVBPrint *bp, int nb_inputs, int chain_length, int reverse)
+{
+    char src[64];
+    int i, cols;
+
+    for (cols = 1; cols * cols < nb_inputs; cols++);
+
+    for (i = 0; i < nb_inputs; i++) {
+        print_chain(bp, "testsrc=s=320x180:r=25,format=rgb24", chain_filters,
+                    FF_ARRAY_ELEMS(chain_filters), chain_length, 'v', i, reverse);
+
+        snprintf(src, sizeof(src), "sine=f=%d:r=48000", 220 + i);
+        print_chain(bp, src, audio_filters,
+                    FF_ARRAY_ELEMS(audio_filters), chain_length, 'a', i, reverse);
+    }
+
+    for (i = 0; i < nb_inputs; i++)
+        av_bprintf(bp, "[v%d]", i);
+    av_bprintf(bp, "xstack=inputs=%d:layout=", nb_inputs);
+    for (i = 0; i < nb_inputs; i++)
+        av_bprintf(bp, "%s%d_%d", i ? "|" : "", i % cols * 160, i / cols * 90);
+    av_bprintf(bp, ",format=yuv420p,buffersink;");
+
+    for (i = 0; i < nb_inputs; i++)
+        av_bprintf(bp, "[a%d]", i);
+    av_bprintf(bp, "amix=inputs=%d,abuffersink", nb_inputs);
+}
+
+int main(int argc, char **argv)
+{
+    int nb_inputs = 64, chain_length = 8, nb_runs = 10, reverse = 0, print = 0;
+    int64_t parse_time = 0, config_time = 0;
+    AVBPrint bp;
+    int c, i, ret;
+
+    while ((c = getopt(argc, argv, "n:c:r:sph")) != -1) {
+        switch (c) {
+        case 'n':
+            nb_inputs = atoi(optarg);
+            break;
+        case 'c':
+            chain_length = atoi(optarg);
+            break;
+        case 'r':
+            nb_runs = atoi(optarg);
+            break;
+        case 's':
+            reverse = 1;
+            break;
+        case 'p':
+            print = 1;
+            break;
+        case 'h':
+            usage();
+            return 0;
+        case '?':
+            return 1;
+        }
+    }
+
+    if (nb_inputs < 2 || chain_length < 0 || nb_runs < 1) {
+        usage();
+        return 1;
+    }
+
+    av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
+    print_graph(&bp, nb_inputs, chain_length, reverse);
+    if (!av_bprint_is_complete(&bp)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (print) {
+        printf("%s\n", bp.str);
+        av_bprint_finalize(&bp, NULL);
+        return 0;
+    }
+
+    for (i = 0; i < nb_runs; i++) {
+        AVFilterGraph *graph = avfilter_graph_alloc();
+        AVFilterInOut *inputs = NULL, *outputs = NULL;
+        int64_t t0, t1, t2;
+
+        if (!graph) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+
+        t0 = av_gettime_relative();
+        ret = avfilter_graph_parse2(graph, bp.str, &inputs, &outputs);
+        t1 = av_gettime_relative();
+        if (ret >= 0)
+            ret = avfilter_graph_config(graph, NULL);
+        t2 = av_gettime_relative();
+
+        avfilter_inout_free(&inputs);
+        avfilter_inout_free(&outputs);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to set up the graph: %s\n", av_err2str(ret));
+            avfilter_graph_free(&graph);
+            return 1;
+        }
+
+        if (!i)
+            printf("%d filters\n", graph->nb_filters);
+        avfilter_graph_free(&graph);
+
+        parse_time  += t1 - t0;
+        config_time += t2 - t1;
+    }
+
+    printf("parse:  %8.3f ms\n", parse_time  / 1000.0 / nb_runs);
+    printf("config: %8.3f ms\n", config_time / 1000.0 / nb_runs);
+
+    av_bprint_finalize(&bp, NULL);
+    return 0;
+}
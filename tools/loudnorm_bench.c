@@ -0,0 +1,226 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Benchmark the loudnorm filter, and so the EBU R128 measurement it is
+ * built on, on synthetic audio generated in memory before the timing.
+ */
+
+#include "config.h"
+#if HAVE_UNISTD_H
+#include <unistd.h>             /* getopt */
+#endif
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/frame.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+#define FRAME_SIZE 1024
+
+static void usage(void)
+{
+    printf("Benchmark the loudnorm filter.\n");
+    printf("Usage: loudnorm_bench [OPTIONS]\n");
+    printf("\n"
+           "Options:\n"
+           "-c LAYOUT         channel layout of the input, 5.1 if omitted\n"
+           "-d DURATION       duration of the input in seconds, 120 if omitted\n"
+           "-s RATE           sample rate of the input, 48000 if omitted\n"
+           "-a ARGS           arguments of the loudnorm filter, none if omitted\n"
+           "-r RUNS           number of times the input is filtered, 3 if omitted\n"
+           "-h                print this help\n");
+}
+
+/* noise with a different level and a tone on each channel */
+static AVFrame **generate_input(uint64_t layout, int sample_rate, int nb_frames)
+{
+    const int channels = av_get_channel_layout_nb_channels(layout);
+    AVFrame **frames = av_mallocz_array(nb_frames, sizeof(*frames));
+    unsigned seed = 1;
+    int64_t n = 0;
+    int i, j, c;
+
+    if (!frames)
+        return NULL;
+
+    for (i = 0; i < nb_frames; i++) {
+        AVFrame *frame = frames[i] = av_frame_alloc();
+        double *dst;
+
+        if (!frame)
+            return NULL;
+        frame->format         = AV_SAMPLE_FMT_DBL;
+        frame->channel_layout = layout;
+        frame->channels       = channels;
+        frame->sample_rate    = sample_rate;
+        frame->nb_samples     = FRAME_SIZE;
+        frame->pts            = n;
+        if (av_frame_get_buffer(frame, 0) < 0)
+            return NULL;
+
+        dst = (double *)frame->data[0];
+        for (j = 0; j < FRAME_SIZE; j++, n++) {
+            /* slow level changes give the gating and the LRA some work */
+            const double level = 0.1 + 0.05 * sin(2 * M_PI * n / (7.0 * sample_rate));
+
+            for (c = 0; c < channels; c++) {
+                seed = seed * 1664525 + 1013904223;
+                *dst++ = level / (c + 1) * ((int)seed / 2147483648.0) +
+                         0.1 * sin(2 * M_PI * (220.0 * (c + 1)) * n / sample_rate);
+            }
+        }
+    }
+
+    return frames;
+}
+
+static int run(AVFrame **frames, int nb_frames, uint64_t layout, int sample_rate,
+               const char *args, int64_t *samples_out)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *src, *loudnorm, *sink;
+    AVFrame *out = av_frame_alloc();
+    char src_args[256];
+    int i, ret;
+
+    *samples_out = 0;
+    if (!graph || !out) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+
+    snprintf(src_args, sizeof(src_args),
+             "sample_rate=%d:sample_fmt=dbl:channel_layout=0x%"PRIx64":time_base=1/%d",
+             sample_rate, layout, sample_rate);
+    if ((ret = avfilter_graph_create_filter(&src, avfilter_get_by_name("abuffer"),
+                                            "src", src_args, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(&loudnorm, avfilter_get_by_name("loudnorm"),
+                                            "loudnorm", args, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("abuffersink"),
+                                            "sink", NULL, NULL, graph)) < 0 ||
+        (ret = avfilter_link(src, 0, loudnorm, 0)) < 0 ||
+        (ret = avfilter_link(loudnorm, 0, sink, 0)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    for (i = 0; i <= nb_frames; i++) {
+        ret = av_buffersrc_add_frame_flags(src, i < nb_frames ? frames[i] : NULL,
+                                           AV_BUFFERSRC_FLAG_KEEP_REF);
+        if (ret < 0)
+            goto end;
+        while ((ret = av_buffersink_get_frame(sink, out)) >= 0) {
+            *samples_out += out->nb_samples;
+            av_frame_unref(out);
+        }
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    ret = 0;
+
+end:
+    av_frame_free(&out);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    const char *layout_name = "5.1", *args = NULL;
+    int sample_rate = 48000, nb_runs = 3, nb_frames, c, i, ret = 0;
+    double duration = 120, best = 0;
+    int64_t samples_out;
+    uint64_t layout;
+    AVFrame **frames;
+
+    while ((c = getopt(argc, argv, "c:d:s:a:r:h")) != -1) {
+        switch (c) {
+        case 'c':
+            layout_name = optarg;
+            break;
+        case 'd':
+            duration = atof(optarg);
+            break;
+        case 's':
+            sample_rate = atoi(optarg);
+            break;
+        case 'a':
+            args = optarg;
+            break;
+        case 'r':
+            nb_runs = atoi(optarg);
+            break;
+        case 'h':
+            usage();
+            return 0;
+        case '?':
+            return 1;
+        }
+    }
+
+    layout    = av_get_channel_layout(layout_name);
+    nb_frames = duration * sample_rate / FRAME_SIZE;
+    if (!layout || sample_rate <= 0 || nb_frames < 1 || nb_runs < 1) {
+        usage();
+        return 1;
+    }
+
+    frames = generate_input(layout, sample_rate, nb_frames);
+    if (!frames) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (i = 0; i < nb_runs; i++) {
+        int64_t t0 = av_gettime_relative(), t;
+
+        ret = run(frames, nb_frames, layout, sample_rate, args, &samples_out);
+        if (ret < 0) {
+            fprintf(stderr, "Failed to run the filter: %s\n", av_err2str(ret));
+            break;
+        }
+        t = av_gettime_relative() - t0;
+        if (!i || t < best)
+            best = t;
+    }
+
+    if (ret >= 0) {
+        const double input = (double)nb_frames * FRAME_SIZE / sample_rate;
+
+        printf("%d channels, %.1f s of input, %"PRId64" samples out\n",
+               av_get_channel_layout_nb_channels(layout), input, samples_out);
+        printf("best of %d: %8.3f s, %.1fx realtime\n",
+               nb_runs, best / 1000000.0, input * 1000000.0 / best);
+    }
+
+    for (i = 0; i < nb_frames; i++)
+        av_frame_free(&frames[i]);
+    av_free(frames);
+    return ret < 0;
+}